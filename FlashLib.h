@@ -1,54 +1,78 @@
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*                        Copyright (c) James Pearman                          */
-/*                                 2013-2014                                   */
-/*                            All Rights Reserved                              */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    Module:     FlashLib.c                                                   */
-/*    Author:     James Pearman                                                */
-/*    Created:    23 Feb 2013                                                  */
-/*                                                                             */
-/*    Revisions:                                                               */
-/*                V1.00     7 Jan 2014 - Initial release                       */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    The author is supplying this software for use with the VEX cortex        */
-/*    control system. this is free software; you can redistribute it           */
-/*    and/or modify it under the terms of the GNU General Public License       */
-/*    as published by the Free Software Foundation; either version 3 of        */
-/*    the License, or (at your option) any later version.                      */
-/*                                                                             */
-/*    This software is distributed in the hope that it will be useful,         */
-/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
-/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
-/*    GNU General Public License for more details.                             */
-/*                                                                             */
-/*    You should have received a copy of the GNU General Public License        */
-/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
-/*                                                                             */
-/*    The author can be contacted on the vex forums as jpearman                */
-/*    or electronic mail using jbpearman_at_mac_dot_com                        */
-/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-
-#ifndef __FLASHLIB__
-#define __FLASHLIB__
-
-#include <FirmwareVersion.h>
-
-#include <stm32_flash.c>
-
-// These are other flash related libraries that I may release later
-// (well, user_param I think may have been released before but it's
-// not included here)
-//
-#include <flash_user.c>
-//#include <flash_ram.c>
-
-#include <flash_rcfs.c>
-
-#endif // __FLASHLIB__
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                 2013-2014                                   */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     FlashLib.c                                                   */
+/*    Author:     James Pearman                                                */
+/*    Created:    23 Feb 2013                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00     7 Jan 2014 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Add flash_queue.c                     */
+/*                V1.02    17 Oct 2026 - Add flash_log.c                       */
+/*                V1.03    17 Oct 2026 - Add flash_telem.c                     */
+/*                V1.04    17 Oct 2026 - Add flash_replay.c                    */
+/*                V1.05    17 Oct 2026 - Add flash_export.c                    */
+/*                V1.06    17 Oct 2026 - Add flash_ring.c                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#ifndef __FLASHLIB__
+#define __FLASHLIB__
+
+#include <FirmwareVersion.h>
+
+#include <stm32_flash.c>
+
+// These are other flash related libraries that I may release later
+// (well, user_param I think may have been released before but it's
+// not included here)
+//
+#include <flash_user.c>
+//#include <flash_ram.c>
+
+#include <flash_rcfs.c>
+
+// Circular log at the end of the file system, needs RCFS_LOG_PAGES
+#include <flash_log.c>
+
+// Compact sensor logs written with the RCFS streaming writer
+#include <flash_telem.c>
+
+// Record and replay driver control
+#include <flash_replay.c>
+
+// Log control loop samples from a logger task
+#include <flash_ring.c>
+
+// Background writes for the above
+#include <flash_queue.c>
+
+// Send files over the debug stream, host/rcfs_receive rebuilds them
+#include <flash_export.c>
+
+#endif // __FLASHLIB__
@@ -0,0 +1,452 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_export.c                                               */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Report files that cannot be read      */
+/*                V1.02    17 Oct 2026 - Build without -w                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    Send RCFS files and the user parameter pages over the debug stream as    */
+/*    framed base64 lines, host/rcfs_receive rebuilds the files from a         */
+/*    capture of the debug window                                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_export.c
+  * @brief   Binary export over the debug stream
+*//*---------------------------------------------------------------------------*/
+/** @details
+ *  Each frame is one line, a ':' followed by the base64 encoding of the
+ *  frame type, a 16 bit sequence number, the payload length, the payload
+ *  and a CRC32 of everything before it.  Lines that do not start with ':'
+ *  are ignored by the receiver so other debug output can be mixed in.
+ *
+ *  An export is a 'B' frame, then for each file an 'F' frame with the type
+ *  and name, 'D' frames with the offset and up to RCFS_EXPORT_CHUNK bytes of
+ *  data and a 'C' frame with the length and CRC32 of the data, then an 'E'
+ *  frame with the number of files.  The sequence number starts at 0 with the
+ *  'B' frame so the receiver can tell when frames were lost.  Compressed
+ *  files are sent uncompressed.
+ *
+ *  ROBOTC does not say how full the debug stream buffer is, so the level is
+ *  estimated from the characters written and the rate the PC empties it.
+ *  The export only waits when the next line would not fit, rather than a
+ *  fixed time for every line.  Measure the rate for the link in use, the
+ *  defaults are for the programming cable.
+ */
+
+// Debug stream buffer size in characters, can be overridden in user code
+#ifndef RCFS_EXPORT_BUFFER
+#define RCFS_EXPORT_BUFFER      1024
+#endif
+
+// Characters per mS the PC reads from the debug stream
+#ifndef RCFS_EXPORT_RATE
+#define RCFS_EXPORT_RATE        4
+#endif
+
+// Data bytes in each 'D' frame, a multiple of 3 keeps the lines short
+#ifndef RCFS_EXPORT_CHUNK
+#define RCFS_EXPORT_CHUNK       48
+#endif
+
+/** @cond    */
+#define RCFS_EXPORT_VERSION     1
+
+// frame type, sequence and length before the payload, CRC after it
+#define RCFS_EXPORT_OVERHEAD    8
+#define RCFS_EXPORT_FRAME       (RCFS_EXPORT_OVERHEAD + 4 + RCFS_EXPORT_CHUNK)
+#define RCFS_EXPORT_LINE        (((RCFS_EXPORT_FRAME + 2) / 3) * 4 + 4)
+
+// Compressed files are read a few frames at a time
+#define RCFS_EXPORT_BLOCK       (RCFS_EXPORT_CHUNK * 8)
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   State of the export in progress                                   */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_export {
+    unsigned short seq;                    ///< sequence number of next frame
+             long  level;                  ///< estimated characters buffered
+             long  time;                   ///< nSysTime of the estimate
+             long  frames;                 ///< frames sent
+             long  chars;                  ///< characters sent
+             long  bytes;                  ///< file data sent
+             long  waits;                  ///< mS spent waiting for the PC
+             int   failed;                 ///< files that could not be read
+    unsigned char  frame[RCFS_EXPORT_FRAME];
+             char  line[RCFS_EXPORT_LINE];
+    } rcfs_export;
+
+static  rcfs_export xfer;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the base64 character for 6 bits                             */
+/** @param[in] v value 0 to 63                                                 */
+/*-----------------------------------------------------------------------------*/
+
+static char
+RCFS_ExportB64( int v )
+{
+    if( v < 26 )
+        return( 'A' + v );
+    if( v < 52 )
+        return( 'a' + v - 26 );
+    if( v < 62 )
+        return( '0' + v - 52 );
+
+    return( (v == 62) ? '+' : '/' );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Wait until the debug stream has room for a line                 */
+/** @param[in] n number of characters in the line                              */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ExportWait( int n )
+{
+    long  now;
+
+    for(;;)
+        {
+        // what the PC has read since the last line
+        now = nSysTime;
+        xfer.level -= (now - xfer.time) * RCFS_EXPORT_RATE;
+        if( xfer.level < 0 )
+            xfer.level = 0;
+        xfer.time = now;
+
+        if( (xfer.level + n) <= RCFS_EXPORT_BUFFER )
+            break;
+
+        wait1Msec(1);
+        xfer.waits++;
+        }
+
+    xfer.level += n;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Send a frame                                                    */
+/** @param[in] type the frame type                                             */
+/** @param[in] length number of payload bytes already in xfer.frame          */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ExportFrame( char type, int length )
+{
+    unsigned long crc;
+    unsigned char *p = xfer.frame;
+    long  v;
+    int   i, n, c;
+
+    p[0] = type;
+    p[1] = xfer.seq & 0xFF;
+    p[2] = xfer.seq >> 8;
+    p[3] = length;
+
+    n = 4 + length;
+    crc = ~RCFS_Crc32( 0xFFFFFFFF, p, n );
+    for(i=0;i<4;i++)
+        {
+        p[n++] = crc & 0xFF;
+        crc >>= 8;
+        }
+
+    // base64, padded to a multiple of 4 characters
+    c = 0;
+    for(i=0;i<n;i+=3)
+        {
+        v = (long)p[i] << 16;
+        if( (i + 1) < n )
+            v |= (long)p[i+1] << 8;
+        if( (i + 2) < n )
+            v |= p[i+2];
+
+        xfer.line[c++] = RCFS_ExportB64( (v >> 18) & 0x3F );
+        xfer.line[c++] = RCFS_ExportB64( (v >> 12) & 0x3F );
+        xfer.line[c++] = ((i + 1) < n) ? RCFS_ExportB64( (v >> 6) & 0x3F ) : '=';
+        xfer.line[c++] = ((i + 2) < n) ? RCFS_ExportB64( v & 0x3F )        : '=';
+        }
+    xfer.line[c] = 0;
+
+    // ':' and the newline
+    RCFS_ExportWait( c + 2 );
+    writeDebugStreamLine(":%s", xfer.line);
+
+    xfer.seq++;
+    xfer.frames++;
+    xfer.chars += c + 2;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Put a little endian long in the frame payload                   */
+/** @param[in] offset offset in the payload                                    */
+/** @param[in] v the value                                                     */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ExportLong( int offset, unsigned long v )
+{
+    int   i;
+
+    for(i=0;i<4;i++)
+        {
+        xfer.frame[4 + offset + i] = v & 0xFF;
+        v >>= 8;
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start an export                                                 */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ExportBegin()
+{
+    xfer.seq    = 0;
+    xfer.level  = 0;
+    xfer.time   = nSysTime;
+    xfer.frames = 0;
+    xfer.chars  = 0;
+    xfer.bytes  = 0;
+    xfer.waits  = 0;
+    xfer.failed = 0;
+
+    xfer.frame[4] = RCFS_EXPORT_VERSION;
+    RCFS_ExportFrame( 'B', 1 );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     End an export                                                   */
+/** @param[in] files number of files sent                                      */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ExportEnd( int files )
+{
+    xfer.frame[4] = files & 0xFF;
+    xfer.frame[5] = files >> 8;
+    RCFS_ExportFrame( 'E', 2 );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Send one file                                                   */
+/** @param[in] f the file header                                               */
+/** @returns   The number of bytes sent or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A file that fails its CRC or cannot be read to its full length ends
+ *  with a 'C' frame of length 0xFFFFFFFF, the receiver then reports it as
+ *  a read error instead of saving it.  The data of a file that fails its
+ *  CRC is not sent.
+ */
+
+static long
+RCFS_ExportData( flash_file *f )
+{
+    static unsigned char block[RCFS_EXPORT_BLOCK];
+    unsigned long crc = 0xFFFFFFFF;
+    long  offset = 0;
+    long  expect;
+    short bad;
+    int   i, n, k, len;
+
+    // type and name
+    xfer.frame[4] = f->type;
+    for(n=0;(n < 16) && (f->name[n] != 0);n++)
+        xfer.frame[5 + n] = f->name[n];
+    RCFS_ExportFrame( 'F', 1 + n );
+
+    bad = (RCFS_VerifyFile( f ) == RCFS_CRC_ERROR);
+
+    // the length the reads must add up to, a compressed file that was
+    // never closed has no length
+    expect = f->datalength;
+#ifdef RCFS_COMPRESS
+    if( RCFS_FileFlags( f ) & RCFS_FILE_LZ )
+        {
+        expect = f->pad[0] + ((long)f->pad[1] * 256);
+        if( expect == 0xFFFF )
+            expect = -1;
+        }
+#endif
+
+    // a short read is the end of the file
+    for(n=RCFS_EXPORT_BLOCK;!bad && (n == RCFS_EXPORT_BLOCK);)
+        {
+        n = RCFS_ReadData( f, block, offset, RCFS_EXPORT_BLOCK );
+        if( n <= 0 )
+            {
+            bad = (n < 0);
+            break;
+            }
+
+        crc = RCFS_Crc32( crc, block, n );
+
+        for(k=0;k<n;k+=len)
+            {
+            len = n - k;
+            if( len > RCFS_EXPORT_CHUNK )
+                len = RCFS_EXPORT_CHUNK;
+
+            RCFS_ExportLong( 0, offset + k );
+            for(i=0;i<len;i++)
+                xfer.frame[8 + i] = block[k + i];
+            RCFS_ExportFrame( 'D', 4 + len );
+            }
+
+        offset += n;
+        xfer.bytes += n;
+        }
+
+    if( (expect >= 0) && (offset != expect) )
+        bad = 1;
+
+    if( bad )
+        {
+        // no file has this length
+        RCFS_ExportLong( 0, 0xFFFFFFFF );
+        RCFS_ExportLong( 4, 0 );
+        RCFS_ExportFrame( 'C', 8 );
+        xfer.failed++;
+        return(RCFS_ERROR);
+        }
+
+    RCFS_ExportLong( 0, offset );
+    RCFS_ExportLong( 4, ~crc );
+    RCFS_ExportFrame( 'C', 8 );
+
+    return(offset);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Export one file                                                 */
+/** @param[in] name the name of the file                                       */
+/** @returns   The number of bytes sent or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+
+long
+RCFS_ExportFile( char *name )
+{
+    flash_file  f;
+    long  n;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_FindFile( name, &f ) < 0 )
+        return(RCFS_ERROR);
+
+    RCFS_ExportBegin();
+    n = RCFS_ExportData( &f );
+    RCFS_ExportEnd( 1 );
+
+    return(n);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Export every file                                               */
+/** @returns   The number of files sent or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A file that cannot be read does not stop the export, the number of
+ *  them is written to the debug stream and RCFS_ERROR is returned.
+ */
+
+int
+RCFS_ExportAll()
+{
+    flash_file  f;
+    rcfs_dir    d;
+    int   files = 0;
+
+    if( RCFS_DirOpen( &d ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    RCFS_ExportBegin();
+
+    while( RCFS_DirNext( &d, &f ) >= 0 )
+        {
+        RCFS_ExportData( &f );
+        files++;
+        }
+
+    RCFS_DirClose( &d );
+
+    RCFS_ExportEnd( files );
+
+    if( xfer.failed != 0 )
+        {
+        writeDebugStreamLine("export: %d of %d files could not be read", xfer.failed, files );
+        return(RCFS_ERROR);
+        }
+
+    return(files);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Export the user parameter pages                                 */
+/** @returns   The number of bytes sent                                        */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Sent as a file called "user", FlashUserDebug takes over 3 seconds for
+ *  each page as it waits 25mS for every 16 bytes.
+ */
+
+long
+FlashUserExport()
+{
+    flash_file  f;
+    long  n;
+
+    // a file that RCFS_ReadData reads as plain data
+    RCFS_FileInit( &f );
+    strncpy( (char *)&f.name[0], "user", 15 );
+    f.addr       = __FLASH_USER_BASE_ADDR;
+    f.data       = (unsigned char *)__FLASH_USER_BASE_ADDR;
+    f.datalength = FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES;
+
+    RCFS_ExportBegin();
+    n = RCFS_ExportData( &f );
+    RCFS_ExportEnd( 1 );
+
+    return(n);
+}
@@ -0,0 +1,496 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_log.c                                                  */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Fail when the flash cannot be unlocked*/
+/*                V1.02    17 Oct 2026 - Keep writing after a torn record      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    A circular log in pages at the end of the RCFS data region, when the     */
+/*    log is full the oldest page is erased and reused                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_log.c
+  * @brief   Circular log
+*//*---------------------------------------------------------------------------*/
+
+// Define RCFS_LOG_PAGES in user code before including FlashLib.h to use the
+// log, flash_rcfs.c then stops files at RCFS_LOG_OFFSET.  At least 2 pages.
+#ifdef RCFS_LOG_PAGES
+
+/** @cond    */
+// Each page starts with a sequence number followed by the magic, the magic
+// is programmed last so the sequence number of a valid page is always good
+#define RCFS_LOG_MAGIC          0x474F4C52
+#define RCFS_LOG_HEADER_SIZE    8
+
+// A record is a half word length and then the data padded to a half word,
+// the length is programmed after the data.  Records do not cross pages.
+#define RCFS_LOG_RECORD_MAX     (RCFS_PAGE_SIZE - RCFS_LOG_HEADER_SIZE - 2)
+
+// A record that lost power before its length was programmed is given this
+// bit and the number of bytes it used as its length, readers step over it
+#define RCFS_LOG_SKIP           0x8000
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Write position in the log                                         */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_log {
+             short valid;                  ///< pages have been scanned
+             short ready;                  ///< page after the head is erased
+             short head;                   ///< page being written
+             int   offset;                 ///< next record in the head page
+    unsigned long  seq;                    ///< sequence number of the head page
+    } rcfs_log;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Read position in the log                                          */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_log_cursor {
+             short page;                   ///< page being read
+             short count;                  ///< pages read so far
+             int   offset;                 ///< next record in the page
+    } rcfs_log_cursor;
+
+static  rcfs_log    log_state;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Offset of a log page from the start of the file system          */
+/** @param[in] page page number in the log                                     */
+/*-----------------------------------------------------------------------------*/
+
+static long
+RCFS_LogPageOffset( int page )
+{
+    return( RCFS_LOG_OFFSET + ((long)page * RCFS_PAGE_SIZE) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check for a valid page header                                   */
+/** @param[in] page page number in the log                                     */
+/** @param[out] seq sequence number of the page                                */
+/** @returns   1 if the page has been started                                  */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_LogPageValid( int page, unsigned long *seq )
+{
+    unsigned long *p;
+
+    long tmp = baseaddr + RCFS_LogPageOffset( page );
+    p = (unsigned long *)tmp;
+
+    if( p[1] != RCFS_LOG_MAGIC )
+        return(0);
+
+    *seq = p[0];
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the end of the records in a page                           */
+/** @param[in] page page number in the log                                     */
+/** @param[out] torn bytes of data after the last record                       */
+/** @returns   offset of the first free half word or -1                        */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Data after the last record is what is left when power is lost while
+ *  writing a record, its length is never programmed.  -1 is returned if a
+ *  record is damaged.
+ */
+
+static int
+RCFS_LogPageEnd( int page, int *torn )
+{
+    unsigned short *p;
+    unsigned short  length;
+    int   offset;
+    int   size;
+    int   i;
+
+    long tmp = baseaddr + RCFS_LogPageOffset( page );
+    p = (unsigned short *)tmp;
+
+    *torn = 0;
+
+    for(offset=RCFS_LOG_HEADER_SIZE;offset<RCFS_PAGE_SIZE;)
+        {
+        length = p[offset/2];
+        if( length == 0xFFFF )
+            break;
+
+        // a record that lost power is stepped over
+        if( length & RCFS_LOG_SKIP )
+            size = length & ~RCFS_LOG_SKIP;
+        else
+        if( (length != 0) && (length <= RCFS_LOG_RECORD_MAX) )
+            size = (length + 1) & ~1;
+        else
+            return(-1);
+
+        if( (size == 0) || (size & 1) )
+            return(-1);
+
+        offset += 2 + size;
+        if( offset > RCFS_PAGE_SIZE )
+            return(-1);
+        }
+
+    // the last half word that is not erased
+    for(i=(RCFS_PAGE_SIZE/2)-1;i>(offset/2);i--)
+        {
+        if( p[i] != 0xFFFF )
+            {
+            *torn = (i * 2) - offset;
+            break;
+            }
+        }
+
+    return(offset);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Make a page the head of the log                                 */
+/** @param[in] page page number in the log                                     */
+/** @param[in] seq sequence number for the page                                */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The page is only erased here if RCFS_LogService has not already done it,
+ *  any records in it were the oldest in the log.
+ */
+
+static int
+RCFS_LogStartPage( int page, unsigned long seq )
+{
+    long  offset = RCFS_LogPageOffset( page );
+
+    log_state.valid = 0;
+
+    if( !log_state.ready && (RCFS_ErasePage( offset ) != RCFS_SUCCESS) )
+        return(RCFS_ERROR);
+
+    if( (FLASH_ProgramWord( baseaddr + offset, seq ) != FLASH_COMPLETE) ||
+        (FLASH_ProgramWord( baseaddr + offset + 4, RCFS_LOG_MAGIC ) != FLASH_COMPLETE) )
+        return(RCFS_ERROR);
+
+    log_state.head   = page;
+    log_state.seq    = seq;
+    log_state.offset = RCFS_LOG_HEADER_SIZE;
+    log_state.ready  = 0;
+    log_state.valid  = 1;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the head of the log                                        */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The page with the highest sequence number is the head, one read of each
+ *  page header and then the records in the head page.  A record that lost
+ *  power is marked to be skipped and writing carries on after it, writing
+ *  carries on in the next page if the head page was damaged.
+ */
+
+static int
+RCFS_LogScan()
+{
+    unsigned long seq;
+    unsigned long best = 0;
+    int   head = -1;
+    int   page;
+    int   offset;
+    int   torn;
+
+    for(page=0;page<RCFS_LOG_PAGES;page++)
+        {
+        if( !RCFS_LogPageValid( page, &seq ) )
+            continue;
+
+        // sequence numbers may wrap
+        if( (head < 0) || ((long)(seq - best) > 0) )
+            {
+            head = page;
+            best = seq;
+            }
+        }
+
+    log_state.ready = 0;
+
+    // empty log
+    if( head < 0 )
+        return( RCFS_LogStartPage( 0, 0 ) );
+
+    offset = RCFS_LogPageEnd( head, &torn );
+    if( offset < 0 )
+        return( RCFS_LogStartPage( (head + 1) % RCFS_LOG_PAGES, best + 1 ) );
+
+    // the rest of the page is still used
+    if( torn > 0 )
+        {
+        if( FLASH_ProgramHalfWord( baseaddr + RCFS_LogPageOffset( head ) + offset, RCFS_LOG_SKIP | torn ) != FLASH_COMPLETE )
+            return( RCFS_LogStartPage( (head + 1) % RCFS_LOG_PAGES, best + 1 ) );
+        offset += 2 + torn;
+        }
+
+    log_state.head   = head;
+    log_state.seq    = best;
+    log_state.offset = offset;
+    log_state.valid  = 1;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a record to the log                                         */
+/** @param[in] data pointer to the record                                      */
+/** @param[in] length length of the record in bytes                            */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Records can be up to RCFS_LOG_RECORD_MAX bytes.  When a record does not
+ *  fit in the head page the log moves on to the next page, that page is
+ *  erased first unless RCFS_LogService has already done so.  Only
+ *  RCFS_LogService erases ahead, without it the write that moves to a new
+ *  page also waits for the erase.  A record that was being written when
+ *  power was lost is not seen when reading the log.
+ */
+
+int
+RCFS_LogWrite( unsigned char *data, int length )
+{
+    unsigned short *q;
+    unsigned short  b;
+    long  addr;
+    long  dest;
+    int   remaining;
+    int   chunk;
+    uint32_t failaddr;
+
+    if( (data == NULL) || (length <= 0) || (length > RCFS_LOG_RECORD_MAX) )
+        return(RCFS_ERROR);
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    if( !log_state.valid && (RCFS_LogScan() != RCFS_SUCCESS) )
+        return(RCFS_ERROR);
+
+    // on to the next page if there is no room
+    if( (log_state.offset + 2 + ((length + 1) & ~1)) > RCFS_PAGE_SIZE )
+        {
+        if( RCFS_LogStartPage( (log_state.head + 1) % RCFS_LOG_PAGES, log_state.seq + 1 ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    addr = baseaddr + RCFS_LogPageOffset( log_state.head ) + log_state.offset;
+
+    // rescan if anything fails
+    log_state.valid = 0;
+
+    // data first, in blocks of 128 half words with a timeslice abort between each
+    q = (unsigned short *)data;
+    dest = addr + 2;
+    remaining = length / 2;
+    while( remaining > 0 )
+        {
+        chunk = (remaining > 128) ? 128 : remaining;
+
+        if( FLASH_ProgramBuffer( dest, q, chunk, &failaddr ) != FLASH_COMPLETE )
+            return(RCFS_ERROR);
+        q    += chunk;
+        dest += chunk * 2;
+        remaining -= chunk;
+
+        abortTimeslice();
+        }
+
+    // pad an odd byte with 0xFF
+    if( (length & 1) == 1 )
+        {
+        b = data[length-1] | 0xFF00;
+        if( FLASH_ProgramHalfWord( dest, b ) != FLASH_COMPLETE )
+            return(RCFS_ERROR);
+        }
+
+    // the record is there once it has a length
+    if( FLASH_ProgramHalfWord( addr, length ) != FLASH_COMPLETE )
+        return(RCFS_ERROR);
+
+    log_state.offset += 2 + ((length + 1) & ~1);
+    log_state.valid = 1;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Erase the page after the head of the log                        */
+/** @returns   1 if a page was erased, 0 if there was nothing to do            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this when there is time to spare, for example just after
+ *  RCFS_LogWrite, so that the next page change does not wait for an erase.
+ *  It must be called from the same task as RCFS_LogWrite.  The oldest page
+ *  of records is lost when it is erased.
+ */
+
+int
+RCFS_LogService()
+{
+    if( !log_state.valid || log_state.ready )
+        return(0);
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(0);
+
+    if( RCFS_ErasePage( RCFS_LogPageOffset( (log_state.head + 1) % RCFS_LOG_PAGES ) ) != RCFS_SUCCESS )
+        return(0);
+
+    log_state.ready = 1;
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Erase the whole log                                             */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_LogErase()
+{
+    int   page;
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    log_state.valid = 0;
+
+    for(page=0;page<RCFS_LOG_PAGES;page++)
+        {
+        if( RCFS_ErasePage( RCFS_LogPageOffset( page ) ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start reading the log from the oldest record                    */
+/** @param[out] c the read position                                            */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_LogFirst( rcfs_log_cursor *c )
+{
+    if( !log_state.valid )
+        {
+        if( RCFS_Unlock() != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+
+        if( RCFS_LogScan() != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    // the page after the head is the oldest unless it has been erased
+    c->page   = (log_state.head + 1) % RCFS_LOG_PAGES;
+    c->count  = 0;
+    c->offset = RCFS_LOG_HEADER_SIZE;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read the next record from the log                               */
+/** @param[in] c the read position                                             */
+/** @param[out] data pointer to the record in flash                            */
+/** @param[out] length length of the record in bytes                           */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR when there are no more records       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Records are returned oldest first, the data pointer is only good until
+ *  the log next changes page.
+ */
+
+int
+RCFS_LogNext( rcfs_log_cursor *c, unsigned char **data, int *length )
+{
+    unsigned short *p;
+    unsigned short  n;
+    unsigned long   seq;
+
+    while( c->count < RCFS_LOG_PAGES )
+        {
+        if( RCFS_LogPageValid( c->page, &seq ) && (c->offset < RCFS_PAGE_SIZE) )
+            {
+            long tmp = baseaddr + RCFS_LogPageOffset( c->page ) + c->offset;
+            p = (unsigned short *)tmp;
+            n = *p;
+
+            // a record that lost power
+            if( (n != 0xFFFF) && (n & RCFS_LOG_SKIP) )
+                {
+                c->offset += 2 + (n & ~RCFS_LOG_SKIP);
+                continue;
+                }
+
+            if( (n != 0xFFFF) && (n != 0) && (n <= RCFS_LOG_RECORD_MAX) &&
+                ((c->offset + 2 + ((n + 1) & ~1)) <= RCFS_PAGE_SIZE) )
+                {
+                *data   = (unsigned char *)(p + 1);
+                *length = n;
+                c->offset += 2 + ((n + 1) & ~1);
+                return(RCFS_SUCCESS);
+                }
+            }
+
+        // on to the next page
+        c->page   = (c->page + 1) % RCFS_LOG_PAGES;
+        c->count++;
+        c->offset = RCFS_LOG_HEADER_SIZE;
+        }
+
+    return(RCFS_ERROR);
+}
+
+#endif  // RCFS_LOG_PAGES
@@ -0,0 +1,385 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_queue.c                                                */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Skip a slice when the flash is locked */
+/*                V1.02    17 Oct 2026 - Use FLASH_HogCPU                      */
+/*                V1.03    17 Oct 2026 - Abandon a stream that won't close     */
+/*                V1.04    17 Oct 2026 - Delete a queued file that fails       */
+/*                V1.05    17 Oct 2026 - Use FLASH_MutexHeld                   */
+/*                V1.06    17 Oct 2026 - Build without -w                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    Queue file and user parameter writes and program them from a low        */
+/*    priority task a few bytes at a time                                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_queue.c
+  * @brief   Background flash writes
+*//*---------------------------------------------------------------------------*/
+
+// Number of requests that can be queued, can be overridden in user code
+#ifndef FLASH_QUEUE_SIZE
+#define FLASH_QUEUE_SIZE        4
+#endif
+
+// Default number of bytes programmed in each time slice, each byte
+// takes about 26uS so 64 bytes is less than 2mS
+#ifndef FLASH_QUEUE_SLICE_BYTES
+#define FLASH_QUEUE_SLICE_BYTES 64
+#endif
+
+// Priority of the writer task
+#ifndef FLASH_QUEUE_PRIORITY
+#define FLASH_QUEUE_PRIORITY    kLowPriority
+#endif
+
+// How long the writer task sleeps when there is nothing to do
+#define FLASH_QUEUE_IDLE_WAIT   5
+
+// Request types
+#define FLASH_REQ_FILE          1
+#define FLASH_REQ_USER          2
+
+// Request status, errors are negative
+#define FLASH_REQ_DONE          0
+#define FLASH_REQ_PENDING       1
+#define FLASH_REQ_ACTIVE        2
+
+// Queue errors
+#define FLASH_ERROR_QUEUE_FULL  (-5)
+#define FLASH_ERROR_HANDLE      (-6)
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   A queued write                                                    */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_request {
+             short id;                     ///< handle, 0 if never used
+             short type;                   ///< file or user parameters
+             short status;                 ///< pending, active, done or error
+             short h;                      ///< RCFS stream handle
+             char  name[16];               ///< file name
+    unsigned char *data;                   ///< file data
+             int   length;                 ///< file length in bytes
+             int   done;                   ///< bytes written so far
+    flash_user     user;                   ///< copy of the user parameters
+    } flash_request;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The write queue                                                   */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_queue {
+             short head;                   ///< next free request
+             short tail;                   ///< request being written
+             short nextid;                 ///< handle for the next request
+             int   budget;                 ///< bytes programmed per slice, 0 for default
+    flash_request  req[FLASH_QUEUE_SIZE];
+    } flash_queue;
+
+static  flash_queue write_queue;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the next free request                                       */
+/** @returns   A pointer to the request or NULL if the queue is full           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Called with the CPU held, the request is given a new handle.
+ */
+
+static flash_request *
+FlashQueueAlloc()
+{
+    flash_request *r = &write_queue.req[ write_queue.head ];
+
+    // oldest request has not been written yet
+    if( (r->status == FLASH_REQ_PENDING) || (r->status == FLASH_REQ_ACTIVE) )
+        return(NULL);
+
+    // handles start at 1
+    if( write_queue.nextid <= 0 )
+        write_queue.nextid = 1;
+    r->id = write_queue.nextid++;
+
+    if( ++write_queue.head >= FLASH_QUEUE_SIZE )
+        write_queue.head = 0;
+
+    return(r);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Queue a file write                                              */
+/** @param[in] data pointer to the data to be written                          */
+/** @param[in] length length of data in bytes                                  */
+/** @param[in] name name of the file to be written                             */
+/** @returns   A handle for the request or an error code                       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The data is not copied, it must not change until FlashQueueStatus returns
+ *  FLASH_REQ_DONE or an error.  The file is written with the RCFS streaming
+ *  writer so RCFS_AddFile and RCFS_OpenWrite fail while it is active.
+ */
+
+int
+FlashQueueFile( unsigned char *data, int length, char *name )
+{
+    flash_request *r;
+
+    if( (data == NULL) || (name == NULL) || (length <= 0) )
+        return(FLASH_ERROR_WRITE);
+
+    FLASH_HogCPU();
+
+    r = FlashQueueAlloc();
+    if( r == NULL )
+        {
+        FLASH_ReleaseCPU();
+        return(FLASH_ERROR_QUEUE_FULL);
+        }
+
+    r->type   = FLASH_REQ_FILE;
+    r->data   = data;
+    r->length = length;
+    r->done   = 0;
+    r->h      = RCFS_ERROR;
+    strncpy( r->name, name, 15 );
+    r->name[15] = 0;
+
+    // writer task can now see it
+    r->status = FLASH_REQ_PENDING;
+
+    FLASH_ReleaseCPU();
+
+    return(r->id);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Queue a user parameter write                                    */
+/** @param[in] u Pointer to user_param structure                               */
+/** @returns   A handle for the request or an error code                       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The parameters are copied so u can be changed as soon as this returns.
+ */
+
+int
+FlashQueueUser( flash_user *u )
+{
+    flash_request *r;
+    int     i;
+
+    if( u == NULL )
+        return(FLASH_ERROR_WRITE);
+
+    FLASH_HogCPU();
+
+    r = FlashQueueAlloc();
+    if( r == NULL )
+        {
+        FLASH_ReleaseCPU();
+        return(FLASH_ERROR_QUEUE_FULL);
+        }
+
+    r->type = FLASH_REQ_USER;
+    for(i=0;i<(int)(FLASH_USER_SIZE * sizeof(uint32_t));i++)
+        r->user.data[i] = u->data[i];
+
+    // writer task can now see it
+    r->status = FLASH_REQ_PENDING;
+
+    FLASH_ReleaseCPU();
+
+    return(r->id);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the status of a queued write                                */
+/** @param[in] handle the handle returned when the write was queued            */
+/** @returns   FLASH_REQ_PENDING, FLASH_REQ_ACTIVE, FLASH_REQ_DONE or an error */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The status is kept until the request is reused, FLASH_QUEUE_SIZE requests
+ *  later.  After that FLASH_ERROR_HANDLE is returned.
+ */
+
+int
+FlashQueueStatus( int handle )
+{
+    int     i;
+
+    if( handle <= 0 )
+        return(FLASH_ERROR_HANDLE);
+
+    for(i=0;i<FLASH_QUEUE_SIZE;i++)
+        {
+        if( write_queue.req[i].id == handle )
+            return( write_queue.req[i].status );
+        }
+
+    return(FLASH_ERROR_HANDLE);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Set the number of bytes programmed in each time slice           */
+/** @param[in] bytes the budget, rounded up to a whole half word               */
+/*-----------------------------------------------------------------------------*/
+
+void
+FlashQueueSetBudget( int bytes )
+{
+    if( bytes < 2 )
+        bytes = 2;
+
+    write_queue.budget = (bytes + 1) & ~1;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Do one time slice of queued writes                              */
+/** @returns   1 if there is more work to do, 0 if the queue is empty          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  At most the budget of file data is programmed, a user parameter write is
+ *  done in one slice.  This is called by FlashQueueTask, it can also be
+ *  called from user code that does not want another task.
+ */
+
+int
+FlashQueueService()
+{
+    flash_request *r = &write_queue.req[ write_queue.tail ];
+    int     budget = write_queue.budget;
+    int     n;
+    int     ret;
+
+    if( budget == 0 )
+        budget = FLASH_QUEUE_SLICE_BYTES;
+
+    if( (r->status != FLASH_REQ_PENDING) && (r->status != FLASH_REQ_ACTIVE) )
+        return(0);
+
+    // another task is using the flash controller, try again next slice
+    // rather than wait for it
+    if( FLASH_MutexHeld() )
+        return(1);
+
+    if( r->type == FLASH_REQ_USER )
+        {
+        ret = FlashUserWrite( &r->user );
+        r->status = (ret == 1) ? FLASH_REQ_DONE : ret;
+        }
+    else
+        {
+        if( r->status == FLASH_REQ_PENDING )
+            {
+            // VTOC entry and header this slice, data starts next slice, a
+            // file that cannot fit is refused before anything is programmed
+            r->h = RCFS_OpenAdd( r->name, r->length );
+            r->status = (r->h >= 0) ? FLASH_REQ_ACTIVE : RCFS_ERROR;
+            if( r->status == FLASH_REQ_ACTIVE )
+                return(1);
+            }
+        else
+            {
+            n = r->length - r->done;
+            if( n > budget )
+                n = budget;
+
+            // program this block now rather than waiting for the ring buffer
+            if( (RCFS_Append( r->h, r->data + r->done, n ) != RCFS_SUCCESS) ||
+                (RCFS_Flush( r->h ) != RCFS_SUCCESS) )
+                {
+                // nothing is left under the name
+                RCFS_Cancel( r->h );
+                r->status = RCFS_ERROR;
+                }
+            else
+                {
+                r->done += n;
+
+                if( r->done < r->length )
+                    return(1);
+
+                if( RCFS_Close( r->h ) == RCFS_SUCCESS )
+                    r->status = FLASH_REQ_DONE;
+                else
+                    {
+                    RCFS_Cancel( r->h );
+                    r->status = RCFS_ERROR;
+                    }
+                }
+            }
+        }
+
+    // on to the next request
+    if( ++write_queue.tail >= FLASH_QUEUE_SIZE )
+        write_queue.tail = 0;
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Task that writes queued requests                                */
+/*-----------------------------------------------------------------------------*/
+
+task FlashQueueTask()
+{
+    while(1)
+        {
+        // one slice then let the other tasks run
+        if( FlashQueueService() )
+            abortTimeslice();
+        else
+            wait1Msec( FLASH_QUEUE_IDLE_WAIT );
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start the background writer task                                */
+/*-----------------------------------------------------------------------------*/
+
+void
+FlashQueueStart()
+{
+#if kRobotCVersionNumeric < 400
+    StartTask( FlashQueueTask, FLASH_QUEUE_PRIORITY );
+#else
+    startTask( FlashQueueTask, FLASH_QUEUE_PRIORITY );
+#endif
+}
@@ -1,608 +1,3660 @@
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*                        Copyright (c) James Pearman                          */
-/*                                 2013-2014                                   */
-/*                            All Rights Reserved                              */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    Module:     flash_rcfs.c                                                 */
-/*    Author:     James Pearman                                                */
-/*    Created:    23 Feb 2013                                                  */
-/*                                                                             */
-/*    Revisions:                                                               */
-/*                V1.00     7 Jan 2014 - Initial release                       */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    The author is supplying this software for use with the VEX cortex        */
-/*    control system. this is free software; you can redistribute it           */
-/*    and/or modify it under the terms of the GNU General Public License       */
-/*    as published by the Free Software Foundation; either version 3 of        */
-/*    the License, or (at your option) any later version.                      */
-/*                                                                             */
-/*    This software is distributed in the hope that it will be useful,         */
-/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
-/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
-/*    GNU General Public License for more details.                             */
-/*                                                                             */
-/*    You should have received a copy of the GNU General Public License        */
-/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
-/*                                                                             */
-/*    The author can be contacted on the vex forums as jpearman                */
-/*    or electronic mail using jbpearman_at_mac_dot_com                        */
-/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-
-//#include <FirmwareVersion.h>
-
-/*-----------------------------------------------------------------------------*/
-/** @file    flash_rcfs.c
-  * @brief   Access the ROBOTC file system
-*//*---------------------------------------------------------------------------*/
-
-/** @brief This will be the basename for all files not given a name            */
-const char *RCFS_BASENAME = "debug";
-
-/*-----------------------------------------------------------------------------*/
-/** @brief   flash file header                                                 */
-/*-----------------------------------------------------------------------------*/
-
-typedef struct _flash_file {
-    unsigned char name[16];                ///< file name
-    unsigned char type;                    ///< file type, wav, exe etc.
-    unsigned char time[4];                 ///< file creation time
-    unsigned char unknown;                 ///< unknown flags V3.XX
-
-    // V4 added a couple of bytes to the header
-    unsigned char pad[2];                  ///< unknown flags V4.XX
-
-    // not written to flash, we keep them here for convienience
-    unsigned long addr;                    ///< address of file in flash
-    unsigned char *data;                   ///< pointer to data for the file
-             int  datalength;              ///< length of file
-    } flash_file;
-
-/** @cond    */
-//#define FFDEBUG                  1
-#if kRobotCVersionNumeric < 400
-#define FLASH_FILE_HEADER_SIZE  22
-#else
-// fix, 16-Oct-2014, JP
-// looks like V4.26 changed header size
-#define FLASH_FILE_HEADER_SIZE  24
-#endif
-
-static  unsigned long  baseaddr = kStartOfFileSystem;
-
-// Define maximum file size, can be overridden in user code
-#ifndef MAX_FLASH_FILE_SIZE
-#define MAX_FLASH_FILE_SIZE 8192
-#endif
-
-// ROBOTC changed the size of the header in V3.60 and on
-#if kRobotCVersionNumeric < 359
-#define VTOC_OFFSET     24
-#else
-#if kRobotCVersionNumeric < 400
-#define VTOC_OFFSET     28
-#else
-// fix, 16-Oct-2014, JP
-// V4.26 changed VTOC offset
-#define VTOC_OFFSET     160
-#endif
-#endif
-
-#define RCFS_SUCCESS    0
-#define RCFS_ERROR      (-1)
-
-/** @endcond */
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Dump contents of a header structure to the debug stream         */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-
-void
-RCFS_DebugFile( flash_file *f )
-{
-    char str[20];
-    int  i;
-
-    // some problem using sprintf here
-    for(i=0;i<16;i++)
-        {
-        if( f->name[i] > 0x20 && f->name[i] < 0x7f )
-            str[i] = f->name[i];
-        else
-            str[i] = ' ';
-        }
-    str[16] = 0;
-
-    writeDebugStream(str);
-    writeDebugStream(" Addr %08X", f->addr );
-    writeDebugStream(" Data %08X", (unsigned long)f->data );
-    writeDebugStream(" Size %5d", f->datalength );
-    writeDebugStream(" Type %02X", f->type );
-    writeDebugStream(" Time %02X%02X%02X%02X", f->time[0],f->time[1],f->time[2],f->time[3] );
-//    writeDebugStream(" Flag %02X", f->unknown );
-    writeDebugStreamLine("");
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Initialize a flash file header                                  */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-
-static void
-RCFS_FileInit( flash_file *f )
-{
-    int     i;
-
-    // private vars
-    f->addr = 0;
-    f->data = NULL;
-    f->datalength = 0;
-
-    // Clear name
-    for(i=0;i<16;i++)
-        f->name[i] = 0;
-
-    // Init metadata
-    f->type   = ftData;
-    f->time[0] = 0x38;
-    f->time[1] = 0x64;
-    f->time[2] = 0x09;
-    f->time[3] = 0x00;
-    f->unknown = 0;
-    f->pad[0]  = 0;
-    f->pad[1]  = 0;
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Write flash file                                                */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-/** @details
- *  The flash file header should have been initialized with the file name,
- *  metadata and file address and length before this function is called.
- */
-
-static void
-RCFS_Write( flash_file *f )
-{
-    unsigned short *p;
-    unsigned short *q;
-    int   i;
-    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
-
-    // check for valid address
-    if( f->addr < baseaddr )
-        return;
-
-    if( f->data == NULL )
-        return;
-
-    // Init pointers (some wierd bug in ROBOTC here)
-    long tmp = f->addr;
-    p = (unsigned short *)tmp;
-    q = (unsigned short *)&(f->name[0]);
-
-    // Write header
-    for(i=0;i<(FLASH_FILE_HEADER_SIZE/2);i++)
-        {
-        // Write 16 bit data
-        FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)p++, *q++ );
-        }
-
-    // point at the file data, we will write as words
-    q = (unsigned short *)f->data;
-
-    // Write Data, datalength is now in bytes so divide datalength by 2
-    for(i=0;i<(f->datalength/2);i++)
-        {
-        // Write 16 bit data
-        FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)p++, *q++ );
-
-        // every 128 bytes abort time slice
-        if( (i % 128) == 0 )
-            abortTimeslice();
-        }
-
-    // Was it an odd number of bytes ?
-    if( (f->datalength & 1) == 1 )
-        {
-        // pad with 0xFF and write the last byte
-        unsigned short b = (*(unsigned char *)q) | 0xFF00;
-        FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)p++, b);
-        }
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Read flash file Header                                          */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-
-static void
-RCFS_ReadHeader( flash_file *f )
-{
-    unsigned char *q;
-    int  i;
-
-    long tmp = f->addr;
-    q = (unsigned char *)tmp;
-
-    // Read name
-    for(i=0;i<16;i++)
-        f->name[i] = *q++;
-
-    // Read ??
-    f->type    = *q++;
-    f->time[0] = *q++;
-    f->time[1] = *q++;
-    f->time[2] = *q++;
-    f->time[3] = *q++;
-    f->unknown = *q++;
-    f->pad[0]  = 0;
-    f->pad[1]  = 0;
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Read flash file table of contents and print in debug window     */
-/*-----------------------------------------------------------------------------*/
-
-void
-RCFS_ReadVTOC()
-{
-    long *toc = (long *)(baseaddr + VTOC_OFFSET);
-    long  addr;
-    long  size;
-    short slot;
-
-    flash_file  f;
-
-    // more than kMaxNumbofFlashFiles files we have an error
-    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
-        {
-        // Read file address
-        addr = *toc++;
-        // read file size
-        size = *toc++;
-
-        // Good file ?
-        if( addr == (-1) )
-            return;
-
-        f.addr       = baseaddr + addr;
-        f.data       = (unsigned char *)(f.addr + FLASH_FILE_HEADER_SIZE);
-        f.datalength = (size - FLASH_FILE_HEADER_SIZE);
-
-        // Read header
-        RCFS_ReadHeader( &f );
-        // Display
-        RCFS_DebugFile( &f );
-        }
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Find the number of the next free slot in the file system        */
-/*-----------------------------------------------------------------------------*/
-static int
-RCFS_FindLastSlot()
-{
-    long *toc = (long *)(baseaddr + VTOC_OFFSET);
-    long  addr;
-    short slot;
-
-    // more than kMaxNumbofFlashFiles files we have an error
-    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
-        {
-        // Read next file address
-        addr = *toc;
-
-        // End of table ?
-        if( addr == (-1) )
-            {
-            return(slot);
-            }
-        else
-            {
-            // Valid file found
-            toc+=2;
-            }
-        }
-
-    return(RCFS_ERROR);
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Find the first file in the file system                          */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-int
-RCFS_FindFirstFile( flash_file *f )
-{
-    long *toc = (long *)(baseaddr + VTOC_OFFSET);
-    long  addr;
-    long  size;
-
-    if( f == NULL )
-        return(RCFS_ERROR);
-
-    // Read file address
-    addr = *toc++;
-    // read file size
-    size = *toc++;
-
-    // Good file ?
-    if( addr == (-1) )
-        return(RCFS_ERROR);
-
-    f->addr       = baseaddr + addr;
-    f->data       = (unsigned char *)(f->addr + FLASH_FILE_HEADER_SIZE);
-    f->datalength = (size - FLASH_FILE_HEADER_SIZE);
-
-    // Read header
-    RCFS_ReadHeader( f );
-
-    // slot should be 0
-    return(0);
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Find the next file in the file system                           */
-/** @param[in] f pointer to a flash file header                                */
-/*-----------------------------------------------------------------------------*/
-int
-RCFS_FindNextFile( flash_file *f )
-{
-    long *toc = (long *)(baseaddr + VTOC_OFFSET);
-    long  addr;
-    long  size;
-    short slot;
-
-    if( f == NULL )
-        return(RCFS_ERROR);
-
-    // more than kMaxNumbofFlashFiles files we have an error
-    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
-        {
-        // Read file address
-        addr = *toc++;
-        // read file size
-        size = *toc++;
-
-        // Good file ?
-        if( addr == (-1) )
-            return(RCFS_ERROR);
-
-        // found starting file
-        if( (unsigned long)(baseaddr+addr) == f->addr )
-            {
-            // Get next file
-            slot++;
-            // Read file address
-            addr = *toc++;
-            // read file size
-            size = *toc++;
-
-            // Good file ?
-            if( addr == (-1) )
-                return(-1);
-
-            f->addr       = baseaddr + addr;
-            f->data       = (unsigned char *)(f->addr + FLASH_FILE_HEADER_SIZE);
-            f->datalength = (size - FLASH_FILE_HEADER_SIZE);
-
-            // Read header
-            RCFS_ReadHeader( f );
-
-            // return this slot
-            return(slot);
-            }
-        }
-
-    // error
-    return(RCFS_ERROR);
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Add a file to the file system                                   */
-/** @param[in] data pointer to the data to be written                          */
-/** @param[in] length plength of data in bytes                                 */
-/** @param[in] name name of the file to be written                             */
-/*-----------------------------------------------------------------------------*/
-
-int
-RCFS_AddFile( unsigned char *data, int length, char *name )
-{
-    long *toc = (long *)(baseaddr + VTOC_OFFSET);
-    long  addr;
-    long  size;
-    short slot;
-
-    long  maxaddr  = 0;
-    long  nextaddr = 0;
-
-    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
-    flash_file   f;
-
-    // bounds check length
-    if( (length <= 0) || (length > MAX_FLASH_FILE_SIZE))
-        return(RCFS_ERROR);
-
-    // more than kMaxNumbofFlashFiles files we have an error
-    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
-        {
-        // Read next file address
-        addr = *toc;
-
-        // End of table ?
-        if( addr == (-1) )
-            {
-            // Start on Word boundary
-            if(nextaddr & 1)
-                nextaddr++;
-
-            // move us into high menory
-            // V3.51 had crap at 8040000 so we had to push back
-            // to 8030000
-            if(nextaddr < 0x18000)
-                nextaddr = 0x18000;
-
-            // Check if there is room for the file
-            // We reserve 4K for user parameter storage
-            if( (nextaddr + length ) > 0x47000 )
-                return(RCFS_ERROR);
-
-            // create new file
-            RCFS_FileInit( &f );
-
-            // Copy name, max 15 chars
-            strncpy( &f.name[0], name, 15 );
-
-            // setup address, data pointer and length for this file
-            f.addr       = baseaddr + nextaddr;
-            f.data       = data;
-            f.datalength = length;
-
-#ifdef  FFDEBUG
-            // Debug
-            RCFS_DebugFile(&f);
-#endif
-            // Unlock the Flash Bank1 Program Erase controller
-            FLASH_UnlockBank1();
-
-            // Clear All pending flags
-            FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
-
-            // write table of contents entry
-            FLASHStatus = FLASH_ProgramWord( (uint32_t)toc++, nextaddr );
-            FLASHStatus = FLASH_ProgramWord( (uint32_t)toc++, length + FLASH_FILE_HEADER_SIZE );
-
-            // Write file
-            RCFS_Write( &f );
-
-            // We are done
-            return(RCFS_SUCCESS);
-            }
-        else
-            {
-            // Valid file found
-            toc++;
-            size = *toc++;
-
-            // Last file in memory ?
-            if( addr > maxaddr )
-                {
-                // maximum address found
-                maxaddr = addr;
-                // Address after this file
-                nextaddr = addr + size;
-                }
-            }
-        }
-
-    // No more VTOC space if here
-    return(RCFS_ERROR);
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Add a file to the file system                                   */
-/** @param[in] data pointer to the data to be written                          */
-/** @param[in] length length of data in bytes                                  */
-/*-----------------------------------------------------------------------------*/
-/** @details
- *  Add a file to the file system using the default filename
- */
-int
-RCFS_AddFile( unsigned char *data, int length )
-{
-    char name[16];
-    int  slot;
-
-    // Get the last file slot number
-    slot = RCFS_FindLastSlot();
-
-    // any room left ?
-    if( slot < 0 )
-        return(RCFS_ERROR);
-    // create default filename
-    sprintf( &name[0], "%s%03d", RCFS_BASENAME, slot);
-
-    // Add this file
-    return( RCFS_AddFile( data, length, name ) );
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Get a pointer to data in a file                                 */
-/** @param[in] name the name of the file to open                               */
-/** @param[in] data handle used to return a pointer to the data                */
-/** @param[in] length pointer to returned length of data in bytes              */
-/*-----------------------------------------------------------------------------*/
-/** @details
- *  This function searches through the file table of contents looking for a file
- *  with a name that matches the requested name.  It returns a pointer to the
- *  files data and it's length in words.
- */
-int
-RCFS_GetFile( char *name, unsigned char **data, int *length )
-{
-    flash_file  f;
-
-    if( data == NULL )
-        return(RCFS_ERROR);
-    if( length == NULL )
-        return(RCFS_ERROR);
-
-    // Get the first file
-    if( RCFS_FindFirstFile(&f) >= 0 )
-        {
-        do {
-            // Check file for match on name
-            if( strcmp( name, &f.name[0] ) == 0 )
-                {
-                // Match
-                *data   = f.data;
-                *length = f.datalength;
-                return(RCFS_SUCCESS);
-                }
-            } while( RCFS_FindNextFile(&f) >= 0 );
-        }
-
-    // No match
-    return( RCFS_ERROR );
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Get the name of the last file in the VTOC                       */
-/*-----------------------------------------------------------------------------*/
-/** @details   Use this if you write a file with the default name to dtermine
- *  what that name was.
- */
-
-int
-RCFS_GetLastFilename( char *name, int len )
-{
-    flash_file  f;
-
-    if( name == NULL )
-        return( RCFS_ERROR );
-
-    if(len > 16)
-        len = 16;
-
-    // Get the first file
-    if( RCFS_FindFirstFile(&f) >= 0 )
-        {
-        while( RCFS_FindNextFile(&f) >= 0 )
-            len = len; // nothing to do, remove warning
-
-        strncpy( name, &f.name[0], len );
-
-        return(RCFS_SUCCESS);
-        }
-
-    return( RCFS_ERROR );
-}
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                 2013-2014                                   */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_rcfs.c                                                 */
+/*    Author:     James Pearman                                                */
+/*    Created:    23 Feb 2013                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00     7 Jan 2014 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Add in RAM VTOC cache                 */
+/*                V1.02    17 Oct 2026 - Add directory cursor API              */
+/*                V1.03    17 Oct 2026 - Batched programming in RCFS_Write     */
+/*                V1.04    17 Oct 2026 - Add streaming writes                  */
+/*                V1.05    17 Oct 2026 - File system end follows user pages    */
+/*                V1.06    17 Oct 2026 - Add file delete and compaction        */
+/*                V1.07    17 Oct 2026 - Reserve pages for the circular log    */
+/*                V1.08    17 Oct 2026 - Add compressed files                  */
+/*                V1.09    17 Oct 2026 - Add RCFS_Read and RCFS_Map            */
+/*                V1.10    17 Oct 2026 - Add file CRC32 and RCFS_Verify        */
+/*                V1.11    17 Oct 2026 - Commit VTOC entry after the file data */
+/*                V1.12    17 Oct 2026 - Detect the VTOC layout at run time    */
+/*                V1.13    17 Oct 2026 - Add RCFS_Stat                         */
+/*                V1.14    17 Oct 2026 - Stop on write errors, add verify      */
+/*                V1.15    17 Oct 2026 - Recover before building the VTOC cache*/
+/*                V1.16    17 Oct 2026 - Only recovery closes an open stream   */
+/*                V1.17    17 Oct 2026 - Fail when the flash cannot be unlocked*/
+/*                V1.18    17 Oct 2026 - Count the header in the AddFile bound */
+/*                V1.19    17 Oct 2026 - Compaction keeps the VTOC page        */
+/*                V1.20    17 Oct 2026 - Delete checks the program status      */
+/*                V1.21    17 Oct 2026 - Add RCFS_Abandon                      */
+/*                V1.22    17 Oct 2026 - Add RCFS_StreamRoom                   */
+/*                V1.23    17 Oct 2026 - A failed close leaves the file open   */
+/*                V1.24    17 Oct 2026 - Add RCFS_OpenAdd and RCFS_Cancel      */
+/*                V1.25    17 Oct 2026 - Compact checks the number of files    */
+/*                V1.26    17 Oct 2026 - Build without -w                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+//#include <FirmwareVersion.h>
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_rcfs.c
+  * @brief   Access the ROBOTC file system
+*//*---------------------------------------------------------------------------*/
+
+/** @brief This will be the basename for all files not given a name            */
+const char *RCFS_BASENAME = "debug";
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   flash file header                                                 */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_file {
+    unsigned char name[16];                ///< file name
+    unsigned char type;                    ///< file type, wav, exe etc.
+    unsigned char time[4];                 ///< file creation time
+    unsigned char unknown;                 ///< unknown flags V3.XX
+
+    // V4 added a couple of bytes to the header
+    unsigned char pad[2];                  ///< unknown flags V4.XX
+
+    // not written to flash, we keep them here for convienience
+    unsigned long addr;                    ///< address of file in flash
+    unsigned char *data;                   ///< pointer to data for the file
+             int  datalength;              ///< length of file
+            short slot;                    ///< VTOC slot of this file
+    } flash_file;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   directory cursor                                                  */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Used with RCFS_DirOpen, RCFS_DirNext and RCFS_DirClose, user code should
+ *  not access the members directly.
+ */
+
+typedef struct _rcfs_dir {
+             short slot;                   ///< next VTOC slot to read
+             long  *toc;                   ///< pointer to next VTOC entry
+    unsigned long  addr;                   ///< address of the last file read
+    } rcfs_dir;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   file system layout                                                */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Returned by RCFS_GetInfo, found by checking the VTOC the first time the
+ *  file system is used.
+ */
+
+typedef struct _rcfs_info {
+             short status;                 ///< RCFS_SUCCESS or RCFS_ERROR if no layout matched
+             short detected;               ///< 0 if the VTOC was empty and the build layout is used
+             short vtoc_offset;            ///< offset of the VTOC in the file system header
+             short header_size;            ///< size of a file header
+             short files;                  ///< VTOC entries used
+             short valid;                  ///< the layout has been checked
+    } rcfs_info;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   file system usage                                                 */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Returned by RCFS_Stat, sizes are in bytes and count the space available
+ *  for files above RCFS_DATA_OFFSET.  Free space is always after the last
+ *  file so there is only one free extent, space used by deleted files is
+ *  not free until RCFS_Compact is called.
+ */
+
+typedef struct _rcfs_stat {
+             long  used;                   ///< bytes used by files and their headers
+             long  deleted;                ///< bytes of that in deleted files
+             long  free;                   ///< bytes after the last file
+             long  largest;                ///< largest file that can be added now
+             short files;                  ///< VTOC slots used
+             short slots;                  ///< VTOC slots free
+    } rcfs_stat;
+
+/** @cond    */
+//#define FFDEBUG                  1
+#if kRobotCVersionNumeric < 400
+#define RCFS_BUILD_HEADER_SIZE  22
+#else
+// fix, 16-Oct-2014, JP
+// looks like V4.26 changed header size
+#define RCFS_BUILD_HEADER_SIZE  24
+#endif
+
+static  unsigned long  baseaddr = kStartOfFileSystem;
+
+// Define maximum file size, can be overridden in user code
+#ifndef MAX_FLASH_FILE_SIZE
+#define MAX_FLASH_FILE_SIZE 8192
+#endif
+
+// ROBOTC changed the size of the header in V3.60 and on
+#if kRobotCVersionNumeric < 359
+#define RCFS_BUILD_VTOC_OFFSET  24
+#else
+#if kRobotCVersionNumeric < 400
+#define RCFS_BUILD_VTOC_OFFSET  28
+#else
+// fix, 16-Oct-2014, JP
+// V4.26 changed VTOC offset
+#define RCFS_BUILD_VTOC_OFFSET  160
+#endif
+#endif
+
+#define RCFS_SUCCESS    0
+#define RCFS_ERROR      (-1)
+
+// The firmware may not match the version the program was compiled with,
+// the layout used is checked against the flash by RCFS_Probe
+static  rcfs_info       rcfs_layout;
+
+#define VTOC_OFFSET             rcfs_layout.vtoc_offset
+#define FLASH_FILE_HEADER_SIZE  rcfs_layout.header_size
+
+// The VTOC cache uses about 12 bytes of RAM per file, it can be
+// removed by defining RCFS_NO_VTOC_CACHE in user code
+#ifndef RCFS_NO_VTOC_CACHE
+#define RCFS_VTOC_CACHE     1
+#endif
+
+// Number of hash buckets in the VTOC cache, must be a power of 2
+#ifndef RCFS_HASH_SIZE
+#define RCFS_HASH_SIZE      16
+#endif
+
+// End of the file system, we reserve 4K for user parameter storage
+// or more if flash_user.c is configured with more pages
+#ifdef FLASH_USER_BASE_ADDR
+#define RCFS_END_OFFSET     (FLASH_USER_BASE_ADDR - kStartOfFileSystem)
+#else
+#define RCFS_END_OFFSET     0x47000
+#endif
+
+// Size of the streaming writer ring buffer in bytes, must be even
+#ifndef RCFS_STREAM_BUFFER_SIZE
+#define RCFS_STREAM_BUFFER_SIZE 128
+#endif
+
+// Maximum size of a streamed file, datalength is an int so stay below 32K
+#ifndef RCFS_STREAM_MAX_SIZE
+#define RCFS_STREAM_MAX_SIZE    0x7F00
+#endif
+
+// Files can be compressed as they are written, define RCFS_NO_COMPRESS in
+// user code to save the RAM used by the encoder
+#ifndef RCFS_NO_COMPRESS
+#define RCFS_COMPRESS           1
+#endif
+
+// Files added by this library start here, ROBOTC's own files are below
+// V3.51 had crap at 8040000 so we had to push back to 8030000
+#define RCFS_DATA_OFFSET        0x18000
+
+// Flash page size, the smallest area that can be erased
+#define RCFS_PAGE_SIZE          0x800
+
+// RCFS_Compact needs the last two pages of the file system for a journal
+// and a copy of the page being moved, define RCFS_NO_COMPACT in user code
+// to remove it and use these pages for files
+#ifndef RCFS_NO_COMPACT
+#define RCFS_COMPACT            1
+#endif
+
+#ifdef RCFS_COMPACT
+#define RCFS_JOURNAL_OFFSET     (RCFS_END_OFFSET - (2 * RCFS_PAGE_SIZE))
+#define RCFS_STAGING_OFFSET     (RCFS_END_OFFSET - RCFS_PAGE_SIZE)
+#define RCFS_LOG_END            RCFS_JOURNAL_OFFSET
+#else
+#define RCFS_LOG_END            RCFS_END_OFFSET
+#endif
+
+// The circular log in flash_log.c takes RCFS_LOG_PAGES pages below those,
+// it is not used unless RCFS_LOG_PAGES is defined in user code
+#ifdef RCFS_LOG_PAGES
+#define RCFS_LOG_OFFSET         (RCFS_LOG_END - (RCFS_LOG_PAGES * RCFS_PAGE_SIZE))
+#define RCFS_DATA_END           RCFS_LOG_OFFSET
+#else
+#define RCFS_DATA_END           RCFS_LOG_END
+#endif
+
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check for the end of the VTOC                                   */
+/** @param[in] addr the address word of a VTOC entry                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The bottom half word of the address is programmed last and commits an
+ *  entry.  An entry with only the top half programmed was stopped by a reset,
+ *  it is the end of the table until RCFS_Recover finishes it.
+ */
+
+static int
+RCFS_VtocEnd( long addr )
+{
+    return( (addr & 0xFFFF) == 0xFFFF );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check a VTOC layout against the flash                           */
+/** @param[in] offset offset of the VTOC from the start of the file system     */
+/** @param[in] hsize the file header size for this layout                      */
+/** @returns   The number of VTOC entries used or RCFS_ERROR                   */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Every entry up to the end of the table must point at a file inside the
+ *  file system and after the table, one that does not means this is not the
+ *  layout the firmware used.
+ */
+
+static int
+RCFS_ProbeLayout( short offset, short hsize )
+{
+    long *toc;
+    long  addr;
+    long  size;
+    short slot;
+
+    long tmp = baseaddr + offset;
+    toc = (long *)tmp;
+
+    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
+        {
+        addr = *toc++;
+        size = *toc++;
+
+        // End of table, the bottom of the address is programmed last
+        if( RCFS_VtocEnd( addr ) )
+            break;
+
+        // entry cleared by RCFS_Compact
+        if( addr == 0 )
+            continue;
+
+        if( (addr < (offset + (kMaxNumbofFlashFiles * 8))) || (addr >= RCFS_END_OFFSET) )
+            return(RCFS_ERROR);
+
+        // size is erased until a streamed file is closed
+        if( (size != (-1)) && ((size < hsize) || ((addr + size) > RCFS_END_OFFSET)) )
+            return(RCFS_ERROR);
+        }
+
+    return(slot);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the layout of the file system                              */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR if the VTOC does not make sense      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The layout for the ROBOTC version the program was compiled with is tried
+ *  first, then the others.  If no VTOC has any files the build layout is
+ *  used.  The result is kept, on an error nothing in the file system is
+ *  read or written.
+ */
+
+static int
+RCFS_Probe()
+{
+    short offset;
+    short hsize;
+    short empty = 0;
+    short i;
+    int   n;
+
+    if( rcfs_layout.valid )
+        return( rcfs_layout.status );
+
+    rcfs_layout.valid       = 1;
+    rcfs_layout.status      = RCFS_SUCCESS;
+    rcfs_layout.detected    = 0;
+    rcfs_layout.vtoc_offset = RCFS_BUILD_VTOC_OFFSET;
+    rcfs_layout.header_size = RCFS_BUILD_HEADER_SIZE;
+    rcfs_layout.files       = 0;
+
+    for(i=0;i<4;i++)
+        {
+        if( i == 0 ) offset = RCFS_BUILD_VTOC_OFFSET;
+        if( i == 1 ) offset = 160;
+        if( i == 2 ) offset = 28;
+        if( i == 3 ) offset = 24;
+        if( (i > 0) && (offset == RCFS_BUILD_VTOC_OFFSET) )
+            continue;
+
+        // V4.26 changed the header size and VTOC offset together
+        hsize = (offset == 160) ? 24 : 22;
+
+        n = RCFS_ProbeLayout( offset, hsize );
+        if( n > 0 )
+            {
+            rcfs_layout.detected    = 1;
+            rcfs_layout.vtoc_offset = offset;
+            rcfs_layout.header_size = hsize;
+            rcfs_layout.files       = n;
+            return(RCFS_SUCCESS);
+            }
+        if( (n == 0) && (i == 0) )
+            empty = 1;
+        }
+
+    if( empty )
+        return(RCFS_SUCCESS);
+
+    rcfs_layout.status = RCFS_ERROR;
+    return(RCFS_ERROR);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the file system layout                                      */
+/** @param[out] info pointer to a structure for the layout                     */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR if the VTOC does not make sense      */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_GetInfo( rcfs_info *info )
+{
+    if( info == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_Probe() == RCFS_SUCCESS )
+        rcfs_layout.files = RCFS_ProbeLayout( VTOC_OFFSET, FLASH_FILE_HEADER_SIZE );
+
+    memcpy( info, &rcfs_layout, sizeof(rcfs_info) );
+
+    return( rcfs_layout.status );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Dump contents of a header structure to the debug stream         */
+/** @param[in] f pointer to a flash file header                                */
+/*-----------------------------------------------------------------------------*/
+
+void
+RCFS_DebugFile( flash_file *f )
+{
+    char str[20];
+    int  i;
+
+    // some problem using sprintf here
+    for(i=0;i<16;i++)
+        {
+        if( f->name[i] > 0x20 && f->name[i] < 0x7f )
+            str[i] = f->name[i];
+        else
+            str[i] = ' ';
+        }
+    str[16] = 0;
+
+    writeDebugStream(str);
+    writeDebugStream(" Addr %08X", f->addr );
+    writeDebugStream(" Data %08X", (unsigned long)f->data );
+    writeDebugStream(" Size %5d", f->datalength );
+    writeDebugStream(" Type %02X", f->type );
+    writeDebugStream(" Time %02X%02X%02X%02X", f->time[0],f->time[1],f->time[2],f->time[3] );
+//    writeDebugStream(" Flag %02X", f->unknown );
+    writeDebugStreamLine("");
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Initialize a flash file header                                  */
+/** @param[in] f pointer to a flash file header                                */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_FileInit( flash_file *f )
+{
+    int     i;
+
+    // private vars
+    f->addr = 0;
+    f->data = NULL;
+    f->datalength = 0;
+    f->slot = RCFS_ERROR;
+
+    // Clear name
+    for(i=0;i<16;i++)
+        f->name[i] = 0;
+
+    // Init metadata
+    f->type   = ftData;
+    f->time[0] = 0x38;
+    f->time[1] = 0x64;
+    f->time[2] = 0x09;
+    f->time[3] = 0x00;
+    f->unknown = 0;
+    f->pad[0]  = 0;
+    f->pad[1]  = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The last write that failed                                        */
+/*-----------------------------------------------------------------------------*/
+
+static  FLASH_Status    rcfs_write_status = FLASH_COMPLETE;
+static  unsigned long   rcfs_write_addr   = 0;
+static  short           rcfs_verify       = 0;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Compare files with the data after they are programmed           */
+/** @param[in] enable 1 to verify files, 0 to trust the flash controller       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Applies to RCFS_AddFile and the streaming writer.  The compare is 32 bits
+ *  at a time when the data is word aligned, 1024 reads for a 4K file.
+ */
+
+void
+RCFS_SetVerify( short enable )
+{
+    rcfs_verify = enable;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Remember a failed write                                         */
+/** @param[in] status the status from the flash driver                         */
+/** @param[in] addr the address that could not be programmed                   */
+/** @returns   status                                                          */
+/*-----------------------------------------------------------------------------*/
+
+static FLASH_Status
+RCFS_WriteError( FLASH_Status status, unsigned long addr )
+{
+    rcfs_write_status = status;
+    rcfs_write_addr   = addr;
+
+    // the error flags stay set until cleared
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+
+    return(status);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the last write error                                        */
+/** @param[out] addr if not NULL set to the address that failed                */
+/** @returns   FLASH_COMPLETE if there was no error since the last call,       */
+/**            FLASH_ERROR_PG, FLASH_ERROR_WRP or FLASH_TIMEOUT                */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  FLASH_ERROR_PG is also returned when the data did not verify.  The error
+ *  is cleared by this call.
+ */
+
+FLASH_Status
+RCFS_GetWriteError( unsigned long *addr )
+{
+    FLASH_Status status = rcfs_write_status;
+
+    if( addr != NULL )
+        *addr = rcfs_write_addr;
+
+    rcfs_write_status = FLASH_COMPLETE;
+    rcfs_write_addr   = 0;
+
+    return(status);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Unlock the flash controller before writing                      */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR if another task has the controller   */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The failure is recorded as FLASH_BUSY for RCFS_GetWriteError.
+ */
+
+static int
+RCFS_Unlock()
+{
+    FLASH_Status FLASHStatus;
+
+    // Unlock the Flash Bank1 Program Erase controller
+    FLASHStatus = FLASH_UnlockBank1();
+
+    // Clear All pending flags
+    if( FLASHStatus == FLASH_COMPLETE )
+        FLASHStatus = FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, 0 );
+        return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write flash file                                                */
+/** @param[in] f pointer to a flash file header                                */
+/** @returns   FLASH_COMPLETE or the status of the half word that failed       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The flash file header should have been initialized with the file name,
+ *  metadata and file address and length before this function is called.
+ *  The data is written before the header.  Writing stops at the first half
+ *  word that fails, the status and address are kept for RCFS_GetWriteError.
+ */
+
+static FLASH_Status
+RCFS_Write( flash_file *f )
+{
+    unsigned short *p;
+    unsigned short *q;
+    long  remaining;
+    int   chunk;
+    uint32_t failaddr;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    // check for valid address
+    if( (f->addr < baseaddr) || (f->data == NULL) )
+        return( RCFS_WriteError( FLASH_ERROR_PG, f->addr ) );
+
+    // Init pointers (some wierd bug in ROBOTC here), data is written first
+    long tmp = f->addr;
+    p = (unsigned short *)tmp;
+    p += (FLASH_FILE_HEADER_SIZE/2);
+
+    // point at the file data, we will write as words
+    q = (unsigned short *)f->data;
+
+    // Write Data, datalength is now in bytes so divide datalength by 2
+    // programmed in blocks of 128 half words with a timeslice abort between each
+    remaining = f->datalength/2;
+    while( remaining > 0 )
+        {
+        chunk = (remaining > 128) ? 128 : remaining;
+
+        // Write a block of 16 bit data, stop at the first failure
+        FLASHStatus = FLASH_ProgramBuffer( (uint32_t)p, q, chunk, &failaddr );
+        if( FLASHStatus != FLASH_COMPLETE )
+            return( RCFS_WriteError( FLASHStatus, failaddr ) );
+
+        p += chunk;
+        q += chunk;
+        remaining -= chunk;
+
+        abortTimeslice();
+        }
+
+    // Was it an odd number of bytes ?
+    if( (f->datalength & 1) == 1 )
+        {
+        // pad with 0xFF and write the last byte
+        unsigned short b = (*(unsigned char *)q) | 0xFF00;
+        FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)p, b);
+        if( FLASHStatus != FLASH_COMPLETE )
+            return( RCFS_WriteError( FLASHStatus, (uint32_t)p ) );
+        }
+
+    if( rcfs_verify )
+        {
+        FLASHStatus = FLASH_VerifyBuffer( tmp + FLASH_FILE_HEADER_SIZE, f->data, f->datalength, &failaddr );
+        if( FLASHStatus != FLASH_COMPLETE )
+            return( RCFS_WriteError( FLASHStatus, failaddr ) );
+        }
+
+    // Write header
+    p = (unsigned short *)tmp;
+    q = (unsigned short *)&(f->name[0]);
+    FLASHStatus = FLASH_ProgramBuffer( (uint32_t)p, q, FLASH_FILE_HEADER_SIZE/2, &failaddr );
+    if( FLASHStatus != FLASH_COMPLETE )
+        return( RCFS_WriteError( FLASHStatus, failaddr ) );
+
+    if( rcfs_verify )
+        {
+        FLASHStatus = FLASH_VerifyBuffer( tmp, &(f->name[0]), FLASH_FILE_HEADER_SIZE, &failaddr );
+        if( FLASHStatus != FLASH_COMPLETE )
+            return( RCFS_WriteError( FLASHStatus, failaddr ) );
+        }
+
+    return(FLASH_COMPLETE);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read flash file Header                                          */
+/** @param[in] f pointer to a flash file header                                */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_ReadHeader( flash_file *f )
+{
+    unsigned char *q;
+    int  i;
+
+    long tmp = f->addr;
+    q = (unsigned char *)tmp;
+
+    // Read name
+    for(i=0;i<16;i++)
+        f->name[i] = *q++;
+
+    // Read ??
+    f->type    = *q++;
+    f->time[0] = *q++;
+    f->time[1] = *q++;
+    f->time[2] = *q++;
+    f->time[3] = *q++;
+    f->unknown = *q++;
+    f->pad[0]  = *q++;
+    f->pad[1]  = *q++;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Streaming writer state                                            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Only one file can be open for writing at a time.  Appended data goes into
+ *  a small ring buffer and is programmed into flash as whole half words.
+ */
+
+typedef struct _rcfs_stream {
+             short open;                   ///< a file is open for writing
+             short slot;                   ///< VTOC slot of the file
+    unsigned long  addr;                   ///< address of the file header
+             long  length;                 ///< bytes appended
+             long  written;                ///< bytes programmed into flash
+             long  maxlength;              ///< space available for data
+             short head;                   ///< ring buffer write index
+             short tail;                   ///< ring buffer read index
+             short count;                  ///< bytes in the ring buffer
+             short lz;                     ///< data is compressed
+             long  logical;                ///< bytes appended before compression
+    unsigned long  crc;                    ///< CRC32 of the bytes appended
+    unsigned short buffer[RCFS_STREAM_BUFFER_SIZE/2];
+    } rcfs_stream;
+
+static  rcfs_stream write_stream;
+
+/** @cond    */
+// Files written by this library have flags in the first time byte, the rest
+// of the time and the byte after it hold a CRC32 of the data as stored.  For
+// a streamed file these are erased until the file is closed.
+#define RCFS_FILE_MARK          0xA0
+#define RCFS_FILE_CRC           0x01
+#define RCFS_FILE_LZ            0x02
+#define RCFS_FILE_ADD           0x04
+#define RCFS_FILE_CRC_OFFSET    18
+
+// RCFS_Verify results
+#define RCFS_CRC_NONE           1
+#define RCFS_CRC_ERROR          (-2)
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   CRC32 table, one entry for each value of a nibble                 */
+/*-----------------------------------------------------------------------------*/
+
+static const unsigned long rcfs_crc_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add bytes to a CRC32                                            */
+/** @param[in] crc the CRC so far, start with 0xFFFFFFFF                       */
+/** @param[in] data pointer to the bytes                                       */
+/** @param[in] length number of bytes                                          */
+/** @returns   The updated CRC, invert it when all bytes are added             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The same CRC as zlib and ethernet, worked a nibble at a time so the table
+ *  is only 64 bytes.
+ */
+
+static unsigned long
+RCFS_Crc32( unsigned long crc, unsigned char *data, long length )
+{
+    long  i;
+
+    for(i=0;i<length;i++)
+        {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ rcfs_crc_table[ crc & 0x0F ];
+        crc = (crc >> 4) ^ rcfs_crc_table[ crc & 0x0F ];
+        }
+
+    return(crc);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the RCFS flags of a file                                    */
+/** @param[in] f pointer to a flash file header                                */
+/** @returns   RCFS_FILE_xxx bits, 0 for files without flags                   */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Files below RCFS_DATA_OFFSET were written by ROBOTC, the header bytes
+ *  mean something else there.
+ */
+
+static int
+RCFS_FileFlags( flash_file *f )
+{
+    if( (f->addr - baseaddr) < RCFS_DATA_OFFSET )
+        return(0);
+    if( (f->time[0] & 0xF0) != RCFS_FILE_MARK )
+        return(0);
+
+    return( f->time[0] & 0x0F );
+}
+
+#ifdef RCFS_COMPRESS
+/** @cond    */
+// Compressed data is a series of tokens, 0x00 to 0x7F is followed by that
+// many literal bytes plus one, 0x80 to 0xFF is a copy of (token & 0x7F) + 3
+// bytes from the distance in the next byte plus one
+#define RCFS_LZ_WINDOW          256
+#define RCFS_LZ_MIN_MATCH       3
+#define RCFS_LZ_MAX_MATCH       130
+#define RCFS_LZ_MAX_LITERAL     120
+#define RCFS_LZ_HASH_SIZE       128
+
+// The pad half word of a compressed file holds the uncompressed size, it is
+// erased until the file is closed
+#define RCFS_FILE_LZ_SIZE       22
+#define RCFS_LZ_MAX_SIZE        0xFFFE
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Compression state of the file being written                       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Bytes are added one at a time, literals and the match being extended are
+ *  kept in the window until a token can be written.
+ */
+
+typedef struct _rcfs_lz {
+    unsigned char  window[RCFS_LZ_WINDOW];     ///< bytes appended most recently
+    unsigned short hash[RCFS_LZ_HASH_SIZE];    ///< position of byte pairs
+             long  pos;                        ///< bytes appended
+             short lit;                        ///< literals not yet written
+             short mlen;                       ///< length of the match
+             short moff;                       ///< distance to the match
+    } rcfs_lz;
+
+static  rcfs_lz     lz_encoder;
+static  short       rcfs_compress = 0;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Compress files written from now on                              */
+/** @param[in] enable 1 to compress files, 0 to write them as they are         */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Applies to RCFS_AddFile and RCFS_OpenWrite, compressed files must be read
+ *  with RCFS_ReadFile.  Files are not compressed on firmware older than V4.26
+ *  as the header has no room for the uncompressed size.
+ */
+
+void
+RCFS_SetCompression( short enable )
+{
+    rcfs_compress = enable;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check if the next file should be compressed                     */
+/*-----------------------------------------------------------------------------*/
+
+static short
+RCFS_LzEnabled()
+{
+    return( rcfs_compress && (FLASH_FILE_HEADER_SIZE > RCFS_FILE_LZ_SIZE) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Largest size of data once compressed                            */
+/** @param[in] length bytes to be added                                        */
+/*-----------------------------------------------------------------------------*/
+
+static long
+RCFS_LzWorstCase( long length )
+{
+    return( length + (length / RCFS_LZ_MAX_LITERAL) + 1 );
+}
+#endif  // RCFS_COMPRESS
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the size of a file that has not been closed                 */
+/** @param[in] slot the VTOC slot of the file                                  */
+/** @param[in] addr offset of the file from the start of the file system       */
+/** @returns   The file size including the header                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A streamed file has an erased size in the VTOC until it is closed.  If the
+ *  program stopped before the file was closed the data ends at the last byte
+ *  that is not erased, trailing 0xFF bytes are lost.  Nothing is written,
+ *  RCFS_StreamFinish closes the file.
+ */
+
+static long
+RCFS_StreamSize( short slot, long addr )
+{
+    unsigned char *p;
+    long  length;
+
+    // The file is still being written
+    if( write_stream.open && (slot == write_stream.slot) )
+        return( FLASH_FILE_HEADER_SIZE + write_stream.written );
+
+    // Search back for the end of the data
+    length = RCFS_DATA_END - addr - FLASH_FILE_HEADER_SIZE;
+    if( length > RCFS_STREAM_MAX_SIZE )
+        length = RCFS_STREAM_MAX_SIZE;
+
+    long tmp = baseaddr + addr + FLASH_FILE_HEADER_SIZE;
+    p = (unsigned char *)tmp;
+
+    while( (length > 0) && (p[length-1] == 0xFF) )
+        length--;
+
+    return( length + FLASH_FILE_HEADER_SIZE );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Close a file left open by a reset                               */
+/** @param[in] slot the VTOC slot of the file                                  */
+/** @param[in] addr offset of the file from the start of the file system       */
+/** @param[in] toc pointer to the VTOC entry of the file                        */
+/** @returns   The file size including the header or RCFS_ERROR               */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The size from RCFS_StreamSize is programmed into the VTOC so the file
+ *  only has to be recovered once.  A file that was being written by
+ *  RCFS_AddFile is deleted instead.  The flash must be unlocked.
+ */
+
+static long
+RCFS_StreamFinish( short slot, long addr, long *toc )
+{
+    unsigned char *p;
+    long  size;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    size = RCFS_StreamSize( slot, addr );
+
+    // RCFS_AddFile did not finish, the file is deleted
+    long tmp = baseaddr + addr;
+    p = (unsigned char *)tmp;
+    if( (p[17] & 0xF0) == RCFS_FILE_MARK && (p[17] & RCFS_FILE_ADD) )
+        FLASHStatus = FLASH_ProgramHalfWord( baseaddr + addr, 0 );
+
+    // Close the file
+    if( FLASHStatus == FLASH_COMPLETE )
+        FLASHStatus = FLASH_ProgramWord( (uint32_t)(toc + 1), size );
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, tmp );
+        return(RCFS_ERROR);
+        }
+
+    return( size );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check if a file has been deleted                                */
+/** @param[in] addr offset of the file from the start of the file system       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  RCFS_DeleteFile clears the first two bytes of the name, the VTOC entry
+ *  keeps the address and size so the space is not reused before RCFS_Compact.
+ *  RCFS_Compact clears the address and size of entries it no longer needs.
+ */
+
+static int
+RCFS_Deleted( long addr )
+{
+    long tmp = baseaddr + addr;
+
+    if( addr == 0 )
+        return(1);
+
+    return( *(unsigned short *)tmp == 0 );
+}
+
+#ifdef RCFS_VTOC_CACHE
+/*-----------------------------------------------------------------------------*/
+/** @brief   VTOC cache entry                                                  */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_cache_entry {
+    unsigned long  addr;                   ///< address of file in flash
+             long  size;                   ///< file size from the VTOC
+    unsigned short hash;                   ///< hash of the file name
+             short next;                   ///< next slot in this hash bucket
+    } rcfs_cache_entry;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   In RAM copy of the VTOC                                           */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_cache {
+             short valid;                  ///< cache has been built
+             short count;                  ///< number of files in the VTOC
+             long  maxaddr;                ///< offset of the last file
+             long  nextaddr;               ///< offset after the last file
+             long  deleted;                ///< bytes used by deleted files
+             short bucket[RCFS_HASH_SIZE]; ///< first slot in each hash bucket
+    rcfs_cache_entry entry[kMaxNumbofFlashFiles];
+    } rcfs_cache;
+
+static  rcfs_cache  vtoc_cache;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Calculate hash of a file name                                   */
+/** @param[in] name pointer to the file name                                   */
+/*-----------------------------------------------------------------------------*/
+
+static unsigned short
+RCFS_NameHash( char *name )
+{
+    unsigned short hash = 0;
+    int  i;
+
+    // names are a maximum of 16 characters
+    for(i=0;i<16;i++)
+        {
+        if( name[i] == 0 )
+            break;
+        hash = (hash * 31) + (unsigned char)name[i];
+        }
+
+    return(hash);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a VTOC entry to the cache                                   */
+/** @param[in] slot the VTOC slot of the file                                  */
+/** @param[in] addr offset of the file from the start of the file system       */
+/** @param[in] size size of the file from the VTOC                             */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_CacheAdd( short slot, long addr, long size )
+{
+    rcfs_cache_entry *e = &vtoc_cache.entry[slot];
+    short *s;
+
+    e->addr = baseaddr + addr;
+    e->size = size;
+    e->next = RCFS_ERROR;
+
+    // hash the name in the file header
+    long tmp = e->addr;
+    e->hash = RCFS_NameHash( (char *)tmp );
+
+    // add to the end of the bucket so files with the same name are
+    // found in VTOC order, deleted files are not in any bucket
+    if( !RCFS_Deleted( addr ) )
+        {
+        s = &vtoc_cache.bucket[ e->hash & (RCFS_HASH_SIZE-1) ];
+        while( *s != RCFS_ERROR )
+            s = &vtoc_cache.entry[*s].next;
+        *s = slot;
+        }
+    else
+        vtoc_cache.deleted += size;
+
+    // Last file in memory ?
+    if( addr > vtoc_cache.maxaddr )
+        {
+        vtoc_cache.maxaddr  = addr;
+        vtoc_cache.nextaddr = addr + size;
+        }
+
+    vtoc_cache.count = slot + 1;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Discard the VTOC cache                                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this if the file system has been changed by something other than
+ *  this library, the cache will be rebuilt when next used.
+ */
+
+void
+RCFS_CacheInvalidate()
+{
+    vtoc_cache.valid = 0;
+}
+#endif  // RCFS_VTOC_CACHE
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Erase a page of the file system if it is not already erased     */
+/** @param[in] offset offset of the page from the start of the file system     */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_ErasePage( long offset )
+{
+    unsigned long *p;
+    int   i;
+
+    long tmp = baseaddr + offset;
+    p = (unsigned long *)tmp;
+
+    for(i=0;i<(RCFS_PAGE_SIZE/4);i++)
+        {
+        if( p[i] != 0xFFFFFFFF )
+            break;
+        }
+
+    if( i == (RCFS_PAGE_SIZE/4) )
+        return(RCFS_SUCCESS);
+
+    if( FLASH_ErasePage( baseaddr + offset ) != FLASH_COMPLETE )
+        return(RCFS_ERROR);
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Program a VTOC entry                                            */
+/** @param[in] toc pointer to the VTOC entry                                   */
+/** @param[in] addr offset of the file from the start of the file system       */
+/** @param[in] size the file size including the header, -1 to leave it erased  */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Programmed a half word at a time, the size then the top of the address.
+ *  The bottom of the address is last and commits the entry, a file address
+ *  is even so an entry is not used until that half word is programmed.
+ *  Half words that are already programmed are skipped so an entry left
+ *  part written by a reset can be finished.
+ */
+
+static int
+RCFS_VtocCommit( long *toc, long addr, long size )
+{
+    unsigned short *p;
+    short i;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    long tmp = (long)toc;
+    p = (unsigned short *)tmp;
+
+    // size low and high, then address high and low
+    for(i=(size == (-1)) ? 2 : 0;i<4;i++)
+        {
+        if( (i == 0) && (p[2] == 0xFFFF) )
+            FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)&p[2], size & 0xFFFF );
+        if( (i == 1) && (p[3] == 0xFFFF) )
+            FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)&p[3], (size >> 16) & 0xFFFF );
+        if( (i == 2) && (p[1] == 0xFFFF) )
+            FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)&p[1], (addr >> 16) & 0xFFFF );
+        if( (i == 3) && (p[0] == 0xFFFF) )
+            FLASHStatus = FLASH_ProgramHalfWord( (uint32_t)&p[0], addr & 0xFFFF );
+
+        if( FLASHStatus != FLASH_COMPLETE )
+            {
+            RCFS_WriteError( FLASHStatus, (uint32_t)p );
+            return(RCFS_ERROR);
+            }
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+#ifdef RCFS_COMPACT
+/** @cond    */
+// Compaction journal, the magic is written once the plan has been saved
+// and the flags are half words programmed to 0 as each step is completed
+#define RCFS_JOURNAL_MAGIC      0x504D4F43
+#define RCFS_JOURNAL_START      1
+#define RCFS_JOURNAL_NEWEND     2
+#define RCFS_JOURNAL_OLDEND     3
+#define RCFS_JOURNAL_DELETED    4
+#define RCFS_JOURNAL_SLOT       5
+#define RCFS_JOURNAL_MOVED      6
+#define RCFS_JOURNAL_FLAGS      32
+
+// The deleted and moved files are each saved in the journal as one bit per
+// VTOC slot in a 32 bit word
+#if kMaxNumbofFlashFiles > 32
+#error "RCFS_Compact needs kMaxNumbofFlashFiles of 32 or less, define RCFS_NO_COMPACT"
+#endif
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Compaction plan                                                   */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Files are packed down in address order from the start of the first page
+ *  that can change.  The plan only depends on the VTOC entries in use when
+ *  it was made, which are not changed until all files have been moved, and
+ *  the list of deleted files saved in the journal, so it can be worked out
+ *  again after a power loss.
+ */
+
+typedef struct _rcfs_compact {
+             short count;                  ///< number of files that can move
+             long  start;                  ///< offset of the first page that can change
+             long  newend;                 ///< offset after the last file once packed
+             long  oldend;                 ///< offset after the last file now
+    unsigned long  deleted;                ///< bit for each deleted VTOC slot
+             long  src[kMaxNumbofFlashFiles];  ///< file offset now
+             long  dst[kMaxNumbofFlashFiles];  ///< file offset once packed
+             long  size[kMaxNumbofFlashFiles]; ///< file size including header
+             short slot[kMaxNumbofFlashFiles]; ///< VTOC slot of the file
+    } rcfs_compact;
+
+static  rcfs_compact compact_plan;
+static  short        compact_checked = 0;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Work out where each file will go                                */
+/** @param[in] deleted bit for each deleted VTOC slot                          */
+/** @param[in] slots number of VTOC entries used when the plan was made        */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_CompactPlan( unsigned long deleted, short slots )
+{
+    long *toc = (long *)(baseaddr + VTOC_OFFSET);
+    long  addr;
+    long  size;
+    long  next;
+    short slot;
+    short i, j, n;
+
+    compact_plan.deleted = deleted;
+    compact_plan.oldend  = RCFS_DATA_OFFSET;
+    n = 0;
+
+    for(slot=0;slot<slots;slot++)
+        {
+        addr = *toc++;
+        size = *toc++;
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            break;
+        if( size == (-1) )
+            size = 0;
+
+        // cleared by an earlier compaction
+        if( addr == 0 )
+            continue;
+
+        // deleted files still use space until they are moved over
+        if( (addr + size) > compact_plan.oldend )
+            compact_plan.oldend = addr + size;
+
+        if( deleted & ((unsigned long)1 << slot) )
+            continue;
+
+        // insert in address order
+        for(i=n;(i > 0) && (compact_plan.src[i-1] > addr);i--)
+            {
+            compact_plan.src[i]  = compact_plan.src[i-1];
+            compact_plan.size[i] = compact_plan.size[i-1];
+            compact_plan.slot[i] = compact_plan.slot[i-1];
+            }
+        compact_plan.src[i]  = addr;
+        compact_plan.size[i] = size;
+        compact_plan.slot[i] = slot;
+        n++;
+        }
+
+    // ROBOTC's files never move, nor does anything on the same page
+    compact_plan.start = RCFS_DATA_OFFSET;
+    for(i=0;(i < n) && (compact_plan.src[i] < compact_plan.start);i++)
+        {
+        next = (compact_plan.src[i] + compact_plan.size[i] + RCFS_PAGE_SIZE - 1) & ~(RCFS_PAGE_SIZE - 1);
+        if( next > compact_plan.start )
+            compact_plan.start = next;
+        }
+
+    // pack the rest on word boundaries
+    next = compact_plan.start;
+    for(j=0;i<n;i++,j++)
+        {
+        if(next & 1)
+            next++;
+        compact_plan.src[j]  = compact_plan.src[i];
+        compact_plan.size[j] = compact_plan.size[i];
+        compact_plan.slot[j] = compact_plan.slot[i];
+        compact_plan.dst[j]  = next;
+        next += compact_plan.size[j];
+        }
+
+    compact_plan.count  = j;
+    compact_plan.newend = next;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check for a compaction that was not finished                    */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_JournalValid()
+{
+    long *journal;
+
+    long tmp = baseaddr + RCFS_JOURNAL_OFFSET;
+    journal = (long *)tmp;
+
+    if( journal[0] != RCFS_JOURNAL_MAGIC )
+        return(0);
+
+    if( (journal[RCFS_JOURNAL_START]  <  RCFS_DATA_OFFSET) ||
+        (journal[RCFS_JOURNAL_NEWEND] <  journal[RCFS_JOURNAL_START]) ||
+        (journal[RCFS_JOURNAL_OLDEND] <  journal[RCFS_JOURNAL_NEWEND]) ||
+        (journal[RCFS_JOURNAL_OLDEND] >  RCFS_DATA_END) ||
+        (journal[RCFS_JOURNAL_SLOT]   <  0) ||
+        (journal[RCFS_JOURNAL_SLOT]   >  kMaxNumbofFlashFiles) )
+        return(0);
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check a journal flag                                            */
+/** @param[in] n the flag number                                               */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_JournalFlag( short n )
+{
+    long tmp = baseaddr + RCFS_JOURNAL_OFFSET + RCFS_JOURNAL_FLAGS + (n * 2);
+
+    return( *(unsigned short *)tmp == 0 );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Set a journal flag                                              */
+/** @param[in] n the flag number                                               */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_JournalSet( short n )
+{
+    if( FLASH_ProgramHalfWord( baseaddr + RCFS_JOURNAL_OFFSET + RCFS_JOURNAL_FLAGS + (n * 2), 0 ) != FLASH_COMPLETE )
+        return(RCFS_ERROR);
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Copy data within the file system                                */
+/** @param[in] dest offset of the erased destination                           */
+/** @param[in] src offset of the source                                        */
+/** @param[in] length number of bytes, rounded up to a half word               */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Erased half words in the source are not programmed.
+ */
+
+static int
+RCFS_CopyFlash( long dest, long src, long length )
+{
+    unsigned short *q;
+    long  n;
+    int   run;
+    uint32_t failaddr;
+
+    long tmp = baseaddr + src;
+    q = (unsigned short *)tmp;
+
+    n = (length + 1) / 2;
+    while( n > 0 )
+        {
+        if( *q == 0xFFFF )
+            {
+            q++;
+            dest += 2;
+            n--;
+            continue;
+            }
+
+        // up to 128 half words that are not erased
+        for(run=1;(run < n) && (run < 128) && (q[run] != 0xFFFF);run++)
+            ;
+
+        if( FLASH_ProgramBuffer( baseaddr + dest, q, run, &failaddr ) != FLASH_COMPLETE )
+            return(RCFS_ERROR);
+
+        q    += run;
+        dest += run * 2;
+        n    -= run;
+
+        abortTimeslice();
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check if a page is already as it will be after compaction       */
+/** @param[in] page offset of the page from the start of the file system       */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_CompactSame( long page )
+{
+    long  a;
+    short i;
+
+    for(i=0;i<compact_plan.count;i++)
+        {
+        if( (compact_plan.dst[i] < (page + RCFS_PAGE_SIZE)) &&
+            ((compact_plan.dst[i] + compact_plan.size[i]) > page) &&
+            (compact_plan.dst[i] != compact_plan.src[i]) )
+            return(0);
+        }
+
+    // anything after the last file must be erased
+    a = (compact_plan.newend + 1) & ~1;
+    if( a < page )
+        a = page;
+
+    for(;a<(page + RCFS_PAGE_SIZE);a+=2)
+        {
+        long tmp = baseaddr + a;
+        if( *(unsigned short *)tmp != 0xFFFF )
+            return(0);
+        }
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Build the new contents of a page in the staging page            */
+/** @param[in] page offset of the page from the start of the file system       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Files only move down so everything needed is in this page or later pages,
+ *  none of which have been changed yet.
+ */
+
+static int
+RCFS_CompactStage( long page )
+{
+    long  a, b;
+    short i;
+
+    if( RCFS_ErasePage( RCFS_STAGING_OFFSET ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    for(i=0;i<compact_plan.count;i++)
+        {
+        // part of this file in the page
+        a = compact_plan.dst[i];
+        b = compact_plan.dst[i] + compact_plan.size[i];
+        if( a < page )
+            a = page;
+        if( b > (page + RCFS_PAGE_SIZE) )
+            b = page + RCFS_PAGE_SIZE;
+        if( a >= b )
+            continue;
+
+        if( RCFS_CopyFlash( RCFS_STAGING_OFFSET + (a - page), compact_plan.src[i] + (a - compact_plan.dst[i]), b - a ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add VTOC entries for the files that moved                       */
+/** @param[in] slot first VTOC slot that was free when the plan was made       */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The VTOC shares its page with the file system header and the start of
+ *  the user program so it is never erased.  A file that moved is given a
+ *  new entry after the ones in the plan, entries already programmed by a
+ *  compaction stopped by a power loss are skipped.
+ */
+
+static int
+RCFS_CompactEntries( short slot )
+{
+    long *toc = (long *)(baseaddr + VTOC_OFFSET + (slot * 8));
+    short i;
+
+    for(i=0;i<compact_plan.count;i++)
+        {
+        if( compact_plan.dst[i] == compact_plan.src[i] )
+            continue;
+
+        if( RCFS_VtocCommit( toc, compact_plan.dst[i], compact_plan.size[i] ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        toc += 2;
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Clear the VTOC entries of deleted files and files that moved    */
+/** @param[in] slots number of VTOC entries used when the plan was made        */
+/** @param[in] clear bit for each VTOC slot to clear                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The address and size are programmed to 0, which flash allows without an
+ *  erase.  The bottom of the address is cleared first so a part cleared
+ *  entry still points inside the file system.
+ */
+
+static int
+RCFS_CompactClear( short slots, unsigned long clear )
+{
+    unsigned short *p;
+    short slot;
+    short i;
+
+    long tmp = baseaddr + VTOC_OFFSET;
+    p = (unsigned short *)tmp;
+
+    for(slot=0;slot<slots;slot++,p+=4)
+        {
+        if( !(clear & ((unsigned long)1 << slot)) )
+            continue;
+
+        // address low and high, then size low and high
+        for(i=0;i<4;i++)
+            {
+            if( (p[i] != 0) && (FLASH_ProgramHalfWord( (uint32_t)&p[i], 0 ) != FLASH_COMPLETE) )
+                return(RCFS_ERROR);
+            }
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Reclaim the space used by deleted files                         */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Files after a deleted file are moved down a page at a time through the
+ *  staging page and the pages after the last file are erased.  The VTOC page
+ *  is never erased, each file that moved gets a new VTOC entry and the old
+ *  entries are cleared.  Each step is recorded in the journal, if power is
+ *  lost the compaction is finished the next time the file system is used.
+ *
+ *  VTOC entries are not reused, so it fails without changing anything if
+ *  there are not enough free entries for the files that would move.  It
+ *  also fails if a file is open for writing, a file left open by a reset
+ *  has not been closed by RCFS_Recover or a file uses the journal or
+ *  staging pages.  Every page after the first deleted file is erased twice
+ *  so this can take several seconds, call it when the robot is disabled.
+ */
+
+int
+RCFS_Compact()
+{
+    long *toc;
+    long *journal;
+    unsigned long deleted;
+    unsigned long moved;
+    long  addr;
+    long  size;
+    long  page;
+    short pages;
+    short slot;
+    short count;
+    short n;
+
+    if( write_stream.open )
+        return(RCFS_ERROR);
+
+    if( RCFS_Probe() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+    toc = (long *)(baseaddr + VTOC_OFFSET);
+
+    compact_checked = 1;
+
+    long tmp = baseaddr + RCFS_JOURNAL_OFFSET;
+    journal = (long *)tmp;
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    if( !RCFS_JournalValid() )
+        {
+        deleted = 0;
+
+        for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
+            {
+            addr = *toc++;
+            size = *toc++;
+
+            // End of table ?
+            if( RCFS_VtocEnd( addr ) )
+                break;
+
+            // File that has not been closed, RCFS_Recover closes it first
+            if( size == (-1) )
+                return(RCFS_ERROR);
+
+            if( (addr != 0) && RCFS_Deleted( addr ) )
+                deleted |= ((unsigned long)1 << slot);
+            }
+
+        RCFS_CompactPlan( deleted, slot );
+        size = compact_plan.newend;
+
+        if( compact_plan.oldend > RCFS_DATA_END )
+            return(RCFS_ERROR);
+
+        // Files that move need new VTOC entries
+        moved = 0;
+        count = 0;
+        for(n=0;n<compact_plan.count;n++)
+            {
+            if( compact_plan.dst[n] != compact_plan.src[n] )
+                {
+                moved |= ((unsigned long)1 << compact_plan.slot[n]);
+                count++;
+                }
+            }
+
+        // Nothing to do ?
+        if( (deleted == 0) && (moved == 0) )
+            return(RCFS_SUCCESS);
+        if( (slot + count) > kMaxNumbofFlashFiles )
+            return(RCFS_ERROR);
+
+        // save the plan
+        if( (RCFS_ErasePage( RCFS_JOURNAL_OFFSET ) != RCFS_SUCCESS) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_START],   compact_plan.start )  != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_NEWEND],  compact_plan.newend ) != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_OLDEND],  compact_plan.oldend ) != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_DELETED], deleted )             != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_SLOT],    slot )                != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[RCFS_JOURNAL_MOVED],   moved )               != FLASH_COMPLETE) ||
+            (FLASH_ProgramWord( (uint32_t)&journal[0], RCFS_JOURNAL_MAGIC ) != FLASH_COMPLETE) )
+            return(RCFS_ERROR);
+        }
+    else
+        {
+        // the entries in the plan have not changed unless all files have moved
+        RCFS_CompactPlan( journal[RCFS_JOURNAL_DELETED], journal[RCFS_JOURNAL_SLOT] );
+        size = compact_plan.newend;
+        compact_plan.start  = journal[RCFS_JOURNAL_START];
+        compact_plan.newend = journal[RCFS_JOURNAL_NEWEND];
+        compact_plan.oldend = journal[RCFS_JOURNAL_OLDEND];
+        }
+
+    pages = (compact_plan.newend - compact_plan.start + RCFS_PAGE_SIZE - 1) / RCFS_PAGE_SIZE;
+
+    // the plan must match the journal until the new VTOC entries are added
+    if( !RCFS_JournalFlag( pages * 2 ) && (size != compact_plan.newend) )
+        return(RCFS_ERROR);
+
+    // Move the files, two flags for each page, staged and done
+    for(n=0;n<pages;n++)
+        {
+        if( RCFS_JournalFlag( (n * 2) + 1 ) )
+            continue;
+
+        page = compact_plan.start + (n * RCFS_PAGE_SIZE);
+
+        if( !RCFS_JournalFlag( n * 2 ) )
+            {
+            if( RCFS_CompactSame( page ) )
+                {
+                if( RCFS_JournalSet( (n * 2) + 1 ) != RCFS_SUCCESS )
+                    return(RCFS_ERROR);
+                continue;
+                }
+
+            if( (RCFS_CompactStage( page ) != RCFS_SUCCESS) ||
+                (RCFS_JournalSet( n * 2 ) != RCFS_SUCCESS) )
+                return(RCFS_ERROR);
+            }
+
+        size = compact_plan.newend - page;
+        if( size > RCFS_PAGE_SIZE )
+            size = RCFS_PAGE_SIZE;
+
+        if( (RCFS_ErasePage( page ) != RCFS_SUCCESS) ||
+            (RCFS_CopyFlash( page, RCFS_STAGING_OFFSET, size ) != RCFS_SUCCESS) ||
+            (RCFS_JournalSet( (n * 2) + 1 ) != RCFS_SUCCESS) )
+            return(RCFS_ERROR);
+        }
+
+    // New VTOC entries for the files that moved, then clear the old ones
+    if( !RCFS_JournalFlag( pages * 2 ) )
+        {
+        if( (RCFS_CompactEntries( journal[RCFS_JOURNAL_SLOT] ) != RCFS_SUCCESS) ||
+            (RCFS_JournalSet( pages * 2 ) != RCFS_SUCCESS) )
+            return(RCFS_ERROR);
+        }
+
+    if( !RCFS_JournalFlag( (pages * 2) + 1 ) )
+        {
+        if( (RCFS_CompactClear( journal[RCFS_JOURNAL_SLOT], journal[RCFS_JOURNAL_DELETED] | journal[RCFS_JOURNAL_MOVED] ) != RCFS_SUCCESS) ||
+            (RCFS_JournalSet( (pages * 2) + 1 ) != RCFS_SUCCESS) )
+            return(RCFS_ERROR);
+        }
+
+    // Erase the old files after the last page
+    if( !RCFS_JournalFlag( (pages * 2) + 2 ) )
+        {
+        for(page=compact_plan.start + (pages * RCFS_PAGE_SIZE);page<compact_plan.oldend;page+=RCFS_PAGE_SIZE)
+            {
+            if( RCFS_ErasePage( page ) != RCFS_SUCCESS )
+                return(RCFS_ERROR);
+            }
+
+        if( RCFS_JournalSet( (pages * 2) + 2 ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    // Finished, the journal is erased last
+    if( (RCFS_ErasePage( RCFS_STAGING_OFFSET ) != RCFS_SUCCESS) ||
+        (RCFS_ErasePage( RCFS_JOURNAL_OFFSET ) != RCFS_SUCCESS) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Finish a compaction stopped by a power loss                     */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Called before the file system is first used, files may be in the wrong
+ *  place until this has been done.
+ */
+
+static void
+RCFS_CompactCheck()
+{
+    if( compact_checked )
+        return;
+    compact_checked = 1;
+
+    if( RCFS_JournalValid() && !write_stream.open )
+        RCFS_Compact();
+}
+#else
+static void
+RCFS_CompactCheck()
+{
+}
+#endif  // RCFS_COMPACT
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Finish or remove a file being added when the cortex was reset   */
+/** @returns   1 if the file system was changed, 0 if nothing needed doing     */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  RCFS_AddFile programs the data and header before the VTOC entry.  If the
+ *  size in the first unused entry has been programmed the file is complete
+ *  and the entry is committed.  Otherwise anything after the last file is
+ *  part of a file that was never committed, it is marked as a deleted file
+ *  so the space is skipped until RCFS_Compact.  Streamed files that were
+ *  not closed are closed at the last byte written.
+ *
+ *  Called automatically the first time the file system is used, this reads
+ *  up to MAX_FLASH_FILE_SIZE bytes after the last file.
+ */
+
+int
+RCFS_Recover()
+{
+    long *toc;
+    unsigned short *p;
+    long  addr;
+    long  size    = 0;
+    long  maxaddr = 0;
+    long  next    = 0;
+    long  length;
+    short slot;
+    short written;
+    short closed  = 0;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    if( write_stream.open || (RCFS_Probe() != RCFS_SUCCESS) )
+        return(0);
+    toc = (long *)(baseaddr + VTOC_OFFSET);
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(0);
+
+    // Find the first entry that has not been committed
+    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
+        {
+        addr = *toc;
+        if( RCFS_VtocEnd( addr ) )
+            break;
+
+        // Close a file left open, stop on a write error
+        size = *(toc + 1);
+        if( size == (-1) )
+            {
+            closed = 1;
+            if( (size = RCFS_StreamFinish( slot, addr, toc )) < 0 )
+                break;
+            }
+
+        if( addr > maxaddr )
+            {
+            maxaddr = addr;
+            next    = addr + size;
+            }
+        toc += 2;
+        }
+
+    if( (slot >= kMaxNumbofFlashFiles) || (size < 0) )
+        {
+#ifdef RCFS_VTOC_CACHE
+        if( closed )
+            RCFS_CacheInvalidate();
+#endif
+        return(closed);
+        }
+
+    if(next & 1)
+        next++;
+    if(next < RCFS_DATA_OFFSET)
+        next = RCFS_DATA_OFFSET;
+
+    // The file was written if the size was started, files added are
+    // smaller than 64K
+    size    = *(toc + 1) & 0xFFFF;
+    written = (size != 0xFFFF);
+    if( !written )
+        {
+        // Look for data or a header written after the last file
+        length = FLASH_FILE_HEADER_SIZE + MAX_FLASH_FILE_SIZE;
+        if( length > (RCFS_DATA_END - next) )
+            length = RCFS_DATA_END - next;
+        if( length < 0 )
+            length = 0;
+        length /= 2;
+
+        long tmp = baseaddr + next;
+        p = (unsigned short *)tmp;
+
+        while( (length > 0) && (p[length-1] == 0xFFFF) )
+            length--;
+
+        // the top of the address blocks the entry even if nothing was written
+        if( (length == 0) && (addr == (-1)) )
+            {
+#ifdef RCFS_VTOC_CACHE
+            if( closed )
+                RCFS_CacheInvalidate();
+#endif
+            return(closed);
+            }
+
+        size = length * 2;
+        if( size < FLASH_FILE_HEADER_SIZE )
+            size = FLASH_FILE_HEADER_SIZE;
+        }
+
+    // delete an uncommitted file before it is in the VTOC
+    if( !written )
+        FLASHStatus = FLASH_ProgramHalfWord( baseaddr + next, 0 );
+
+    if( FLASHStatus == FLASH_COMPLETE )
+        RCFS_VtocCommit( toc, next, size );
+
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Finish anything stopped by a reset                              */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR if the layout is not known           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Called before the file system is used.
+ */
+
+static  short   boot_checked = 0;
+
+static int
+RCFS_BootCheck()
+{
+    if( RCFS_Probe() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    if( boot_checked )
+        return(RCFS_SUCCESS);
+    boot_checked = 1;
+
+    RCFS_CompactCheck();
+    RCFS_Recover();
+
+    return(RCFS_SUCCESS);
+}
+
+#ifdef RCFS_VTOC_CACHE
+/*-----------------------------------------------------------------------------*/
+/** @brief     Build the VTOC cache                                            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  This is called automatically the first time the cache is needed, call
+ *  it during initialization to avoid the delay later.  A file or compaction
+ *  stopped by a reset is finished first.
+ */
+
+void
+RCFS_CacheInit()
+{
+    long *toc;
+    long  addr;
+    long  size;
+    short slot;
+    int   status;
+
+    // finish anything stopped by a reset before it is cached
+    status = RCFS_BootCheck();
+
+    vtoc_cache.count    = 0;
+    vtoc_cache.maxaddr  = 0;
+    vtoc_cache.nextaddr = 0;
+    vtoc_cache.deleted  = 0;
+    for(slot=0;slot<RCFS_HASH_SIZE;slot++)
+        vtoc_cache.bucket[slot] = RCFS_ERROR;
+
+    // nothing is cached if the layout is not known
+    vtoc_cache.valid = 1;
+    if( status != RCFS_SUCCESS )
+        return;
+    toc = (long *)(baseaddr + VTOC_OFFSET);
+
+    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
+        {
+        // Read file address
+        addr = *toc++;
+        // read file size
+        size = *toc++;
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            break;
+
+        // File that has not been closed
+        if( size == (-1) )
+            size = RCFS_StreamSize( slot, addr );
+
+        RCFS_CacheAdd( slot, addr, size );
+        }
+
+    vtoc_cache.valid = 1;
+}
+#endif  // RCFS_VTOC_CACHE
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open the directory for reading                                  */
+/** @param[in] d pointer to a directory cursor                                 */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_DirOpen( rcfs_dir *d )
+{
+    if( d == NULL )
+        return(RCFS_ERROR);
+
+    // finish a compaction or a file stopped by a power loss
+    if( RCFS_BootCheck() != RCFS_SUCCESS )
+        {
+        d->toc = NULL;
+        return(RCFS_ERROR);
+        }
+
+    d->slot = 0;
+    d->toc  = (long *)(baseaddr + VTOC_OFFSET);
+    d->addr = 0;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Move a directory cursor to a VTOC slot                          */
+/** @param[in] d pointer to an open directory cursor                           */
+/** @param[in] slot the slot that the next call to RCFS_DirNext will read      */
+/*-----------------------------------------------------------------------------*/
+
+static void
+RCFS_DirSeek( rcfs_dir *d, short slot )
+{
+    d->slot = slot;
+    d->toc  = (long *)(baseaddr + VTOC_OFFSET + (slot * 8));
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read the next file in the directory                             */
+/** @param[in] d pointer to an open directory cursor                           */
+/** @param[in] f pointer to a flash file header, may be NULL                   */
+/** @returns   The VTOC slot of the file or RCFS_ERROR at the end of the table */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The cursor remembers its position so each call only reads one VTOC entry
+ *  and one file header.  Pass NULL for f to step over a file without reading
+ *  the header.
+ */
+
+int
+RCFS_DirNext( rcfs_dir *d, flash_file *f )
+{
+    long  addr;
+    long  size;
+    short slot;
+
+    if( d == NULL || d->toc == NULL )
+        return(RCFS_ERROR);
+
+    // deleted files are skipped
+    do  {
+        // more than kMaxNumbofFlashFiles files we have an error
+        if( (d->slot < 0) || (d->slot >= kMaxNumbofFlashFiles) )
+            return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+        if( !vtoc_cache.valid )
+            RCFS_CacheInit();
+
+        // End of table ?
+        if( d->slot >= vtoc_cache.count )
+            return(RCFS_ERROR);
+
+        addr = vtoc_cache.entry[d->slot].addr - baseaddr;
+        size = vtoc_cache.entry[d->slot].size;
+#else
+        // Read file address
+        addr = *(d->toc);
+        // read file size
+        size = *(d->toc + 1);
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            return(RCFS_ERROR);
+
+        // File that has not been closed
+        if( size == (-1) )
+            size = RCFS_StreamSize( d->slot, addr );
+#endif
+
+        // move cursor to the next entry
+        slot = d->slot++;
+        d->toc += 2;
+        } while( RCFS_Deleted( addr ) );
+
+    d->addr = baseaddr + addr;
+
+    if( f != NULL )
+        {
+        f->addr       = baseaddr + addr;
+        f->data       = (unsigned char *)(f->addr + FLASH_FILE_HEADER_SIZE);
+        f->datalength = (size - FLASH_FILE_HEADER_SIZE);
+        f->slot       = slot;
+
+        // Read header
+        RCFS_ReadHeader( f );
+        }
+
+    return(slot);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Close a directory cursor                                        */
+/** @param[in] d pointer to a directory cursor                                 */
+/*-----------------------------------------------------------------------------*/
+
+void
+RCFS_DirClose( rcfs_dir *d )
+{
+    if( d == NULL )
+        return;
+
+    d->slot = kMaxNumbofFlashFiles;
+    d->toc  = NULL;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read flash file table of contents and print in debug window     */
+/*-----------------------------------------------------------------------------*/
+
+void
+RCFS_ReadVTOC()
+{
+    rcfs_dir    d;
+    flash_file  f;
+
+    RCFS_DirOpen( &d );
+
+    while( RCFS_DirNext( &d, &f ) >= 0 )
+        {
+        // Display
+        RCFS_DebugFile( &f );
+        }
+
+    RCFS_DirClose( &d );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the number of the next free slot in the file system        */
+/*-----------------------------------------------------------------------------*/
+static int
+RCFS_FindLastSlot()
+{
+    if( RCFS_BootCheck() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+    if( !vtoc_cache.valid )
+        RCFS_CacheInit();
+
+    if( vtoc_cache.count < kMaxNumbofFlashFiles )
+        return( vtoc_cache.count );
+#else
+    long *toc = (long *)(baseaddr + VTOC_OFFSET);
+    long  addr;
+    short slot;
+
+    // more than kMaxNumbofFlashFiles files we have an error
+    for(slot=0;slot<kMaxNumbofFlashFiles;slot++)
+        {
+        // Read next file address
+        addr = *toc;
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            {
+            return(slot);
+            }
+        else
+            {
+            // Valid file found
+            toc+=2;
+            }
+        }
+#endif
+
+    return(RCFS_ERROR);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the first file in the file system                          */
+/** @param[in] f pointer to a flash file header                                */
+/*-----------------------------------------------------------------------------*/
+int
+RCFS_FindFirstFile( flash_file *f )
+{
+    rcfs_dir    d;
+
+    if( f == NULL )
+        return(RCFS_ERROR);
+
+    RCFS_DirOpen( &d );
+
+    // slot should be 0
+    return( RCFS_DirNext( &d, f ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find the next file in the file system                           */
+/** @param[in] f pointer to a flash file header                                */
+/*-----------------------------------------------------------------------------*/
+int
+RCFS_FindNextFile( flash_file *f )
+{
+    rcfs_dir    d;
+
+    if( f == NULL )
+        return(RCFS_ERROR);
+
+    RCFS_DirOpen( &d );
+
+    // the slot from the last call is normally still good
+    if( (f->slot > 0) && (f->slot < kMaxNumbofFlashFiles) )
+        RCFS_DirSeek( &d, f->slot );
+
+    if( (RCFS_DirNext( &d, NULL ) < 0) || (d.addr != f->addr) )
+        {
+        // search for the starting file
+        RCFS_DirOpen( &d );
+        do  {
+            if( RCFS_DirNext( &d, NULL ) < 0 )
+                return(RCFS_ERROR);
+            } while( d.addr != f->addr );
+        }
+
+    // Get next file
+    return( RCFS_DirNext( &d, f ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find where the next file will be written                        */
+/** @param[out] slot the VTOC slot for the next file                           */
+/** @param[out] nextaddr offset of the next file from the file system start    */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Nothing can be added while a file is open for writing as it owns all of
+ *  the space after the last file.
+ */
+
+static int
+RCFS_FindFreeSpace( short *slot, long *nextaddr )
+{
+    short s;
+
+    long  next = 0;
+
+    if( write_stream.open )
+        return(RCFS_ERROR);
+
+    if( RCFS_BootCheck() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+    if( !vtoc_cache.valid )
+        RCFS_CacheInit();
+
+    // The cache knows the end of the table and the last file
+    s    = vtoc_cache.count;
+    next = vtoc_cache.nextaddr;
+#else
+    long *toc;
+    long  addr;
+    long  size;
+    long  maxaddr  = 0;
+
+    toc = (long *)(baseaddr + VTOC_OFFSET);
+
+    // more than kMaxNumbofFlashFiles files we have an error
+    for(s=0;s<kMaxNumbofFlashFiles;s++)
+        {
+        // Read next file address
+        addr = *toc;
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            break;
+
+        // Valid file found
+        toc++;
+        size = *toc++;
+
+        // File that has not been closed
+        if( size == (-1) )
+            size = RCFS_StreamSize( s, addr );
+
+        // Last file in memory ?
+        if( addr > maxaddr )
+            {
+            // maximum address found
+            maxaddr = addr;
+            // Address after this file
+            next = addr + size;
+            }
+        }
+#endif
+
+    // No more VTOC space
+    if( s >= kMaxNumbofFlashFiles )
+        return(RCFS_ERROR);
+
+    // Start on Word boundary
+    if(next & 1)
+        next++;
+
+    // move us into high menory
+    if(next < RCFS_DATA_OFFSET)
+        next = RCFS_DATA_OFFSET;
+
+    *slot     = s;
+    *nextaddr = next;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open a file for streaming writes                                */
+/** @param[in] name name of the file to be written                             */
+/** @param[in] flags RCFS_FILE_xxx flags to add to the header                  */
+/** @returns   A handle for the file or RCFS_ERROR                             */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_StreamOpen( char *name, short flags )
+{
+    long *toc;
+    short slot;
+
+    long  nextaddr = 0;
+    long  maxlength;
+
+    uint32_t failaddr;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+    flash_file   f;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    // Find the VTOC slot and address for the file
+    if( RCFS_FindFreeSpace( &slot, &nextaddr ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+    toc = (long *)(baseaddr + VTOC_OFFSET + (slot * 8));
+
+    // Space for data
+    maxlength = RCFS_DATA_END - nextaddr - FLASH_FILE_HEADER_SIZE;
+    if( maxlength > RCFS_STREAM_MAX_SIZE )
+        maxlength = RCFS_STREAM_MAX_SIZE;
+    if( maxlength <= 0 )
+        return(RCFS_ERROR);
+
+    // create new file
+    RCFS_FileInit( &f );
+
+    // Copy name, max 15 chars
+    strncpy( (char *)&f.name[0], name, 15 );
+
+    // CRC is written when the file is closed
+    f.time[0] = RCFS_FILE_MARK | RCFS_FILE_CRC | flags;
+    f.time[1] = 0xFF;
+    f.time[2] = 0xFF;
+    f.time[3] = 0xFF;
+    f.unknown = 0xFF;
+
+#ifdef RCFS_COMPRESS
+    // size before compression is written when the file is closed
+    if( RCFS_LzEnabled() )
+        {
+        f.time[0] |= RCFS_FILE_LZ;
+        f.pad[0]  = 0xFF;
+        f.pad[1]  = 0xFF;
+        memset( &lz_encoder, 0, sizeof(lz_encoder) );
+        }
+#endif
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    // Write header, a header without a VTOC entry is removed by RCFS_Recover
+    FLASHStatus = FLASH_ProgramBuffer( baseaddr + nextaddr, (unsigned short *)&(f.name[0]), FLASH_FILE_HEADER_SIZE/2, &failaddr );
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, failaddr );
+        return(RCFS_ERROR);
+        }
+
+    // write table of contents entry, size is left erased until the file is closed
+    if( RCFS_VtocCommit( toc, nextaddr, -1 ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    write_stream.open      = 1;
+    write_stream.slot      = slot;
+    write_stream.addr      = baseaddr + nextaddr;
+    write_stream.length    = 0;
+    write_stream.written   = 0;
+    write_stream.maxlength = maxlength;
+    write_stream.head      = 0;
+    write_stream.tail      = 0;
+    write_stream.count     = 0;
+    write_stream.logical   = 0;
+    write_stream.crc       = 0xFFFFFFFF;
+#ifdef RCFS_COMPRESS
+    write_stream.lz        = RCFS_LzEnabled();
+#else
+    write_stream.lz        = 0;
+#endif
+
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheAdd( slot, nextaddr, FLASH_FILE_HEADER_SIZE );
+#endif
+
+    return(slot);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open a file for streaming writes                                */
+/** @param[in] name name of the file to be written                             */
+/** @returns   A handle for the file or RCFS_ERROR                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The VTOC entry and file header are written immediately, data is then added
+ *  with RCFS_Append and the size is written by RCFS_Close.  The file can use
+ *  all of the remaining space up to RCFS_STREAM_MAX_SIZE bytes.  Only one file
+ *  can be open at a time and no other files can be added until it is closed.
+ *
+ *  If the program stops before RCFS_Close the file is recovered the next time
+ *  the VTOC is read, data still in the ring buffer is lost.
+ */
+
+int
+RCFS_OpenWrite( char *name )
+{
+    return( RCFS_StreamOpen( name, 0 ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open a file for streaming writes                                */
+/** @returns   A handle for the file or RCFS_ERROR                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Open a file using the default filename
+ */
+
+int
+RCFS_OpenWrite()
+{
+    char name[16];
+    int  slot;
+
+    // Get the last file slot number
+    slot = RCFS_FindLastSlot();
+
+    // any room left ?
+    if( slot < 0 )
+        return(RCFS_ERROR);
+    // create default filename
+    sprintf( &name[0], "%s%03d", RCFS_BASENAME, slot);
+
+    return( RCFS_OpenWrite( name ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open a file of known length for streaming writes                */
+/** @param[in] name name of the file to be written                             */
+/** @param[in] length number of bytes that will be added                       */
+/** @returns   A handle for the file or RCFS_ERROR                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A file that cannot fit is refused before anything is programmed.  The
+ *  file is deleted rather than recovered if it is not closed, use
+ *  RCFS_Cancel if the data cannot all be written.
+ */
+
+int
+RCFS_OpenAdd( char *name, long length )
+{
+    short slot;
+    long  nextaddr = 0;
+
+    if( length < 0 )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    if( RCFS_LzEnabled() )
+        length = RCFS_LzWorstCase( length );
+#endif
+
+    if( length > RCFS_STREAM_MAX_SIZE )
+        return(RCFS_ERROR);
+
+    if( RCFS_FindFreeSpace( &slot, &nextaddr ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+    if( (nextaddr + FLASH_FILE_HEADER_SIZE + length) > RCFS_DATA_END )
+        return(RCFS_ERROR);
+
+    return( RCFS_StreamOpen( name, RCFS_FILE_ADD ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Program data from the ring buffer into flash                    */
+/** @param[in] maxbytes the maximum number of bytes to program                 */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Only whole half words are programmed, an odd byte is left in the buffer.
+ */
+
+static int
+RCFS_StreamDrain( int maxbytes )
+{
+    unsigned long addr;
+    int   run;
+    uint32_t failaddr;
+    FLASH_Status FLASHStatus;
+
+    if( maxbytes > write_stream.count )
+        maxbytes = write_stream.count;
+    maxbytes &= ~1;
+
+    while( maxbytes > 0 )
+        {
+        // bytes before the end of the buffer
+        run = RCFS_STREAM_BUFFER_SIZE - write_stream.tail;
+        if( run > maxbytes )
+            run = maxbytes;
+
+        addr = write_stream.addr + FLASH_FILE_HEADER_SIZE + write_stream.written;
+        FLASHStatus = FLASH_ProgramBuffer( addr, &write_stream.buffer[ write_stream.tail/2 ], run/2, &failaddr );
+        if( (FLASHStatus == FLASH_COMPLETE) && rcfs_verify )
+            FLASHStatus = FLASH_VerifyBuffer( addr, (unsigned char *)&write_stream.buffer[ write_stream.tail/2 ], run, &failaddr );
+        if( FLASHStatus != FLASH_COMPLETE )
+            {
+            RCFS_WriteError( FLASHStatus, failaddr );
+            return(RCFS_ERROR);
+            }
+
+        write_stream.tail += run;
+        if( write_stream.tail >= RCFS_STREAM_BUFFER_SIZE )
+            write_stream.tail = 0;
+        write_stream.count   -= run;
+        write_stream.written += run;
+        maxbytes -= run;
+        }
+
+#ifdef RCFS_VTOC_CACHE
+    vtoc_cache.entry[write_stream.slot].size = FLASH_FILE_HEADER_SIZE + write_stream.written;
+#endif
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a byte to the ring buffer                                   */
+/** @param[in] b the byte                                                      */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_StreamPut( unsigned char b )
+{
+    unsigned char *buf = (unsigned char *)&write_stream.buffer[0];
+
+    // buffer full, make some room
+    if( write_stream.count == RCFS_STREAM_BUFFER_SIZE )
+        {
+        if( RCFS_StreamDrain( RCFS_STREAM_BUFFER_SIZE ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    buf[ write_stream.head++ ] = b;
+    if( write_stream.head >= RCFS_STREAM_BUFFER_SIZE )
+        write_stream.head = 0;
+    write_stream.count++;
+    write_stream.length++;
+
+    write_stream.crc = RCFS_Crc32( write_stream.crc, &b, 1 );
+
+    return(RCFS_SUCCESS);
+}
+
+#ifdef RCFS_COMPRESS
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write the literals before the match                             */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_LzLiterals()
+{
+    rcfs_lz *z = &lz_encoder;
+    long  p;
+
+    if( z->lit == 0 )
+        return(RCFS_SUCCESS);
+
+    if( RCFS_StreamPut( z->lit - 1 ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    for(p=z->pos - z->mlen - z->lit;z->lit>0;p++,z->lit--)
+        {
+        if( RCFS_StreamPut( z->window[ p & (RCFS_LZ_WINDOW-1) ] ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write the match, a short match becomes literals                 */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_LzMatch()
+{
+    rcfs_lz *z = &lz_encoder;
+
+    if( z->mlen < RCFS_LZ_MIN_MATCH )
+        {
+        z->lit += z->mlen;
+        z->mlen = 0;
+        }
+    else
+        {
+        if( RCFS_LzLiterals() != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+
+        if( (RCFS_StreamPut( 0x80 | (z->mlen - RCFS_LZ_MIN_MATCH) ) != RCFS_SUCCESS) ||
+            (RCFS_StreamPut( z->moff - 1 ) != RCFS_SUCCESS) )
+            return(RCFS_ERROR);
+        z->mlen = 0;
+        }
+
+    if( z->lit >= RCFS_LZ_MAX_LITERAL )
+        return( RCFS_LzLiterals() );
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Compress a byte                                                 */
+/** @param[in] b the byte                                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A match is looked for using the hash of the last two bytes, it is then
+ *  extended a byte at a time for as long as the data repeats.
+ */
+
+static int
+RCFS_LzPut( unsigned char b )
+{
+    rcfs_lz *z = &lz_encoder;
+    unsigned char prev;
+    int   h;
+    long  d;
+
+    // extend the match
+    if( z->mlen > 0 )
+        {
+        if( (z->mlen < RCFS_LZ_MAX_MATCH) && (z->window[ (z->pos - z->moff) & (RCFS_LZ_WINDOW-1) ] == b) )
+            {
+            prev = z->window[ (z->pos - 1) & (RCFS_LZ_WINDOW-1) ];
+            z->hash[ ((prev << 4) + prev + b) & (RCFS_LZ_HASH_SIZE-1) ] = z->pos & 0xFFFF;
+            z->window[ z->pos & (RCFS_LZ_WINDOW-1) ] = b;
+            z->pos++;
+            z->mlen++;
+            return(RCFS_SUCCESS);
+            }
+
+        if( RCFS_LzMatch() != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+        }
+
+    z->window[ z->pos & (RCFS_LZ_WINDOW-1) ] = b;
+    z->lit++;
+
+    // look for an earlier copy of this byte and the one before
+    if( z->lit >= 2 )
+        {
+        prev = z->window[ (z->pos - 1) & (RCFS_LZ_WINDOW-1) ];
+        h = ((prev << 4) + prev + b) & (RCFS_LZ_HASH_SIZE-1);
+
+        d = (z->pos - z->hash[h]) & 0xFFFF;
+        z->hash[h] = z->pos & 0xFFFF;
+
+        if( (d > 0) && (d < z->pos) && (d < (RCFS_LZ_WINDOW-1)) &&
+            (z->window[ (z->pos - d) & (RCFS_LZ_WINDOW-1) ] == b) &&
+            (z->window[ (z->pos - d - 1) & (RCFS_LZ_WINDOW-1) ] == prev) )
+            {
+            z->lit -= 2;
+            z->mlen = 2;
+            z->moff = d;
+            }
+        }
+
+    z->pos++;
+
+    if( (z->mlen == 0) && (z->lit >= RCFS_LZ_MAX_LITERAL) )
+        return( RCFS_LzLiterals() );
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write everything still held by the encoder                      */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_LzFinish()
+{
+    if( (lz_encoder.mlen > 0) && (RCFS_LzMatch() != RCFS_SUCCESS) )
+        return(RCFS_ERROR);
+
+    return( RCFS_LzLiterals() );
+}
+#endif  // RCFS_COMPRESS
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Append data to a file opened with RCFS_OpenWrite                */
+/** @param[in] h handle returned by RCFS_OpenWrite                             */
+/** @param[in] data pointer to the data to be written                          */
+/** @param[in] length length of data in bytes                                  */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Data is programmed each time the ring buffer is half full.  Nothing is
+ *  written if the data will not fit in the file, for a compressed file that
+ *  is checked as if the data did not compress.  The last few hundred bytes
+ *  of a compressed file are held by the encoder until RCFS_Close.
+ */
+
+int
+RCFS_Append( int h, unsigned char *data, int length )
+{
+    int   i;
+
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+    if( (data == NULL) || (length < 0) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    if( write_stream.lz )
+        {
+        // Check there is room even if the data does not compress
+        if( ((write_stream.length + RCFS_LzWorstCase( lz_encoder.lit + lz_encoder.mlen + length )) > write_stream.maxlength) ||
+            ((write_stream.logical + length) > RCFS_LZ_MAX_SIZE) )
+            return(RCFS_ERROR);
+
+        for(i=0;i<length;i++)
+            {
+            if( RCFS_LzPut( data[i] ) != RCFS_SUCCESS )
+                return(RCFS_ERROR);
+            }
+        write_stream.logical += length;
+        }
+    else
+#endif
+        {
+        // Check if there is room for the data
+        if( (write_stream.length + length) > write_stream.maxlength )
+            return(RCFS_ERROR);
+
+        for(i=0;i<length;i++)
+            {
+            if( RCFS_StreamPut( data[i] ) != RCFS_SUCCESS )
+                return(RCFS_ERROR);
+            }
+        }
+
+    if( write_stream.count >= (RCFS_STREAM_BUFFER_SIZE/2) )
+        return( RCFS_StreamDrain( write_stream.count ) );
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Program buffered data for a file opened with RCFS_OpenWrite     */
+/** @param[in] h handle returned by RCFS_OpenWrite                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this to limit how much data can be lost if the program stops, an odd
+ *  byte stays in the buffer until more data is added or the file is closed.
+ */
+
+int
+RCFS_Flush( int h )
+{
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+    return( RCFS_StreamDrain( write_stream.count ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Bytes that can be added before the next flash page              */
+/** @param[in] h handle returned by RCFS_OpenWrite                             */
+/** @returns   Bytes left in the page or RCFS_ERROR                            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Never more than is left in the file, so 0 once the file is full.
+ *  Buffered data counts as written.
+ */
+
+long
+RCFS_StreamRoom( int h )
+{
+    long  room;
+
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+    room = RCFS_PAGE_SIZE - ((write_stream.addr + FLASH_FILE_HEADER_SIZE + write_stream.length) % RCFS_PAGE_SIZE);
+    if( room > (write_stream.maxlength - write_stream.length) )
+        room = write_stream.maxlength - write_stream.length;
+
+    return(room);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Close a file opened with RCFS_OpenWrite                         */
+/** @param[in] h handle returned by RCFS_OpenWrite                             */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  If anything cannot be programmed the file stays open, call RCFS_Abandon
+ *  to free the stream for the next file.
+ */
+
+int
+RCFS_Close( int h )
+{
+    unsigned char *buf = (unsigned char *)&write_stream.buffer[0];
+    long *toc;
+    unsigned long addr;
+    unsigned long crc;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    if( write_stream.lz && (RCFS_LzFinish() != RCFS_SUCCESS) )
+        return(RCFS_ERROR);
+#endif
+
+    if( RCFS_StreamDrain( write_stream.count ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    // Was it an odd number of bytes ?
+    if( write_stream.count == 1 )
+        {
+        // pad with 0xFF and write the last byte
+        unsigned short b = buf[ write_stream.tail ] | 0xFF00;
+        addr = write_stream.addr + FLASH_FILE_HEADER_SIZE + write_stream.written;
+        FLASHStatus = FLASH_ProgramHalfWord( addr, b );
+        write_stream.count    = 0;
+        write_stream.written += 1;
+        }
+
+    // write the size into the table of contents entry
+    toc = (long *)(baseaddr + VTOC_OFFSET + (write_stream.slot * 8));
+    if( FLASHStatus == FLASH_COMPLETE )
+        {
+        addr = (uint32_t)(toc + 1);
+        FLASHStatus = FLASH_ProgramWord( addr, write_stream.length + FLASH_FILE_HEADER_SIZE );
+        }
+
+    // the CRC into the header
+    crc = ~write_stream.crc;
+    if( FLASHStatus == FLASH_COMPLETE )
+        {
+        addr = write_stream.addr + RCFS_FILE_CRC_OFFSET;
+        FLASHStatus = FLASH_ProgramHalfWord( addr, crc & 0xFFFF );
+        }
+    if( FLASHStatus == FLASH_COMPLETE )
+        {
+        addr += 2;
+        FLASHStatus = FLASH_ProgramHalfWord( addr, (crc >> 16) & 0xFFFF );
+        }
+
+#ifdef RCFS_COMPRESS
+    // and the size before compression
+    if( write_stream.lz && (FLASHStatus == FLASH_COMPLETE) )
+        {
+        addr = write_stream.addr + RCFS_FILE_LZ_SIZE;
+        FLASHStatus = FLASH_ProgramHalfWord( addr, write_stream.logical );
+        }
+#endif
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, addr );
+        return(RCFS_ERROR);
+        }
+
+    write_stream.open = 0;
+
+#ifdef RCFS_VTOC_CACHE
+    vtoc_cache.entry[write_stream.slot].size = write_stream.length + FLASH_FILE_HEADER_SIZE;
+    vtoc_cache.nextaddr = (write_stream.addr - baseaddr) + write_stream.length + FLASH_FILE_HEADER_SIZE;
+#endif
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Give up on a file that RCFS_Close could not close               */
+/** @param[in] h handle returned by RCFS_OpenWrite                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Nothing more is programmed, the file is left as it is in the flash and
+ *  is closed by RCFS_Recover after the next reset.  Data not yet drained is
+ *  lost.
+ */
+
+int
+RCFS_Abandon( int h )
+{
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+    write_stream.open = 0;
+
+#ifdef RCFS_VTOC_CACHE
+    // the size of the file is found from the data again
+    RCFS_CacheInvalidate();
+#endif
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Delete a file opened for streaming writes instead of closing it */
+/** @param[in] h handle returned by RCFS_OpenWrite or RCFS_OpenAdd             */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  For a write that failed part way, nothing is left under the name.  The
+ *  stream is freed even if the delete cannot be programmed, a file opened
+ *  with RCFS_OpenAdd is then deleted by RCFS_Recover after the next reset.
+ */
+
+int
+RCFS_Cancel( int h )
+{
+    long *toc;
+    unsigned long addr;
+    volatile FLASH_Status FLASHStatus;
+
+    if( !write_stream.open || (h != write_stream.slot) )
+        return(RCFS_ERROR);
+
+    write_stream.open = 0;
+
+#ifdef RCFS_VTOC_CACHE
+    // the name and size are read from the flash again
+    RCFS_CacheInvalidate();
+#endif
+
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    addr = write_stream.addr;
+    FLASHStatus = FLASH_ProgramHalfWord( addr, 0 );
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, addr );
+        return(RCFS_ERROR);
+        }
+
+    // the size goes after what reached the flash, unless RCFS_Close wrote it
+    toc = (long *)(baseaddr + VTOC_OFFSET + (write_stream.slot * 8));
+    if( (toc[1] == (-1)) && (RCFS_StreamFinish( write_stream.slot, addr - baseaddr, toc ) < 0) )
+        return(RCFS_ERROR);
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a file to the file system                                   */
+/** @param[in] data pointer to the data to be written                          */
+/** @param[in] length plength of data in bytes                                 */
+/** @param[in] name name of the file to be written                             */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_AddFile( unsigned char *data, int length, char *name )
+{
+    long *toc;
+    short slot;
+
+    long  nextaddr = 0;
+    unsigned long crc;
+
+    flash_file   f;
+
+    // bounds check length
+    if( (length <= 0) || (length > MAX_FLASH_FILE_SIZE))
+        return(RCFS_ERROR);
+
+    // Find the VTOC slot and address for the file
+    if( RCFS_FindFreeSpace( &slot, &nextaddr ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+    toc = (long *)(baseaddr + VTOC_OFFSET + (slot * 8));
+
+#ifdef RCFS_COMPRESS
+    // compressed files are written by the streaming writer
+    if( RCFS_LzEnabled() )
+        {
+        if( (slot = RCFS_OpenAdd( name, length )) < 0 )
+            return(RCFS_ERROR);
+
+        if( (RCFS_Append( slot, data, length ) != RCFS_SUCCESS) ||
+            (RCFS_Close( slot ) != RCFS_SUCCESS) )
+            {
+            RCFS_Cancel( slot );
+            return(RCFS_ERROR);
+            }
+
+        return(RCFS_SUCCESS);
+        }
+#endif
+
+    // Check if there is room for the header and file
+    if( (nextaddr + FLASH_FILE_HEADER_SIZE + length) > RCFS_DATA_END )
+        return(RCFS_ERROR);
+
+    // create new file
+    RCFS_FileInit( &f );
+
+    // Copy name, max 15 chars
+    strncpy( (char *)&f.name[0], name, 15 );
+
+    // setup address, data pointer and length for this file
+    f.addr       = baseaddr + nextaddr;
+    f.data       = data;
+    f.datalength = length;
+
+    // CRC goes in the header which is written before the data
+    crc = ~RCFS_Crc32( 0xFFFFFFFF, data, length );
+    f.time[0] = RCFS_FILE_MARK | RCFS_FILE_CRC;
+    f.time[1] = crc;
+    f.time[2] = crc >> 8;
+    f.time[3] = crc >> 16;
+    f.unknown = crc >> 24;
+
+#ifdef  FFDEBUG
+    // Debug
+    RCFS_DebugFile(&f);
+#endif
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    // Write file, then commit it with the table of contents entry
+    if( RCFS_Write( &f ) != FLASH_COMPLETE )
+        {
+        // what was programmed becomes a deleted file
+        RCFS_Recover();
+        return(RCFS_ERROR);
+        }
+    if( RCFS_VtocCommit( toc, nextaddr, length + FLASH_FILE_HEADER_SIZE ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+    // header is now in flash so the name can be hashed
+    RCFS_CacheAdd( slot, nextaddr, length + FLASH_FILE_HEADER_SIZE );
+#endif
+
+    // We are done
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a file to the file system                                   */
+/** @param[in] data pointer to the data to be written                          */
+/** @param[in] length length of data in bytes                                  */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Add a file to the file system using the default filename
+ */
+int
+RCFS_AddFile( unsigned char *data, int length )
+{
+    char name[16];
+    int  slot;
+
+    // Get the last file slot number
+    slot = RCFS_FindLastSlot();
+
+    // any room left ?
+    if( slot < 0 )
+        return(RCFS_ERROR);
+    // create default filename
+    sprintf( &name[0], "%s%03d", RCFS_BASENAME, slot);
+
+    // Add this file
+    return( RCFS_AddFile( data, length, name ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Find a file by name                                             */
+/** @param[in] name the name of the file to find                               */
+/** @param[in] f pointer to a flash file header for the file                   */
+/** @returns   The VTOC slot of the file or RCFS_ERROR                         */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_FindFile( char *name, flash_file *f )
+{
+    int   slot;
+
+#ifdef RCFS_VTOC_CACHE
+    rcfs_dir       d;
+    unsigned short hash;
+
+    if( RCFS_BootCheck() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    if( !vtoc_cache.valid )
+        RCFS_CacheInit();
+
+    // only files in this bucket with the same hash can match
+    hash = RCFS_NameHash( name );
+    slot = vtoc_cache.bucket[ hash & (RCFS_HASH_SIZE-1) ];
+
+    while( slot != RCFS_ERROR )
+        {
+        if( vtoc_cache.entry[slot].hash == hash )
+            {
+            RCFS_DirOpen( &d );
+            RCFS_DirSeek( &d, slot );
+            RCFS_DirNext( &d, f );
+
+            // Check file for match on name
+            if( strcmp( name, (char *)&(f->name[0]) ) == 0 )
+                return(slot);
+            }
+        slot = vtoc_cache.entry[slot].next;
+        }
+#else
+    // Get the first file
+    if( (slot = RCFS_FindFirstFile(f)) >= 0 )
+        {
+        do {
+            // Check file for match on name
+            if( strcmp( name, (char *)&(f->name[0]) ) == 0 )
+                return(slot);
+            } while( (slot = RCFS_FindNextFile(f)) >= 0 );
+        }
+#endif
+
+    // No match
+    return( RCFS_ERROR );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get a pointer to data in a file                                 */
+/** @param[in] name the name of the file to open                               */
+/** @param[in] data handle used to return a pointer to the data                */
+/** @param[in] length pointer to returned length of data in bytes              */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  This function searches through the file table of contents looking for a file
+ *  with a name that matches the requested name.  It returns a pointer to the
+ *  files data and it's length in words.  The data of a compressed file is
+ *  returned as it is stored, use RCFS_ReadFile for those.
+ */
+int
+RCFS_GetFile( char *name, unsigned char **data, int *length )
+{
+    flash_file  f;
+
+    if( data == NULL )
+        return(RCFS_ERROR);
+    if( length == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_FindFile( name, &f ) < 0 )
+        return( RCFS_ERROR );
+
+    // Match
+    *data   = f.data;
+    *length = f.datalength;
+    return(RCFS_SUCCESS);
+}
+
+#ifdef RCFS_COMPRESS
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read data from a compressed file                                */
+/** @param[in] f the file header                                               */
+/** @param[out] buf where to put the data                                      */
+/** @param[in] offset offset in the uncompressed data to start reading         */
+/** @param[in] length number of bytes to read                                  */
+/** @returns   The number of bytes read                                        */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_LzRead( flash_file *f, unsigned char *buf, long offset, int length )
+{
+    static unsigned char window[RCFS_LZ_WINDOW];
+    unsigned char *p   = f->data;
+    unsigned char *end = f->data + f->datalength;
+    unsigned char  t, c;
+    long  pos = 0;
+    long  size;
+    int   run, dist;
+    int   n = 0;
+
+    // erased if the file was not closed
+    size = f->pad[0] + ((long)f->pad[1] * 256);
+    if( size == 0xFFFF )
+        size = RCFS_LZ_MAX_SIZE;
+
+    while( (p < end) && (n < length) && (pos < size) )
+        {
+        t = *p++;
+        if( t < 0x80 )
+            {
+            run  = t + 1;
+            dist = 0;
+            }
+        else
+            {
+            if( p >= end )
+                break;
+            run  = (t & 0x7F) + RCFS_LZ_MIN_MATCH;
+            dist = *p++ + 1;
+            }
+
+        for( ;(run > 0) && (n < length);run--)
+            {
+            if( dist == 0 )
+                {
+                if( p >= end )
+                    break;
+                c = *p++;
+                }
+            else
+                c = window[ (pos - dist) & (RCFS_LZ_WINDOW-1) ];
+
+            window[ pos & (RCFS_LZ_WINDOW-1) ] = c;
+            if( pos >= offset )
+                buf[n++] = c;
+            pos++;
+            }
+        }
+
+    return(n);
+}
+#endif
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read data from a file                                           */
+/** @param[in] f the file header                                               */
+/** @param[out] buf where to put the data                                      */
+/** @param[in] offset offset in the file to start reading                      */
+/** @param[in] length number of bytes to read                                  */
+/** @returns   The number of bytes read or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_ReadData( flash_file *f, unsigned char *buf, long offset, int length )
+{
+    int   n = 0;
+
+    if( (buf == NULL) || (offset < 0) || (length < 0) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    if( RCFS_FileFlags( f ) & RCFS_FILE_LZ )
+        return( RCFS_LzRead( f, buf, offset, length ) );
+#endif
+
+    for( ;(n < length) && ((offset + n) < f->datalength);n++)
+        buf[n] = f->data[ offset + n ];
+
+    return(n);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read data from a file                                           */
+/** @param[in] name the name of the file                                       */
+/** @param[out] buf where to put the data                                      */
+/** @param[in] offset offset in the file to start reading                      */
+/** @param[in] length number of bytes to read                                  */
+/** @returns   The number of bytes read or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Works for both plain and compressed files, fewer than length bytes are
+ *  returned at the end of the file.  A compressed file is decompressed from
+ *  the start each time so reading from a large offset takes longer.
+ */
+
+int
+RCFS_ReadFile( char *name, unsigned char *buf, long offset, int length )
+{
+    flash_file  f;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_FindFile( name, &f ) < 0 )
+        return(RCFS_ERROR);
+
+    return( RCFS_ReadData( &f, buf, offset, length ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get a handle for reading a file                                 */
+/** @param[in] name the name of the file                                       */
+/** @returns   A handle for the file or RCFS_ERROR                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The handle is the VTOC slot of the file so nothing needs to be closed.
+ *  It stays good until the file is deleted or RCFS_Compact is called.
+ */
+
+int
+RCFS_OpenRead( char *name )
+{
+    flash_file  f;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    return( RCFS_FindFile( name, &f ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the header of a file from its handle                        */
+/** @param[in] h handle returned by RCFS_OpenRead                              */
+/** @param[in] f pointer to a flash file header for the file                   */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_HandleFile( int h, flash_file *f )
+{
+    rcfs_dir    d;
+
+    if( (h < 0) || (h >= kMaxNumbofFlashFiles) )
+        return(RCFS_ERROR);
+
+    RCFS_DirOpen( &d );
+    RCFS_DirSeek( &d, h );
+
+    // a deleted file is skipped
+    if( RCFS_DirNext( &d, f ) != h )
+        return(RCFS_ERROR);
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read data from a file                                           */
+/** @param[in] h handle returned by RCFS_OpenRead                              */
+/** @param[in] offset offset in the file to start reading                      */
+/** @param[out] dst where to put the data                                      */
+/** @param[in] length number of bytes to read                                  */
+/** @returns   The number of bytes read or RCFS_ERROR                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Reads are checked against the end of the file, fewer than length bytes
+ *  are returned at the end and 0 after it.  Compressed files are read as
+ *  they were written.
+ */
+
+int
+RCFS_Read( int h, long offset, unsigned char *dst, int length )
+{
+    flash_file  f;
+
+    if( RCFS_HandleFile( h, &f ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    return( RCFS_ReadData( &f, dst, offset, length ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get a pointer to data in a file without copying it              */
+/** @param[in] h handle returned by RCFS_OpenRead                              */
+/** @param[in] offset offset in the file                                       */
+/** @param[out] ptr set to the data in flash                                   */
+/** @param[out] length set to the number of bytes that can be read at ptr      */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Returns the largest span that is contiguous in flash, call again at
+ *  offset + length for the rest.  Files are contiguous today so that is the
+ *  rest of the file.  A compressed file cannot be mapped, use RCFS_Read.
+ */
+
+int
+RCFS_Map( int h, long offset, unsigned char **ptr, int *length )
+{
+    flash_file  f;
+
+    if( (ptr == NULL) || (length == NULL) || (offset < 0) )
+        return(RCFS_ERROR);
+
+    if( RCFS_HandleFile( h, &f ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    if( RCFS_FileFlags( &f ) & RCFS_FILE_LZ )
+        return(RCFS_ERROR);
+#endif
+
+    if( offset > f.datalength )
+        return(RCFS_ERROR);
+
+    *ptr    = f.data + offset;
+    *length = f.datalength - offset;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check the CRC of a file                                         */
+/** @param[in] f pointer to a flash file header                                */
+/** @returns   RCFS_SUCCESS, RCFS_CRC_NONE or RCFS_CRC_ERROR                   */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_VerifyFile( flash_file *f )
+{
+    unsigned long crc;
+    unsigned long stored;
+    long  done;
+    long  run;
+
+    if( !(RCFS_FileFlags( f ) & RCFS_FILE_CRC) )
+        return(RCFS_CRC_NONE);
+
+    // erased if the file was not closed
+    stored = f->time[1] + ((unsigned long)f->time[2] << 8) + ((unsigned long)f->time[3] << 16) + ((unsigned long)f->unknown << 24);
+    if( stored == 0xFFFFFFFF )
+        return(RCFS_CRC_NONE);
+
+    // a damaged VTOC entry can point anywhere
+    if( (f->datalength < 0) || ((f->addr - baseaddr + FLASH_FILE_HEADER_SIZE + f->datalength) > RCFS_DATA_END) )
+        return(RCFS_CRC_ERROR);
+
+    // give other tasks a chance every 256 bytes
+    crc = 0xFFFFFFFF;
+    for(done=0;done<f->datalength;done+=run)
+        {
+        run = f->datalength - done;
+        if( run > 256 )
+            run = 256;
+        crc = RCFS_Crc32( crc, f->data + done, run );
+        abortTimeslice();
+        }
+
+    if( ~crc != stored )
+        return(RCFS_CRC_ERROR);
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check a file has not been damaged                               */
+/** @param[in] name the name of the file                                       */
+/** @returns   RCFS_SUCCESS if the CRC matches                                 */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Returns RCFS_CRC_ERROR if the data does not match the CRC in the header,
+ *  for example a file still being written when the cortex was reset.  Files
+ *  without a CRC, written by ROBOTC, an older version of this library or a
+ *  streamed file that was never closed, return RCFS_CRC_NONE.  RCFS_ERROR
+ *  if the file does not exist.
+ */
+
+int
+RCFS_Verify( char *name )
+{
+    flash_file  f;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_FindFile( name, &f ) < 0 )
+        return(RCFS_ERROR);
+
+    return( RCFS_VerifyFile( &f ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Check all files in the file system                              */
+/** @param[in] full 1 to check every file, 0 for a quick check                 */
+/** @returns   The number of damaged files                                     */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Files are written one at a time in VTOC order, so only the last file can
+ *  be torn by a reset.  The quick check reads the CRC of that file and just
+ *  checks the others fit in the file system, it is fast enough to call at
+ *  the start of every program.  A full check reads every byte.
+ */
+
+int
+RCFS_VerifyAll( short full )
+{
+    rcfs_dir    d;
+    flash_file  f;
+    flash_file  last;
+    int   bad = 0;
+    int   found = 0;
+
+    if( RCFS_DirOpen( &d ) != RCFS_SUCCESS )
+        return(0);
+
+    while( RCFS_DirNext( &d, &f ) >= 0 )
+        {
+        if( full )
+            {
+            if( RCFS_VerifyFile( &f ) == RCFS_CRC_ERROR )
+                bad++;
+            }
+        else
+        if( (f.datalength < 0) || ((f.addr - baseaddr + FLASH_FILE_HEADER_SIZE + f.datalength) > RCFS_DATA_END) )
+            bad++;
+        else
+            {
+            memcpy( &last, &f, sizeof(flash_file) );
+            found = 1;
+            }
+        }
+
+    RCFS_DirClose( &d );
+
+    if( !full && found && (RCFS_VerifyFile( &last ) == RCFS_CRC_ERROR) )
+        bad++;
+
+    return(bad);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the space used and free in the file system                  */
+/** @param[out] st pointer to a structure for the results                      */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  With the VTOC cache this only reads values it already has, without it
+ *  every VTOC entry is read.  While a file is open for writing it owns the
+ *  free space, largest is then the data it can still take.
+ */
+
+int
+RCFS_Stat( rcfs_stat *st )
+{
+    long  next;
+    long  deleted = 0;
+    short slots;
+
+    if( st == NULL )
+        return(RCFS_ERROR);
+
+    if( RCFS_BootCheck() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_VTOC_CACHE
+    if( !vtoc_cache.valid )
+        RCFS_CacheInit();
+
+    slots   = vtoc_cache.count;
+    next    = vtoc_cache.nextaddr;
+    deleted = vtoc_cache.deleted;
+#else
+    long *toc = (long *)(baseaddr + VTOC_OFFSET);
+    long  addr;
+    long  size;
+    long  maxaddr = 0;
+
+    next = 0;
+    for(slots=0;slots<kMaxNumbofFlashFiles;slots++)
+        {
+        addr = *toc++;
+        size = *toc++;
+
+        // End of table ?
+        if( RCFS_VtocEnd( addr ) )
+            break;
+
+        // File that has not been closed
+        if( size == (-1) )
+            size = RCFS_StreamSize( slots, addr );
+
+        if( RCFS_Deleted( addr ) )
+            deleted += size;
+
+        if( addr > maxaddr )
+            {
+            maxaddr = addr;
+            next    = addr + size;
+            }
+        }
+#endif
+
+    if( write_stream.open )
+        next = (write_stream.addr - baseaddr) + FLASH_FILE_HEADER_SIZE + write_stream.length;
+
+    if(next & 1)
+        next++;
+    if(next < RCFS_DATA_OFFSET)
+        next = RCFS_DATA_OFFSET;
+
+    st->used    = next - RCFS_DATA_OFFSET;
+    st->deleted = deleted;
+    st->free    = RCFS_DATA_END - next;
+    st->files   = slots;
+    st->slots   = kMaxNumbofFlashFiles - slots;
+
+    if( st->free < 0 )
+        st->free = 0;
+
+    if( write_stream.open )
+        st->largest = write_stream.maxlength - write_stream.length;
+    else
+    if( (st->slots == 0) || (st->free <= FLASH_FILE_HEADER_SIZE) )
+        st->largest = 0;
+    else
+        {
+        st->largest = st->free - FLASH_FILE_HEADER_SIZE;
+        if( st->largest > RCFS_STREAM_MAX_SIZE )
+            st->largest = RCFS_STREAM_MAX_SIZE;
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the name of the last file in the VTOC                       */
+/*-----------------------------------------------------------------------------*/
+/** @details   Use this if you write a file with the default name to dtermine
+ *  what that name was.
+ */
+
+int
+RCFS_GetLastFilename( char *name, int len )
+{
+    rcfs_dir    d;
+    flash_file  f;
+    int         last;
+
+    if( name == NULL )
+        return( RCFS_ERROR );
+
+    if(len > 16)
+        len = 16;
+
+    // Find the end of the table, only the VTOC is read
+    last = RCFS_FindLastSlot();
+    if( last == RCFS_ERROR )
+        last = kMaxNumbofFlashFiles;
+
+    // Read the last file that has not been deleted
+    while( --last >= 0 )
+        {
+        RCFS_DirOpen( &d );
+        RCFS_DirSeek( &d, last );
+
+        if( RCFS_DirNext( &d, &f ) == last )
+            {
+            strncpy( name, (char *)&f.name[0], len );
+
+            return(RCFS_SUCCESS);
+            }
+        }
+
+    return( RCFS_ERROR );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Delete a file                                                   */
+/** @param[in] name the name of the file to delete                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The file is marked as deleted by clearing the start of its name, nothing
+ *  is erased so the space is only reclaimed by RCFS_Compact.  If there are
+ *  several files with the same name the one RCFS_GetFile finds is deleted.
+ *  ROBOTC's own files and a file open for writing cannot be deleted.
+ */
+
+int
+RCFS_DeleteFile( char *name )
+{
+    flash_file  f;
+    int         slot;
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    if( name == NULL )
+        return(RCFS_ERROR);
+
+    if( (slot = RCFS_FindFile( name, &f )) < 0 )
+        return(RCFS_ERROR);
+
+    if( (f.addr - baseaddr) < RCFS_DATA_OFFSET )
+        return(RCFS_ERROR);
+
+    if( write_stream.open && (slot == write_stream.slot) )
+        return(RCFS_ERROR);
+
+    // fails if another task has the controller
+    if( RCFS_Unlock() != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    FLASHStatus = FLASH_ProgramHalfWord( f.addr, 0 );
+    if( FLASHStatus != FLASH_COMPLETE )
+        {
+        RCFS_WriteError( FLASHStatus, f.addr );
+#ifdef RCFS_VTOC_CACHE
+        // the name may be part cleared, read it again
+        RCFS_CacheInvalidate();
+#endif
+        return(RCFS_ERROR);
+        }
+
+#ifdef RCFS_VTOC_CACHE
+    short *s;
+
+    // remove from the hash bucket
+    s = &vtoc_cache.bucket[ vtoc_cache.entry[slot].hash & (RCFS_HASH_SIZE-1) ];
+    while( *s != RCFS_ERROR )
+        {
+        if( *s == slot )
+            {
+            *s = vtoc_cache.entry[slot].next;
+            break;
+            }
+        s = &vtoc_cache.entry[*s].next;
+        }
+    vtoc_cache.deleted += vtoc_cache.entry[slot].size;
+#endif
+
+    return(RCFS_SUCCESS);
+}
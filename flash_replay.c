@@ -0,0 +1,399 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_replay.c                                               */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Abandon a file that won't close       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    Record joystick or motor values during practice and replay them in       */
+/*    autonomous, samples are read from flash as they are needed               */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_replay.c
+  * @brief   Record and replay
+*//*---------------------------------------------------------------------------*/
+/** @details
+ *  A recording is an RCFS file with an 8 byte header, 'R' 'P' version,
+ *  number of channels and the period as a half word, then fixed size
+ *  samples of the time in mS since the start as two half words and a half
+ *  word for each channel.  Files are never compressed so they can be read
+ *  in place with RCFS_Map.
+ */
+
+// Maximum channels in a recording, can be overridden in user code
+#ifndef RCFS_REPLAY_MAX_CHANNELS
+#define RCFS_REPLAY_MAX_CHANNELS    8
+#endif
+
+/** @cond    */
+#define RCFS_REPLAY_MAGIC0          'R'
+#define RCFS_REPLAY_MAGIC1          'P'
+#define RCFS_REPLAY_VERSION         1
+#define RCFS_REPLAY_HEADER_SIZE     8
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The recording being written                                       */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_record {
+             short open;                   ///< recording
+             short h;                      ///< RCFS stream handle
+             short channels;               ///< values in each sample
+             int   period;                 ///< mS between samples
+             long  start;                  ///< nSysTime at the start
+             long  next;                   ///< time of the next sample
+             long  samples;                ///< samples written
+             short value[RCFS_REPLAY_MAX_CHANNELS];
+    } rcfs_record;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The recording being replayed                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Only a pointer to the samples in flash and the current position are
+ *  kept, the RAM used does not depend on the length of the recording.
+ */
+
+typedef struct _rcfs_replay {
+             short open;                   ///< replaying
+             short channels;               ///< values in each sample
+             short size;                   ///< half words in each sample
+    unsigned short *data;                  ///< first sample in flash
+             long  count;                  ///< number of samples
+             long  index;                  ///< last sample at or before now
+             long  start;                  ///< nSysTime at the start
+             long  now;                    ///< time of the last update
+    } rcfs_replay;
+
+static  rcfs_record record;
+static  rcfs_replay replay;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start a recording                                               */
+/** @param[in] name name of the file                                           */
+/** @param[in] channels number of values in each sample                        */
+/** @param[in] period mS between samples                                       */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The file is written with the RCFS streaming writer so it can be up to
+ *  RCFS_STREAM_MAX_SIZE bytes, 4 channels every 20mS is about 50 seconds.
+ */
+
+int
+RCFS_RecordStart( char *name, int channels, int period )
+{
+    unsigned char hdr[RCFS_REPLAY_HEADER_SIZE];
+    int   i;
+
+    if( record.open || (channels < 1) || (channels > RCFS_REPLAY_MAX_CHANNELS) || (period < 1) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    // samples are read in place
+    short compress = rcfs_compress;
+    rcfs_compress = 0;
+    record.h = RCFS_OpenWrite( name );
+    rcfs_compress = compress;
+#else
+    record.h = RCFS_OpenWrite( name );
+#endif
+    if( record.h < 0 )
+        return(RCFS_ERROR);
+
+    hdr[0] = RCFS_REPLAY_MAGIC0;
+    hdr[1] = RCFS_REPLAY_MAGIC1;
+    hdr[2] = RCFS_REPLAY_VERSION;
+    hdr[3] = channels;
+    hdr[4] = period & 0xFF;
+    hdr[5] = (period >> 8) & 0xFF;
+    hdr[6] = 0;
+    hdr[7] = 0;
+    if( RCFS_Append( record.h, hdr, RCFS_REPLAY_HEADER_SIZE ) != RCFS_SUCCESS )
+        {
+        if( RCFS_Close( record.h ) != RCFS_SUCCESS )
+            RCFS_Abandon( record.h );
+        return(RCFS_ERROR);
+        }
+
+    for(i=0;i<RCFS_REPLAY_MAX_CHANNELS;i++)
+        record.value[i] = 0;
+
+    record.open     = 1;
+    record.channels = channels;
+    record.period   = period;
+    record.start    = nSysTime;
+    record.next     = 0;
+    record.samples  = 0;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Set a channel for the next sample                               */
+/** @param[in] ch the channel                                                  */
+/** @param[in] value the value                                                 */
+/*-----------------------------------------------------------------------------*/
+
+void
+RCFS_RecordSet( int ch, int value )
+{
+    if( (ch >= 0) && (ch < record.channels) )
+        record.value[ch] = value;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write a sample if it is time for one                            */
+/** @returns   1 if a sample was written, 0 if not or RCFS_ERROR               */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this as often as you like, for example every time round the driver
+ *  control loop.  Samples are due on multiples of the period from the start
+ *  so a late sample does not delay the ones after it, each sample has the
+ *  time it was taken.
+ */
+
+int
+RCFS_RecordSample()
+{
+    unsigned short s[2 + RCFS_REPLAY_MAX_CHANNELS];
+    long  now;
+    int   i;
+
+    if( !record.open )
+        return(RCFS_ERROR);
+
+    now = nSysTime - record.start;
+    if( now < record.next )
+        return(0);
+
+    // next time on the period, any that were missed are skipped
+    record.next = now - (now % record.period) + record.period;
+
+    s[0] = now & 0xFFFF;
+    s[1] = (now >> 16) & 0xFFFF;
+    for(i=0;i<record.channels;i++)
+        s[2+i] = record.value[i];
+
+    if( RCFS_Append( record.h, (unsigned char *)&s[0], (2 + record.channels) * 2 ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    record.samples++;
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Stop recording                                                  */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_RecordStop()
+{
+    if( !record.open )
+        return(RCFS_ERROR);
+
+    record.open = 0;
+
+    // the next file can still be written if this one cannot be closed
+    if( RCFS_Close( record.h ) != RCFS_SUCCESS )
+        {
+        RCFS_Abandon( record.h );
+        return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Time of a sample in the recording being replayed                */
+/** @param[in] i the sample                                                    */
+/*-----------------------------------------------------------------------------*/
+
+static long
+RCFS_ReplayTime( long i )
+{
+    unsigned short *p = replay.data + (i * replay.size);
+
+    return( p[0] + ((long)p[1] << 16) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start replaying a recording                                     */
+/** @param[in] name name of the file                                           */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The recording is replayed from now, call RCFS_ReplayUpdate and then
+ *  RCFS_ReplayGet for each channel every time round the autonomous loop.
+ */
+
+int
+RCFS_ReplayStart( char *name )
+{
+    unsigned char *p;
+    int   length;
+    int   h;
+
+    replay.open = 0;
+
+    if( (h = RCFS_OpenRead( name )) < 0 )
+        return(RCFS_ERROR);
+
+    if( RCFS_Map( h, 0, &p, &length ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    if( (length < RCFS_REPLAY_HEADER_SIZE) ||
+        (p[0] != RCFS_REPLAY_MAGIC0) || (p[1] != RCFS_REPLAY_MAGIC1) || (p[2] != RCFS_REPLAY_VERSION) ||
+        (p[3] < 1) || (p[3] > RCFS_REPLAY_MAX_CHANNELS) )
+        return(RCFS_ERROR);
+
+    replay.channels = p[3];
+    replay.size     = 2 + replay.channels;
+    replay.count    = (length - RCFS_REPLAY_HEADER_SIZE) / (replay.size * 2);
+    if( replay.count < 1 )
+        return(RCFS_ERROR);
+
+    long tmp = (long)p + RCFS_REPLAY_HEADER_SIZE;
+    replay.data  = (unsigned short *)tmp;
+    replay.index = 0;
+    replay.now   = 0;
+    replay.start = nSysTime;
+    replay.open  = 1;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Move the replay on to the current time                          */
+/** @returns   1 while replaying, 0 once the last sample has been reached      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The position comes from the sample times and nSysTime, not from counting
+ *  calls, so a slow loop skips samples rather than falling behind and the
+ *  replay ends at the same time as the recording did.
+ */
+
+int
+RCFS_ReplayUpdate()
+{
+    if( !replay.open )
+        return(0);
+
+    replay.now = nSysTime - replay.start;
+
+    while( ((replay.index + 1) < replay.count) && (RCFS_ReplayTime( replay.index + 1 ) <= replay.now) )
+        replay.index++;
+
+    if( (replay.index + 1) >= replay.count )
+        {
+        replay.open = 0;
+        return(0);
+        }
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the value of a channel now                                  */
+/** @param[in] ch the channel                                                  */
+/** @returns   The value interpolated between the samples either side of now   */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  After the replay has finished the value from the last sample is returned.
+ *  Use RCFS_ReplayGetStep for channels such as buttons that should not be
+ *  interpolated.
+ */
+
+int
+RCFS_ReplayGet( int ch )
+{
+    unsigned short *p;
+    long  t0, t1;
+    long  v0, v1;
+
+    if( (replay.data == NULL) || (ch < 0) || (ch >= replay.channels) )
+        return(0);
+
+    p  = replay.data + (replay.index * replay.size);
+    v0 = (short)p[2 + ch];
+
+    if( (replay.index + 1) >= replay.count )
+        return(v0);
+
+    t0 = RCFS_ReplayTime( replay.index );
+    t1 = RCFS_ReplayTime( replay.index + 1 );
+    if( (replay.now <= t0) || (t1 <= t0) )
+        return(v0);
+
+    v1 = (short)p[replay.size + 2 + ch];
+
+    return( v0 + ((v1 - v0) * (replay.now - t0)) / (t1 - t0) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the value of a channel from the last sample before now      */
+/** @param[in] ch the channel                                                  */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_ReplayGetStep( int ch )
+{
+    unsigned short *p;
+
+    if( (replay.data == NULL) || (ch < 0) || (ch >= replay.channels) )
+        return(0);
+
+    p = replay.data + (replay.index * replay.size);
+
+    return( (short)p[2 + ch] );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Stop replaying                                                  */
+/*-----------------------------------------------------------------------------*/
+
+void
+RCFS_ReplayStop()
+{
+    replay.open = 0;
+    replay.data = NULL;
+}
@@ -0,0 +1,452 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_ring.c                                                 */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Logger task stops on an error         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    A ring of fixed size records between a control task and a logger task,   */
+/*    the control task never waits for flash                                   */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_ring.c
+  * @brief   Sample ring
+*//*---------------------------------------------------------------------------*/
+/** @details
+ *  The control task calls RCFS_RingPush with each sample, it copies the
+ *  record into RAM and never touches flash.  The logger, RCFS_RingTask or
+ *  user code calling RCFS_RingService, writes records to an RCFS file with
+ *  the streaming writer.  The ring has one producer and one consumer, the
+ *  producer only changes head and the consumer only changes tail and each
+ *  is changed after the record it covers, so neither side needs hogCPU.
+ *
+ *  When the ring is full the new record is dropped and counted, the control
+ *  task is never held up.  Records are written in batches that end with the
+ *  record reaching the end of a flash page, so each page is finished by one
+ *  flush and a batch crosses at most one page boundary by less than a
+ *  record.  Records that do not make a full batch wait in RAM until more
+ *  arrive or the ring is closed.
+ *
+ *  The file is the records one after the other, it is never compressed so
+ *  it can be read in place with RCFS_Map.
+ */
+
+// Bytes of RAM for records, can be overridden in user code
+#ifndef RCFS_RING_BUFFER_SIZE
+#define RCFS_RING_BUFFER_SIZE   1024
+#endif
+
+// Most bytes written by one RCFS_RingService, each byte takes about 26uS
+#ifndef RCFS_RING_BATCH_BYTES
+#define RCFS_RING_BATCH_BYTES   128
+#endif
+
+// Priority of the logger task
+#ifndef RCFS_RING_PRIORITY
+#define RCFS_RING_PRIORITY      kLowPriority
+#endif
+
+// How long the logger task sleeps when there is not a batch to write
+#define RCFS_RING_IDLE_WAIT     5
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The ring and the file it is written to                            */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_ring {
+    volatile short head;                   ///< next record pushed, producer only
+    volatile short tail;                   ///< next record written, consumer only
+             short open;                   ///< file is open
+             short closing;                ///< write everything then close
+             short running;                ///< RCFS_RingTask is running
+             short result;                 ///< how RCFS_RingTask closed the file
+             short h;                      ///< RCFS stream handle
+             short size;                   ///< bytes in each record
+             short records;                ///< records the ring can hold
+             short full;                   ///< last push was dropped
+             short high;                   ///< most records waiting
+             long  pushed;                 ///< records pushed
+             long  dropped;                ///< records lost because the ring was full
+             long  overflows;              ///< times the ring filled
+             long  written;                ///< records written to the file
+             long  batches;                ///< batches programmed
+    unsigned char  data[RCFS_RING_BUFFER_SIZE];
+    } rcfs_ring;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Ring counters for RCFS_RingStat                                   */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_ring_stat {
+             long  pushed;                 ///< records pushed
+             long  written;                ///< records written to the file
+             long  dropped;                ///< records lost because the ring was full
+             long  overflows;              ///< times the ring filled
+             long  batches;                ///< batches programmed
+             short waiting;                ///< records in the ring now
+             short high;                   ///< most records waiting
+             short records;                ///< records the ring can hold
+    } rcfs_ring_stat;
+
+static  rcfs_ring   ring;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open the ring and the file it is written to                     */
+/** @param[in] name name of the file                                           */
+/** @param[in] size bytes in each record                                       */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The ring holds one less than RCFS_RING_BUFFER_SIZE / size records.  No
+ *  other file can be written until RCFS_RingClose.
+ */
+
+int
+RCFS_RingOpen( char *name, int size )
+{
+    if( ring.open || ring.running || (size < 1) || ((size * 2) > RCFS_RING_BUFFER_SIZE) )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    // records are read in place
+    short compress = rcfs_compress;
+    rcfs_compress = 0;
+    ring.h = RCFS_OpenWrite( name );
+    rcfs_compress = compress;
+#else
+    ring.h = RCFS_OpenWrite( name );
+#endif
+    if( ring.h < 0 )
+        return(RCFS_ERROR);
+
+    ring.head      = 0;
+    ring.tail      = 0;
+    ring.closing   = 0;
+    ring.size      = size;
+    ring.records   = RCFS_RING_BUFFER_SIZE / size;
+    ring.full      = 0;
+    ring.high      = 0;
+    ring.pushed    = 0;
+    ring.dropped   = 0;
+    ring.overflows = 0;
+    ring.written   = 0;
+    ring.batches   = 0;
+    ring.open      = 1;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a record to the ring                                        */
+/** @param[in] data the record, the size given to RCFS_RingOpen                */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR if the ring is full or not open      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this from one task only, usually the control loop.  It takes the
+ *  same time whatever the logger is doing, a record that does not fit is
+ *  counted in dropped.
+ */
+
+int
+RCFS_RingPush( unsigned char *data )
+{
+    short head = ring.head;
+    short next = head + 1;
+    short n;
+
+    if( !ring.open || ring.closing )
+        return(RCFS_ERROR);
+
+    if( next >= ring.records )
+        next = 0;
+
+    // the logger has fallen behind
+    if( next == ring.tail )
+        {
+        ring.dropped++;
+        if( !ring.full )
+            ring.overflows++;
+        ring.full = 1;
+        return(RCFS_ERROR);
+        }
+    ring.full = 0;
+
+    memcpy( &ring.data[ head * ring.size ], data, ring.size );
+    ring.pushed++;
+
+    // the tail may move on while this is worked out, so high can be over
+    n = next - ring.tail;
+    if( n < 0 )
+        n += ring.records;
+    if( n > ring.high )
+        ring.high = n;
+
+    // the record is complete, let the logger have it
+    ring.head = next;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write a batch of records to the file                            */
+/** @returns   Number of records written or RCFS_ERROR                         */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this from one task only.  A batch is RCFS_RING_BATCH_BYTES of
+ *  records, or near the end of a flash page the records up to and including
+ *  the one that reaches the end, so the next batch starts in the new page.
+ *  Nothing is written until a whole batch is waiting, unless the ring is
+ *  closing.
+ */
+
+int
+RCFS_RingService()
+{
+    short tail = ring.tail;
+    short waiting;
+    short batch;
+    short run;
+    long  room;
+
+    if( !ring.open )
+        return(RCFS_ERROR);
+
+    waiting = ring.head - tail;
+    if( waiting < 0 )
+        waiting += ring.records;
+
+    // bytes before the end of the page, none when the file is full
+    room = RCFS_StreamRoom( ring.h );
+    if( room <= 0 )
+        return(RCFS_ERROR);
+    if( room > RCFS_RING_BATCH_BYTES )
+        batch = RCFS_RING_BATCH_BYTES / ring.size;
+    else
+        batch = (room + ring.size - 1) / ring.size;
+    if( batch < 1 )
+        batch = 1;
+
+    if( waiting < batch )
+        {
+        if( !ring.closing || (waiting == 0) )
+            return(0);
+        batch = waiting;
+        }
+
+    // at most two runs, before and after the end of the ring
+    for( waiting = batch; waiting > 0; waiting -= run )
+        {
+        run = ring.records - tail;
+        if( run > waiting )
+            run = waiting;
+
+        if( RCFS_Append( ring.h, &ring.data[ tail * ring.size ], run * ring.size ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+
+        tail += run;
+        if( tail >= ring.records )
+            tail = 0;
+        }
+
+    if( RCFS_Flush( ring.h ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    // the records have been copied, give the space back
+    ring.tail = tail;
+    ring.written += batch;
+    ring.batches++;
+
+    return(batch);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write what is left in the ring and close the file               */
+/** @param[in] failed 1 if RCFS_RingService has already failed                 */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Called by the task that calls RCFS_RingService, for RCFS_RingTask that
+ *  is the task itself.  After a failure the file is closed with what has
+ *  been written.
+ */
+
+static int
+RCFS_RingFinish( short failed )
+{
+    int   ret = RCFS_SUCCESS;
+    int   n;
+
+    if( failed )
+        ret = RCFS_ERROR;
+    else
+        {
+        while( (n = RCFS_RingService()) > 0 )
+            abortTimeslice();
+        if( n < 0 )
+            ret = RCFS_ERROR;
+        }
+
+    ring.open = 0;
+
+    // a stream that cannot be closed would block every later file
+    if( RCFS_Close( ring.h ) != RCFS_SUCCESS )
+        {
+        RCFS_Abandon( ring.h );
+        ret = RCFS_ERROR;
+        }
+
+    return(ret);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Task that writes the ring to the file                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The task stops and closes the file when the file is full or cannot be
+ *  written, RCFS_RingPush then fails and RCFS_RingClose returns RCFS_ERROR.
+ */
+
+task RCFS_RingTask()
+{
+    int   n = 0;
+
+    while( !ring.closing )
+        {
+        // a full file or a write error ends the log
+        n = RCFS_RingService();
+        if( n < 0 )
+            break;
+
+        // a batch then let the other tasks run
+        if( n > 0 )
+            abortTimeslice();
+        else
+            wait1Msec( RCFS_RING_IDLE_WAIT );
+        }
+
+    ring.result = RCFS_RingFinish( n < 0 );
+
+    ring.running = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Start the logger task                                           */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call after RCFS_RingOpen.  Without the task call RCFS_RingService from a
+ *  task of your own.
+ */
+
+int
+RCFS_RingStart()
+{
+    if( !ring.open || ring.running )
+        return(RCFS_ERROR);
+
+    ring.running = 1;
+
+#if kRobotCVersionNumeric < 400
+    StartTask( RCFS_RingTask, RCFS_RING_PRIORITY );
+#else
+    startTask( RCFS_RingTask, RCFS_RING_PRIORITY );
+#endif
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write what is left in the ring and close the file               */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Records pushed after this are not written.  With the logger task running
+ *  this waits for the task to finish the file.
+ */
+
+int
+RCFS_RingClose()
+{
+    if( !ring.open || ring.closing )
+        return(RCFS_ERROR);
+
+    ring.closing = 1;
+
+    if( !ring.running )
+        return( RCFS_RingFinish( 0 ) );
+
+    while( ring.running )
+        wait1Msec( RCFS_RING_IDLE_WAIT );
+
+    return( ring.result );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the ring counters                                           */
+/** @param[out] st pointer to a structure for the results                      */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Can be called from any task, the counts may be one record apart while
+ *  the other tasks are running.
+ */
+
+int
+RCFS_RingStat( rcfs_ring_stat *st )
+{
+    short waiting;
+
+    if( st == NULL )
+        return(RCFS_ERROR);
+
+    waiting = ring.head - ring.tail;
+    if( waiting < 0 )
+        waiting += ring.records;
+
+    st->pushed    = ring.pushed;
+    st->written   = ring.written;
+    st->dropped   = ring.dropped;
+    st->overflows = ring.overflows;
+    st->batches   = ring.batches;
+    st->waiting   = waiting;
+    st->high      = ring.high;
+    st->records   = ring.records - 1;
+
+    return(RCFS_SUCCESS);
+}
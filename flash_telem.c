@@ -0,0 +1,298 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_telem.c                                                */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Telemetry is never compressed         */
+/*                V1.02    17 Oct 2026 - Abandon a file that won't close       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    Write sensor samples to an RCFS file in a compact binary format,         */
+/*    host/telem_decode converts them to CSV                                   */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_telem.c
+  * @brief   Telemetry files
+*//*---------------------------------------------------------------------------*/
+/** @details
+ *  The file starts with a schema, 4 bytes of 'R' 'T' version and number of
+ *  fields then 4 bytes for each field, the id, type, scale and a zero.  Each
+ *  sample follows as one varint for each field, 7 bits in each byte with the
+ *  top bit set on all but the last.  Values are zigzag encoded so small
+ *  negative numbers are also short, RCFS_TELEM_DELTA fields store the change
+ *  since the last sample.  The decoded value is the integer times 10^scale.
+ *
+ *  Neither the schema nor a sample ends in 0xFF so a file that was not closed
+ *  is recovered by RCFS without losing any complete samples.
+ */
+
+// Maximum fields in a file, can be overridden in user code
+#ifndef RCFS_TELEM_MAX_FIELDS
+#define RCFS_TELEM_MAX_FIELDS   16
+#endif
+
+// Field types
+#define RCFS_TELEM_VALUE        0
+#define RCFS_TELEM_DELTA        1
+
+/** @cond    */
+#define RCFS_TELEM_MAGIC0       'R'
+#define RCFS_TELEM_MAGIC1       'T'
+#define RCFS_TELEM_VERSION      1
+
+// longest encoding of a 32 bit value
+#define RCFS_TELEM_VARINT_MAX   5
+/** @endcond */
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   The telemetry file being written                                  */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rcfs_telem {
+             short h;                      ///< RCFS stream handle
+             short open;                   ///< file is open
+             short fields;                 ///< number of fields
+             short started;                ///< schema has been written
+    unsigned char  id[RCFS_TELEM_MAX_FIELDS];      ///< field ids
+    unsigned char  type[RCFS_TELEM_MAX_FIELDS];    ///< value or delta
+             short scale[RCFS_TELEM_MAX_FIELDS];   ///< power of 10
+             long  value[RCFS_TELEM_MAX_FIELDS];   ///< next sample
+             long  last[RCFS_TELEM_MAX_FIELDS];    ///< last sample written
+             long  samples;                ///< samples written
+    } rcfs_telem;
+
+static  rcfs_telem  telem;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Open a telemetry file                                           */
+/** @param[in] name name of the file                                           */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The file is written with the RCFS streaming writer, so no other file can
+ *  be added until RCFS_TelemClose.  Add the fields with RCFS_TelemField.
+ */
+
+int
+RCFS_TelemOpen( char *name )
+{
+    int   h;
+
+    if( telem.open )
+        return(RCFS_ERROR);
+
+#ifdef RCFS_COMPRESS
+    // samples are read in place and an unclosed file is recovered
+    short compress = rcfs_compress;
+    rcfs_compress = 0;
+    h = RCFS_OpenWrite( name );
+    rcfs_compress = compress;
+#else
+    h = RCFS_OpenWrite( name );
+#endif
+    if( h < 0 )
+        return(RCFS_ERROR);
+
+    telem.h       = h;
+    telem.open    = 1;
+    telem.fields  = 0;
+    telem.started = 0;
+    telem.samples = 0;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Add a field to the telemetry file                               */
+/** @param[in] id identifies the field in the decoded output, 0 to 255         */
+/** @param[in] type RCFS_TELEM_VALUE or RCFS_TELEM_DELTA                       */
+/** @param[in] scale power of 10 the value is multiplied by when decoded       */
+/** @returns   The field index for RCFS_TelemSet or RCFS_ERROR                 */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Use RCFS_TELEM_DELTA for values that change slowly such as encoders and
+ *  timestamps, RCFS_TELEM_VALUE for values that jump about such as motor
+ *  power.  Fields must be added before the first sample.
+ */
+
+int
+RCFS_TelemField( int id, int type, int scale )
+{
+    int   n = telem.fields;
+
+    if( !telem.open || telem.started || (n >= RCFS_TELEM_MAX_FIELDS) )
+        return(RCFS_ERROR);
+
+    if( (id < 0) || (id > 255) || (scale < -127) || (scale > 127) )
+        return(RCFS_ERROR);
+
+    telem.id[n]    = id;
+    telem.type[n]  = (type == RCFS_TELEM_DELTA) ? RCFS_TELEM_DELTA : RCFS_TELEM_VALUE;
+    telem.scale[n] = scale;
+    telem.value[n] = 0;
+    telem.last[n]  = 0;
+    telem.fields++;
+
+    return(n);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Set a field for the next sample                                 */
+/** @param[in] field index returned by RCFS_TelemField                         */
+/** @param[in] value the value                                                 */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  A field that is not set keeps its value from the last sample.
+ */
+
+void
+RCFS_TelemSet( int field, long value )
+{
+    if( (field >= 0) && (field < telem.fields) )
+        telem.value[field] = value;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Encode a value as a zigzag varint                               */
+/** @param[out] buf where to put the bytes                                     */
+/** @param[in] v the value                                                     */
+/** @returns   Number of bytes used                                            */
+/*-----------------------------------------------------------------------------*/
+
+static int
+RCFS_TelemVarint( unsigned char *buf, long v )
+{
+    unsigned long u;
+    int   n = 0;
+
+    // 0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+    if( v < 0 )
+        u = ~(v << 1);
+    else
+        u = v << 1;
+
+    while( u >= 0x80 )
+        {
+        buf[n++] = (u & 0x7F) | 0x80;
+        u = u >> 7;
+        }
+    buf[n++] = u;
+
+    return(n);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Write a sample of all the fields                                */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The schema is written with the first sample.  A sample that does not fit
+ *  in the file is not written.
+ */
+
+int
+RCFS_TelemSample()
+{
+    unsigned char buf[4 + RCFS_TELEM_MAX_FIELDS * RCFS_TELEM_VARINT_MAX];
+    long  v;
+    int   i, n;
+
+    if( !telem.open || (telem.fields == 0) )
+        return(RCFS_ERROR);
+
+    if( !telem.started )
+        {
+        buf[0] = RCFS_TELEM_MAGIC0;
+        buf[1] = RCFS_TELEM_MAGIC1;
+        buf[2] = RCFS_TELEM_VERSION;
+        buf[3] = telem.fields;
+        for(i=0,n=4;i<telem.fields;i++)
+            {
+            buf[n++] = telem.id[i];
+            buf[n++] = telem.type[i];
+            buf[n++] = telem.scale[i] & 0xFF;
+            buf[n++] = 0;
+            }
+
+        if( RCFS_Append( telem.h, buf, n ) != RCFS_SUCCESS )
+            return(RCFS_ERROR);
+
+        telem.started = 1;
+        }
+
+    for(i=0,n=0;i<telem.fields;i++)
+        {
+        v = telem.value[i];
+        if( telem.type[i] == RCFS_TELEM_DELTA )
+            v = v - telem.last[i];
+
+        n += RCFS_TelemVarint( &buf[n], v );
+        }
+
+    if( RCFS_Append( telem.h, buf, n ) != RCFS_SUCCESS )
+        return(RCFS_ERROR);
+
+    for(i=0;i<telem.fields;i++)
+        telem.last[i] = telem.value[i];
+    telem.samples++;
+
+    return(RCFS_SUCCESS);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Close the telemetry file                                        */
+/** @returns   RCFS_SUCCESS or RCFS_ERROR                                      */
+/*-----------------------------------------------------------------------------*/
+
+int
+RCFS_TelemClose()
+{
+    if( !telem.open )
+        return(RCFS_ERROR);
+
+    telem.open = 0;
+
+    // the next file can still be written if this one cannot be closed
+    if( RCFS_Close( telem.h ) != RCFS_SUCCESS )
+        {
+        RCFS_Abandon( telem.h );
+        return(RCFS_ERROR);
+        }
+
+    return(RCFS_SUCCESS);
+}
@@ -1,299 +1,1282 @@
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*                        Copyright (c) James Pearman                          */
-/*                                 2012-2015                                   */
-/*                            All Rights Reserved                              */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    Module:     flash_user.c                                                 */
-/*    Author:     James Pearman                                                */
-/*    Created:    21 Aug 2012                                                  */
-/*                                                                             */
-/*    Revisions:                                                               */
-/*                V1.00     4 Apr 2015 - Initial public release                */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    The author is supplying this software for use with the VEX cortex        */
-/*    control system. this is free software; you can redistribute it           */
-/*    and/or modify it under the terms of the GNU General Public License       */
-/*    as published by the Free Software Foundation; either version 3 of        */
-/*    the License, or (at your option) any later version.                      */
-/*                                                                             */
-/*    This software is distributed in the hope that it will be useful,         */
-/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
-/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
-/*    GNU General Public License for more details.                             */
-/*                                                                             */
-/*    You should have received a copy of the GNU General Public License        */
-/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
-/*                                                                             */
-/*    The author can be contacted on the vex forums as jpearman                */
-/*    or electronic mail using jbpearman_at_mac_dot_com                        */
-/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    Description:                                                             */
-/*                                                                             */
-/*    Read and write user parameters to NV storage on the cortex               */
-/*    ROBOTC version                                                           */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-
-/*-----------------------------------------------------------------------------*/
-/** @file    flash_user.c
-  * @brief   Save a small number of user settings on the cortex
-*//*---------------------------------------------------------------------------*/
-
-// page 190 at present
-#define FLASH_USER_PAGE_ADDR    0x0805F000
-#define FLASH_USER_INDEX_SIZE   64
-#define FLASH_USER_MAX_WRITE    32
-#define FLASH_USER_PAGE_SIZE    512
-
-
-// Number of user parameter words
-// Do not change !!
-#define FLASH_USER_SIZE         8
-
-// Structure to hold user parameters
-typedef struct _flash_user {
-    // storage for the NV data
-    unsigned char data[FLASH_USER_SIZE * sizeof(uint32_t)];
-
-    // useful debug data
-             int  offset;
-    void          *addr;
-    } flash_user;
-
-// local storage for user parameters
-static  flash_user  params;
-
-// ROBOTC version 3.XX has issues with pointer calculations
-// so we declare a variable that holds the page address
-static  long        __FLASH_USER_PAGE_ADDR = FLASH_USER_PAGE_ADDR;
-
-/*-----------------------------------------------------------------------------*/
-/** @brief      Send the contents of the user params page to the debug stream  */
-/*-----------------------------------------------------------------------------*/
-
-void
-FlashUserDebug()
-{
-    unsigned char   *p;
-    int i,j;
-
-    p = (unsigned char *)__FLASH_USER_PAGE_ADDR;
-
-    for(j=0;j<128;j++)
-        {
-        writeDebugStream("%08X: ", (uint32_t)p);
-
-        for(i=0;i<16;i++)
-            writeDebugStream("%02X ", *p++);
-
-        writeDebugStreamLine("");
-
-        // allow debugger to empty buffer
-        wait1Msec(25);
-        }
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief      Get the offset into the user parameter block                   */
-/** @returns    The offset (0 to 55) or -1 indicating no parameters            */
-/*-----------------------------------------------------------------------------*/
-
-int
-FlashUserOffsetGet()
-{
-    uint16_t     *p;
-    int     offset = -1;
-    int     i;
-    uint16_t    su, sl;
-
-    // the first 64 words (256 bytes) are used as an index
-    // calculate user param offset
-    // look for non zero half word
-    p = (uint16_t *)FLASH_USER_PAGE_ADDR;
-
-    for(i=0;i<FLASH_USER_INDEX_SIZE;i++)
-        {
-        // avoids comparing with 0xFFFFFFFF which does not work
-        su = *p++;
-        sl = *p++;
-        if((su != 0xFFFF)||(sl != 0xFFFF))
-            offset++;
-         else
-            break;
-        }
-
-    return(offset);
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Read the user parameters                                        */
-/** @returns   a pointer to the user parameters                                */
-/*-----------------------------------------------------------------------------*/
-
-flash_user *
-FlashUserRead()
-{
-    uint32_t    *p = (uint32_t *)FLASH_USER_PAGE_ADDR;
-    uint32_t    *q = (uint32_t *)&params.data;
-    uint16_t     i;
-
-    params.offset = FlashUserOffsetGet();
-
-    if(params.offset == (-1))
-        {
-        // no user parameters
-        for(i=0;i<FLASH_USER_SIZE;i++)
-            *q++ = 0xFFFFFFFF;
-
-        // error
-        params.addr =  (uint32_t *)0;
-        }
-    else
-        {
-        // Set address ptr
-        p = (uint32_t *)(__FLASH_USER_PAGE_ADDR + ((FLASH_USER_INDEX_SIZE + (params.offset * FLASH_USER_SIZE)) * sizeof(uint32_t)));
-
-        // save address
-        params.addr = (uint32_t *)p;
-
-        // Now read params stored at offset
-        for(i=0;i<FLASH_USER_SIZE;i++)
-            *q++ = *p++;
-        }
-
-    return( &params );
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief      write user parameters                                          */
-/** @param[in]  u Pointer to user_param structure                              */
-/** @returns    status or error code                                           */
-/*-----------------------------------------------------------------------------*/
-
-int
-FlashUserWrite( flash_user *u )
-{
-    uint32_t     p = FLASH_USER_PAGE_ADDR;
-    uint32_t    *q = (uint32_t *)u->data;
-    uint16_t     i;
-
-    // limit number of writes per run
-    static  uint16_t flash_user_write_limit = 0;
-
-    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
-
-    int         ret = 1;
-
-    // check write limit
-    if( flash_user_write_limit >= FLASH_USER_MAX_WRITE )
-        return(FLASH_ERROR_WRITE_LIMIT);
-
-    // one more write
-    flash_user_write_limit++;
-
-    // Unlock the Flash Bank1 Program Erase controller
-    FLASH_UnlockBank1();
-
-    // Clear All pending flags
-    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
-
-    // Get current param offset
-    u->offset = FlashUserOffsetGet();
-
-    // Next block
-    u->offset++;
-
-    // did we fill the page ?
-    if( u->offset >= ((FLASH_USER_PAGE_SIZE - FLASH_USER_INDEX_SIZE) / FLASH_USER_SIZE) )
-        {
-#ifdef  FFDEBUG
-        writeDebugStreamLine("erase, offset is %d\n", u->offset);
-#endif
-        // Do erase here
-        FLASHStatus = FLASH_ErasePage(FLASH_USER_PAGE_ADDR);
-
-        // check for error
-        if( FLASHStatus != FLASH_COMPLETE )
-            return(FLASH_ERROR_ERASE);
-
-        // start over
-        u->offset = 0;
-        }
-
-    // start of area to write params
-    p = (uint32_t)(__FLASH_USER_PAGE_ADDR + ((FLASH_USER_INDEX_SIZE + (u->offset * FLASH_USER_SIZE)) * sizeof( uint32_t)));
-
-    // Save addr for debug
-    u->addr = (uint32_t *)p;
-
-    // Write data
-    for(i=0;i<FLASH_USER_SIZE;i++)
-        {
-        FLASHStatus = FLASH_ProgramWord( p, *q++ );
-
-        p += 4;
-
-        // check for error
-        if( FLASHStatus != FLASH_COMPLETE )
-            {
-            ret = FLASH_ERROR_WRITE;
-            break;
-            }
-        }
-
-
-    // Update data at offset
-    p = (uint32_t)(__FLASH_USER_PAGE_ADDR  + (u->offset * sizeof( uint32_t)));
-
-    FLASHStatus = FLASH_ProgramWord( p, 0);
-
-    // check for error
-    if( FLASHStatus != FLASH_COMPLETE )
-        ret = (FLASH_ERROR_WRITE);
-
-    return( ret );
-}
-
-/*-----------------------------------------------------------------------------*/
-/** @brief     Initialize the user parameter memory                            */
-/** @Returns    status or error code                                           */
-/*-----------------------------------------------------------------------------*/
-
-int
-FlashUserInit()
-{
-    static  int erase_done = 0;
-
-    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
-
-    if( !erase_done )
-        {
-        // only allow one init per run
-        erase_done = 1;
-
-        // Unlock the Flash Bank1 Program Erase controller
-        FLASH_UnlockBank1();
-
-        // Erase user parameters
-        FLASHStatus = FLASH_ErasePage(FLASH_USER_PAGE_ADDR);
-
-        // check for error
-        if( FLASHStatus != FLASH_COMPLETE )
-            return(FLASH_ERROR_ERASE);
-        }
-    else
-        {
-        return(FLASH_ERROR_ERASE_LIMIT);
-        }
-
-    return(1);
-}
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                 2012-2015                                   */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_user.c                                                 */
+/*    Author:     James Pearman                                                */
+/*    Created:    21 Aug 2012                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00     4 Apr 2015 - Initial public release                */
+/*                V1.01    17 Oct 2026 - Wear leveled page ring                */
+/*                V1.02    17 Oct 2026 - Add keyed parameter mode              */
+/*                V1.03    17 Oct 2026 - Binary search and cached offset       */
+/*                V1.04    17 Oct 2026 - Add FlashUserStat                     */
+/*                V1.05    17 Oct 2026 - Fail when the flash cannot be unlocked*/
+/*                V1.06    17 Oct 2026 - Write changed words as one entry      */
+/*                V1.07    17 Oct 2026 - Build without -w                      */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Description:                                                             */
+/*                                                                             */
+/*    Read and write user parameters to NV storage on the cortex               */
+/*    ROBOTC version                                                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+
+/*-----------------------------------------------------------------------------*/
+/** @file    flash_user.c
+  * @brief   Save a small number of user settings on the cortex
+*//*---------------------------------------------------------------------------*/
+
+// The user parameters are stored in a ring of pages at the top of flash,
+// each page holds 56 records.  Only the top two pages are outside the
+// ROBOTC file system, use more at your own risk.
+#ifndef FLASH_USER_PAGES
+#define FLASH_USER_PAGES        2
+#endif
+
+#define FLASH_USER_END_ADDR     0x08060000
+#define FLASH_USER_PAGE_BYTES   0x800
+#define FLASH_USER_BASE_ADDR    (FLASH_USER_END_ADDR - (FLASH_USER_PAGES * FLASH_USER_PAGE_BYTES))
+
+// page 190 at present, the only page used before the ring
+#define FLASH_USER_PAGE_ADDR    0x0805F000
+#define FLASH_USER_INDEX_SIZE   64
+#define FLASH_USER_PAGE_SIZE    512
+
+// Number of records in a page, index words after these are not used
+#define FLASH_USER_RECORDS      ((FLASH_USER_PAGE_SIZE - FLASH_USER_INDEX_SIZE) / FLASH_USER_SIZE)
+
+// The page header uses the last two index words
+#define FLASH_USER_SEQ_WORD     62
+#define FLASH_USER_MAGIC_WORD   63
+#define FLASH_USER_MAGIC        0x55534552
+#define FLASH_USER_MAGIC_LO     0x4552
+#define FLASH_USER_MAGIC_HI     0x5553
+
+// Define FLASH_USER_KEYED in user code to store values by key, each write
+// only stores the keys that changed.  Keys 0 to 7 are the parameter words
+// used by FlashUserRead and FlashUserWrite.  Parameters saved without
+// FLASH_USER_KEYED are not read, the pages are erased on the first write.
+// Keyed values are copied between pages so at least two are needed.
+#ifdef  FLASH_USER_KEYED
+// Number of keys and maximum value length in bytes
+#ifndef FLASH_USER_KEYS
+#define FLASH_USER_KEYS         32
+#endif
+#ifndef FLASH_USER_KEY_MAX_LEN
+#define FLASH_USER_KEY_MAX_LEN  64
+#endif
+
+// The page header is the first two words, entries follow
+#define FLASH_USER_KEY_HEADER   8
+#define FLASH_USER_KEY_MAGIC    0x5359454B
+#define FLASH_USER_KEY_MAGIC_LO 0x454B
+#define FLASH_USER_KEY_MAGIC_HI 0x5359
+
+// Keys written together are one entry with this key, the tag and value of
+// each follow one another and the group has one complete flag
+#define FLASH_USER_KEY_GROUP    0xFE
+#if FLASH_USER_KEYS > FLASH_USER_KEY_GROUP
+#error "FLASH_USER_KEYS must be no more than FLASH_USER_KEY_GROUP"
+#endif
+#endif
+
+// Maximum number of writes per run, can be overridden in user code
+#ifndef FLASH_USER_MAX_WRITE
+#define FLASH_USER_MAX_WRITE    32
+#endif
+
+
+// Number of user parameter words
+// Do not change !!
+#define FLASH_USER_SIZE         8
+
+// Structure to hold user parameters
+typedef struct _flash_user {
+    // storage for the NV data
+    unsigned char data[FLASH_USER_SIZE * sizeof(uint32_t)];
+
+    // useful debug data
+             int  offset;
+    void          *addr;
+    } flash_user;
+
+// Where the records are in the page ring
+typedef struct _flash_user_ring {
+    short   valid;                  ///< the pages have been scanned
+    short   head;                   ///< page being written
+    long    seq;                    ///< sequence number of head, -1 if no header
+    short   next;                   ///< next free record in head
+    short   page;                   ///< page with the newest record, -1 if none
+    short   offset;                 ///< newest record in that page
+    } flash_user_ring;
+
+// Space left in the parameter pages, records in the ring and bytes in the
+// keyed log
+typedef struct _flash_user_stat {
+    short   pages;                  ///< pages in the ring
+    short   size;                   ///< records or bytes a page holds
+    short   used;                   ///< records or bytes used in the page being written
+    short   free;                   ///< records or bytes left before a page is erased
+    long    erases;                 ///< pages erased since the ring was started
+    long    wear;                   ///< estimated erases of each page
+    } flash_user_stat;
+
+// local storage for user parameters
+static  flash_user  params;
+static  flash_user_ring user_ring;
+
+// ROBOTC version 3.XX has issues with pointer calculations
+// so we declare a variable that holds the page address
+#ifndef FLASH_USER_KEYED
+static  long        __FLASH_USER_PAGE_ADDR = FLASH_USER_PAGE_ADDR;
+#endif
+static  long        __FLASH_USER_BASE_ADDR = FLASH_USER_BASE_ADDR;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Send the contents of the user params pages to the debug stream */
+/*-----------------------------------------------------------------------------*/
+
+void
+FlashUserDebug()
+{
+    unsigned char   *p;
+    int i,j;
+
+    p = (unsigned char *)__FLASH_USER_BASE_ADDR;
+
+    for(j=0;j<(128 * FLASH_USER_PAGES);j++)
+        {
+        writeDebugStream("%08X: ", (uint32_t)p);
+
+        for(i=0;i<16;i++)
+            writeDebugStream("%02X ", *p++);
+
+        writeDebugStreamLine("");
+
+        // allow debugger to empty buffer
+        wait1Msec(25);
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Get the address of a page in the ring                          */
+/** @param[in]  page the page number, 0 to FLASH_USER_PAGES-1                  */
+/*-----------------------------------------------------------------------------*/
+
+static long
+FlashUserPageAddr( int page )
+{
+    return( __FLASH_USER_BASE_ADDR + (page * FLASH_USER_PAGE_BYTES) );
+}
+
+#ifdef  FLASH_USER_KEYED
+/*-----------------------------------------------------------------------------*/
+/** @brief   Keyed parameter store                                             */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Each page is a log of entries, a half word tag with the key in the high
+ *  byte and the length in the low byte, the value padded to a half word and
+ *  a half word that is programmed to 0 when the entry is complete.  The
+ *  newest complete entry for each key is its value.  FlashUserWrite writes
+ *  the parameter words that changed as a group entry, the key is
+ *  FLASH_USER_KEY_GROUP and the value is the tag and value of each word, so
+ *  a reset leaves either all of them or none.
+ *
+ *  When the page is full the newest value of every key is copied to the
+ *  oldest page in the ring, the page header magic number is written last so
+ *  an interrupted copy is ignored.
+ */
+
+typedef struct _flash_user_keys {
+    short   valid;                  ///< the log has been scanned
+    short   head;                   ///< page being written, -1 if none
+    long    seq;                    ///< sequence number of head
+    short   next;                   ///< offset of the next free entry
+    short   entry[FLASH_USER_KEYS]; ///< offset of the newest entry for each key
+    } flash_user_keys;
+
+static  flash_user_keys user_keys;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Get the sequence number of a keyed page                        */
+/** @param[in]  page the page number                                           */
+/** @returns    The sequence number or -1 if the page has no header            */
+/*-----------------------------------------------------------------------------*/
+
+static long
+FlashUserKeyPageSeq( int page )
+{
+    long      addr = FlashUserPageAddr( page );
+    uint16_t *p = (uint16_t *)(addr + sizeof(uint32_t));
+    uint32_t *s = (uint32_t *)addr;
+
+    // the magic number is written after the page is complete
+    if( (p[0] != FLASH_USER_KEY_MAGIC_LO) || (p[1] != FLASH_USER_KEY_MAGIC_HI) )
+        return(-1);
+
+    return( *s );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Size of an entry in flash                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeySize( int len )
+{
+    // tag, value and complete flag
+    return( 2 + ((len + 1) & ~1) + 2 );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Make a complete entry the newest value of its keys             */
+/** @param[in]  addr address of the page                                       */
+/** @param[in]  off offset of the entry                                        */
+/*-----------------------------------------------------------------------------*/
+
+static void
+FlashUserKeyFound( long addr, int off )
+{
+    unsigned char *p;
+    int     end;
+    int     key, len;
+
+    long tmp = addr + off;
+    p = (unsigned char *)tmp;
+
+    if( p[1] != FLASH_USER_KEY_GROUP )
+        {
+        user_keys.entry[ p[1] ] = off;
+        return;
+        }
+
+    // each key in a group, the complete flag is the group's
+    end = off + 2 + p[0];
+    for(off+=2;off<end;off+=FlashUserKeySize( len ) - 2)
+        {
+        tmp = addr + off;
+        p = (unsigned char *)tmp;
+        key = p[1];
+        len = p[0];
+
+        if( (key >= FLASH_USER_KEYS) || (len == 0) || (len > FLASH_USER_KEY_MAX_LEN) ||
+            ((off + FlashUserKeySize( len ) - 2) > end) )
+            break;
+
+        user_keys.entry[key] = off;
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Find the newest page and the newest entry for each key         */
+/*-----------------------------------------------------------------------------*/
+
+static void
+FlashUserKeyScan()
+{
+    uint16_t *p;
+    uint16_t  tag;
+    long    seq;
+    long    addr;
+    int     page;
+    int     off;
+    int     key, len;
+
+    user_keys.head = -1;
+    user_keys.seq  = -1;
+    user_keys.next = FLASH_USER_PAGE_BYTES;
+    for(key=0;key<FLASH_USER_KEYS;key++)
+        user_keys.entry[key] = -1;
+
+    for(page=0;page<FLASH_USER_PAGES;page++)
+        {
+        seq = FlashUserKeyPageSeq( page );
+        if( seq > user_keys.seq )
+            {
+            user_keys.seq  = seq;
+            user_keys.head = page;
+            }
+        }
+
+    user_keys.valid = 1;
+
+    if( user_keys.head < 0 )
+        return;
+
+    addr = FlashUserPageAddr( user_keys.head );
+
+    for(off=FLASH_USER_KEY_HEADER;off<FLASH_USER_PAGE_BYTES;)
+        {
+        p = (uint16_t *)(addr + off);
+        tag = *p;
+
+        // end of the log
+        if( tag == 0xFFFF )
+            break;
+
+        key = tag >> 8;
+        len = tag & 0xFF;
+
+        // not an entry we can step over, the page is treated as full
+        if( (len == 0) || ((off + FlashUserKeySize( len )) > FLASH_USER_PAGE_BYTES) ||
+            ((key != FLASH_USER_KEY_GROUP) && ((key >= FLASH_USER_KEYS) || (len > FLASH_USER_KEY_MAX_LEN))) )
+            {
+            off = FLASH_USER_PAGE_BYTES;
+            break;
+            }
+
+        // complete ?
+        p = (uint16_t *)(addr + off + FlashUserKeySize( len ) - 2);
+        if( *p == 0 )
+            FlashUserKeyFound( addr, off );
+
+        off += FlashUserKeySize( len );
+        }
+
+    user_keys.next = off;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Program the tag and value of an entry                          */
+/** @param[in]  addr address of the entry                                      */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to the value                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/*-----------------------------------------------------------------------------*/
+
+static FLASH_Status
+FlashUserKeyProgramValue( long addr, int key, unsigned char *data, int len )
+{
+    FLASH_Status FLASHStatus;
+    uint16_t  v;
+    int     i;
+
+    // tag
+    FLASHStatus = FLASH_ProgramHalfWord( addr, (key << 8) | len );
+    addr += 2;
+
+    // value
+    for(i=0;(i<len) && (FLASHStatus == FLASH_COMPLETE);i+=2)
+        {
+        v = data[i];
+        v |= ((i+1) < len) ? (data[i+1] << 8) : 0xFF00;
+        FLASHStatus = FLASH_ProgramHalfWord( addr, v );
+        addr += 2;
+        }
+
+    return(FLASHStatus);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Program an entry                                               */
+/** @param[in]  addr address of the entry                                      */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to the value                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/*-----------------------------------------------------------------------------*/
+
+static FLASH_Status
+FlashUserKeyProgram( long addr, int key, unsigned char *data, int len )
+{
+    FLASH_Status FLASHStatus;
+
+    FLASHStatus = FlashUserKeyProgramValue( addr, key, data, len );
+
+    // complete
+    if( FLASHStatus == FLASH_COMPLETE )
+        FLASHStatus = FLASH_ProgramHalfWord( addr + FlashUserKeySize( len ) - 2, 0 );
+
+    return(FLASHStatus);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Copy the newest entries to the oldest page                     */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeyCompact()
+{
+    FLASH_Status FLASHStatus;
+    unsigned char *src;
+    long    addr;
+    long    oldaddr = 0;
+    int     page;
+    int     off;
+    int     key, len;
+
+    page = user_keys.head + 1;
+    if( page >= FLASH_USER_PAGES )
+        page = 0;
+
+    if( user_keys.head >= 0 )
+        oldaddr = FlashUserPageAddr( user_keys.head );
+    addr = FlashUserPageAddr( page );
+
+#ifdef  FFDEBUG
+    writeDebugStreamLine("compact to page %d", page );
+#endif
+
+    FLASHStatus = FLASH_ErasePage( addr );
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASH_ERROR_ERASE);
+
+    // sequence number now, magic number when the copy is done
+    FLASHStatus = FLASH_ProgramWord( addr, user_keys.seq + 1 );
+
+    off = FLASH_USER_KEY_HEADER;
+    for(key=0;(key<FLASH_USER_KEYS) && (FLASHStatus == FLASH_COMPLETE);key++)
+        {
+        if( user_keys.entry[key] < 0 )
+            continue;
+
+        src = (unsigned char *)(oldaddr + user_keys.entry[key]);
+        len = src[0];
+
+        // values no longer fit in one page
+        if( (off + FlashUserKeySize( len )) > FLASH_USER_PAGE_BYTES )
+            {
+            user_keys.valid = 0;
+            return(FLASH_ERROR_WRITE);
+            }
+
+        FLASHStatus = FlashUserKeyProgram( addr + off, key, src + 2, len );
+        off += FlashUserKeySize( len );
+        }
+
+    if( FLASHStatus == FLASH_COMPLETE )
+        FLASHStatus = FLASH_ProgramWord( addr + sizeof(uint32_t), FLASH_USER_KEY_MAGIC );
+
+    // the new page is used next time the log is scanned
+    user_keys.valid = 0;
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASH_ERROR_WRITE);
+
+    FlashUserKeyScan();
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Check if a key already has a value                             */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to the value                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/** @returns    1 if the newest entry for the key has this value               */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeySame( int key, unsigned char *data, int len )
+{
+    unsigned char *p;
+    int     i;
+
+    if( !user_keys.valid )
+        FlashUserKeyScan();
+
+    if( user_keys.entry[key] < 0 )
+        return(0);
+
+    long tmp = FlashUserPageAddr( user_keys.head ) + user_keys.entry[key];
+    p = (unsigned char *)tmp;
+
+    if( p[0] != len )
+        return(0);
+
+    for(i=0;i<len;i++)
+        if( p[2+i] != data[i] )
+            return(0);
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Make room for an entry at the end of the log                   */
+/** @param[in]  size the size of the entry in flash                            */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeyRoom( int size )
+{
+    int     ret;
+
+    if( !user_keys.valid )
+        FlashUserKeyScan();
+
+    // Unlock the Flash Bank1 Program Erase controller and clear All pending
+    // flags, fails if another task has the controller
+    if( (FLASH_UnlockBank1() != FLASH_COMPLETE) ||
+        (FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR) != FLASH_COMPLETE) )
+        return(FLASH_ERROR_WRITE);
+
+    // did we fill the page ?
+    if( (user_keys.next + size) > FLASH_USER_PAGE_BYTES )
+        {
+        ret = FlashUserKeyCompact();
+        if( ret != 1 )
+            return(ret);
+
+        if( (user_keys.next + size) > FLASH_USER_PAGE_BYTES )
+            return(FLASH_ERROR_WRITE);
+        }
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Add an entry to the log                                        */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to the value                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeyAppend( int key, unsigned char *data, int len )
+{
+    FLASH_Status FLASHStatus;
+    int     ret;
+
+    ret = FlashUserKeyRoom( FlashUserKeySize( len ) );
+    if( ret != 1 )
+        return(ret);
+
+    FLASHStatus = FlashUserKeyProgram( FlashUserPageAddr( user_keys.head ) + user_keys.next, key, data, len );
+
+    // the entry uses this space even if it was not completed
+    if( FLASHStatus == FLASH_COMPLETE )
+        user_keys.entry[key] = user_keys.next;
+    user_keys.next += FlashUserKeySize( len );
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASH_ERROR_WRITE);
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Add the parameter words that changed as one group entry        */
+/** @param[in]  u Pointer to user_param structure                              */
+/** @param[in]  changed bit for each word that changed                         */
+/** @param[in]  count number of words that changed                             */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+
+static int
+FlashUserKeyAppendWords( flash_user *u, uint16_t changed, int count )
+{
+    FLASH_Status FLASHStatus;
+    long    page;
+    long    addr;
+    int     len;
+    int     ret;
+    int     i;
+
+    // tag and value of each word
+    len = count * (FlashUserKeySize( sizeof(uint32_t) ) - 2);
+
+    ret = FlashUserKeyRoom( FlashUserKeySize( len ) );
+    if( ret != 1 )
+        return(ret);
+
+    page = FlashUserPageAddr( user_keys.head );
+    addr = page + user_keys.next;
+
+    FLASHStatus = FLASH_ProgramHalfWord( addr, (FLASH_USER_KEY_GROUP << 8) | len );
+    addr += 2;
+
+    for(i=0;(i<FLASH_USER_SIZE) && (FLASHStatus == FLASH_COMPLETE);i++)
+        {
+        if( (changed & (1 << i)) == 0 )
+            continue;
+
+        FLASHStatus = FlashUserKeyProgramValue( addr, i, &u->data[i * sizeof(uint32_t)], sizeof(uint32_t) );
+        addr += FlashUserKeySize( sizeof(uint32_t) ) - 2;
+        }
+
+    // complete, every word at once
+    if( FLASHStatus == FLASH_COMPLETE )
+        FLASHStatus = FLASH_ProgramHalfWord( addr, 0 );
+
+    // the entry uses this space even if it was not completed
+    if( FLASHStatus == FLASH_COMPLETE )
+        FlashUserKeyFound( page, user_keys.next );
+    user_keys.next += FlashUserKeySize( len );
+
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASH_ERROR_WRITE);
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Read the value of a key                                        */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to storage for the value                          */
+/** @param[in]  maxlen size of the storage                                     */
+/** @returns    length of the value or -1 if the key has no value              */
+/*-----------------------------------------------------------------------------*/
+
+int
+FlashUserKeyRead( int key, unsigned char *data, int maxlen )
+{
+    unsigned char *p;
+    int     len;
+    int     i;
+
+    if( (key < 0) || (key >= FLASH_USER_KEYS) || (data == NULL) )
+        return(-1);
+
+    if( !user_keys.valid )
+        FlashUserKeyScan();
+
+    if( user_keys.entry[key] < 0 )
+        return(-1);
+
+    long tmp = FlashUserPageAddr( user_keys.head ) + user_keys.entry[key];
+    p = (unsigned char *)tmp;
+
+    len = p[0];
+    for(i=0;(i<len) && (i<maxlen);i++)
+        data[i] = p[2+i];
+
+    return(len);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Write the value of a key                                       */
+/** @param[in]  key the key                                                    */
+/** @param[in]  data pointer to the value                                      */
+/** @param[in]  len the length of the value in bytes                           */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Nothing is written if the value has not changed, and it does not count
+ *  towards FLASH_USER_MAX_WRITE.  All values together must fit in one page.
+ */
+
+int
+FlashUserKeyWrite( int key, unsigned char *data, int len )
+{
+    // limit number of writes per run
+    static  uint16_t flash_user_write_limit = 0;
+
+    if( (key < 0) || (key >= FLASH_USER_KEYS) || (data == NULL) )
+        return(FLASH_ERROR_WRITE);
+    if( (len <= 0) || (len > FLASH_USER_KEY_MAX_LEN) )
+        return(FLASH_ERROR_WRITE);
+
+    // nothing to do if the value has not changed
+    if( FlashUserKeySame( key, data, len ) )
+        return(1);
+
+    // check write limit
+    if( flash_user_write_limit >= FLASH_USER_MAX_WRITE )
+        return(FLASH_ERROR_WRITE_LIMIT);
+
+    // one more write
+    flash_user_write_limit++;
+
+    return( FlashUserKeyAppend( key, data, len ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Get the offset into the user parameter block                   */
+/** @returns    The offset of the end of the log or -1 indicating no parameters*/
+/*-----------------------------------------------------------------------------*/
+
+int
+FlashUserOffsetGet()
+{
+    if( !user_keys.valid )
+        FlashUserKeyScan();
+
+    if( user_keys.head < 0 )
+        return(-1);
+
+    return( user_keys.next );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read the user parameters                                        */
+/** @returns   a pointer to the user parameters                                */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Each parameter word is a key, words that have never been written read as
+ *  0xFFFFFFFF.
+ */
+
+flash_user *
+FlashUserRead()
+{
+    uint32_t    *q = (uint32_t *)&params.data;
+    uint16_t     i;
+
+    params.offset = FlashUserOffsetGet();
+    params.addr   = (uint32_t *)0;
+
+    for(i=0;i<FLASH_USER_SIZE;i++)
+        {
+        if( FlashUserKeyRead( i, (unsigned char *)q, sizeof(uint32_t) ) != sizeof(uint32_t) )
+            *q = 0xFFFFFFFF;
+        q++;
+        }
+
+    if( user_keys.head >= 0 )
+        params.addr = (uint32_t *)FlashUserPageAddr( user_keys.head );
+
+    return( &params );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      write user parameters                                          */
+/** @param[in]  u Pointer to user_param structure                              */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Only the parameter words that have changed are written, as one entry so
+ *  that a reset part way leaves all of them changed or none.  Nothing is
+ *  written if no word has changed, and it does not count towards
+ *  FLASH_USER_MAX_WRITE.
+ */
+
+int
+FlashUserWrite( flash_user *u )
+{
+    uint16_t     i;
+    uint16_t     changed = 0;
+    int          count = 0;
+    int          last = 0;
+
+    // limit number of writes per run
+    static  uint16_t flash_user_write_limit = 0;
+
+    int         ret = 1;
+
+    for(i=0;i<FLASH_USER_SIZE;i++)
+        {
+        if( !FlashUserKeySame( i, &u->data[i * sizeof(uint32_t)], sizeof(uint32_t) ) )
+            {
+            changed |= (1 << i);
+            count++;
+            last = i;
+            }
+        }
+
+    if( count > 0 )
+        {
+        // check write limit
+        if( flash_user_write_limit >= FLASH_USER_MAX_WRITE )
+            return(FLASH_ERROR_WRITE_LIMIT);
+
+        // one more write
+        flash_user_write_limit++;
+
+        // one word does not need a group
+        if( count == 1 )
+            ret = FlashUserKeyAppend( last, &u->data[last * sizeof(uint32_t)], sizeof(uint32_t) );
+        else
+            ret = FlashUserKeyAppendWords( u, changed, count );
+        }
+
+    u->offset = FlashUserOffsetGet();
+
+    return( ret );
+}
+
+#else   // FLASH_USER_KEYED
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Get the sequence number of a page                              */
+/** @param[in]  page the page number                                           */
+/** @returns    The sequence number or -1 if the page has no header            */
+/*-----------------------------------------------------------------------------*/
+
+static long
+FlashUserPageSeq( int page )
+{
+    long      addr = FlashUserPageAddr( page );
+    uint16_t *p = (uint16_t *)(addr + (FLASH_USER_MAGIC_WORD * sizeof(uint32_t)));
+    uint32_t *s = (uint32_t *)(addr + (FLASH_USER_SEQ_WORD * sizeof(uint32_t)));
+
+    // the magic number is written after the sequence number
+    if( (p[0] != FLASH_USER_MAGIC_LO) || (p[1] != FLASH_USER_MAGIC_HI) )
+        return(-1);
+
+    return( *s );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Scan the index of a page                                       */
+/** @param[in]  page the page number                                           */
+/** @param[out] next the first free record                                     */
+/** @param[out] last the newest complete record or -1                          */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The low half word of an index entry is programmed before the record is
+ *  written and the high half word after, a record is only used when both
+ *  have been programmed.  The original code programmed both together.
+ *
+ *  Records are used in order so the first free record is found with a
+ *  binary search, about 6 reads of the index.
+ */
+
+static void
+FlashUserPageScan( int page, short *next, short *last )
+{
+    uint16_t     *p;
+    int     lo, hi, mid;
+    uint16_t    su, sl;
+
+    long tmp = FlashUserPageAddr( page );
+    p = (uint16_t *)tmp;
+
+    // first index entry that is not used
+    lo = 0;
+    hi = FLASH_USER_RECORDS;
+    while( lo < hi )
+        {
+        mid = (lo + hi) >> 1;
+
+        // avoids comparing with 0xFFFFFFFF which does not work
+        su = p[ mid * 2 ];
+        sl = p[ mid * 2 + 1 ];
+        if((su == 0xFFFF) && (sl == 0xFFFF))
+            hi = mid;
+        else
+            lo = mid + 1;
+        }
+    *next = lo;
+
+    // newest complete record, normally the one before
+    for(*last = lo - 1;*last >= 0;(*last)--)
+        {
+        if( p[ *last * 2 + 1 ] != 0xFFFF )
+            break;
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Find the newest record and the page being written              */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The page with the highest sequence number is being written.  If it has no
+ *  complete records a page change was interrupted and the newest record is
+ *  in the page before.  With no page headers the parameters, if any, are in
+ *  the page used before the ring.
+ */
+
+static void
+FlashUserScan()
+{
+    long    seq;
+    long    best = -1;
+    long    prev = -1;
+    short   head = -1;
+    short   prevpage = -1;
+    short   next;
+    short   last;
+    int     page;
+
+    // already known, FlashUserWrite keeps this up to date
+    if( user_ring.valid )
+        return;
+
+    // read the page headers
+    for(page=0;page<FLASH_USER_PAGES;page++)
+        {
+        seq = FlashUserPageSeq( page );
+        if( seq < 0 )
+            continue;
+
+        if( seq > best )
+            {
+            prev     = best;
+            prevpage = head;
+            best     = seq;
+            head     = page;
+            }
+        else
+        if( seq > prev )
+            {
+            prev     = seq;
+            prevpage = page;
+            }
+        }
+
+    // no headers
+    if( head < 0 )
+        head = (__FLASH_USER_PAGE_ADDR - __FLASH_USER_BASE_ADDR) / FLASH_USER_PAGE_BYTES;
+
+    user_ring.head = head;
+    user_ring.seq  = best;
+
+    FlashUserPageScan( head, &next, &last );
+    user_ring.next   = next;
+    user_ring.page   = head;
+    user_ring.offset = last;
+
+    // page change was interrupted
+    if( (last < 0) && (prevpage >= 0) )
+        {
+        FlashUserPageScan( prevpage, &next, &last );
+        user_ring.page   = prevpage;
+        user_ring.offset = last;
+        }
+
+    if( user_ring.offset < 0 )
+        user_ring.page = -1;
+
+    user_ring.valid = 1;
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Write a page header                                            */
+/** @param[in]  page the page number                                           */
+/** @param[in]  seq the sequence number                                        */
+/*-----------------------------------------------------------------------------*/
+
+static FLASH_Status
+FlashUserPageHeader( int page, long seq )
+{
+    long    addr = FlashUserPageAddr( page );
+    FLASH_Status FLASHStatus;
+
+    FLASHStatus = FLASH_ProgramWord( addr + (FLASH_USER_SEQ_WORD * sizeof(uint32_t)), seq );
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASHStatus);
+
+    return( FLASH_ProgramWord( addr + (FLASH_USER_MAGIC_WORD * sizeof(uint32_t)), FLASH_USER_MAGIC ) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      Get the offset into the user parameter block                   */
+/** @returns    The offset (0 to 55) or -1 indicating no parameters            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  This is the offset of the newest record in the page that holds it.  The
+ *  pages are only scanned the first time this is called.
+ */
+
+int
+FlashUserOffsetGet()
+{
+    FlashUserScan();
+
+    return( user_ring.offset );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Read the user parameters                                        */
+/** @returns   a pointer to the user parameters                                */
+/*-----------------------------------------------------------------------------*/
+
+flash_user *
+FlashUserRead()
+{
+    uint32_t    *p;
+    uint32_t    *q = (uint32_t *)&params.data;
+    uint16_t     i;
+
+    params.offset = FlashUserOffsetGet();
+
+    if(params.offset == (-1))
+        {
+        // no user parameters
+        for(i=0;i<FLASH_USER_SIZE;i++)
+            *q++ = 0xFFFFFFFF;
+
+        // error
+        params.addr =  (uint32_t *)0;
+        }
+    else
+        {
+        // Set address ptr
+        p = (uint32_t *)(FlashUserPageAddr( user_ring.page ) + ((FLASH_USER_INDEX_SIZE + (params.offset * FLASH_USER_SIZE)) * sizeof(uint32_t)));
+
+        // save address
+        params.addr = (uint32_t *)p;
+
+        // Now read params stored at offset
+        for(i=0;i<FLASH_USER_SIZE;i++)
+            *q++ = *p++;
+        }
+
+    return( &params );
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief      write user parameters                                          */
+/** @param[in]  u Pointer to user_param structure                              */
+/** @returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  When the page is full the oldest page in the ring is erased and used
+ *  next, the previous parameters stay in the full page until the new record
+ *  is complete.
+ */
+
+int
+FlashUserWrite( flash_user *u )
+{
+    uint32_t     p;
+    uint32_t     index;
+    uint32_t    *q = (uint32_t *)u->data;
+    uint16_t     i;
+    int          page;
+
+    // limit number of writes per run
+    static  uint16_t flash_user_write_limit = 0;
+
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    int         ret = 1;
+
+    // check write limit
+    if( flash_user_write_limit >= FLASH_USER_MAX_WRITE )
+        return(FLASH_ERROR_WRITE_LIMIT);
+
+    // Unlock the Flash Bank1 Program Erase controller and clear All pending
+    // flags, fails if another task has the controller
+    if( (FLASH_UnlockBank1() != FLASH_COMPLETE) ||
+        (FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR) != FLASH_COMPLETE) )
+        return(FLASH_ERROR_WRITE);
+
+    // one more write
+    flash_user_write_limit++;
+
+    // Find the page being written, scan again if anything goes wrong
+    FlashUserScan();
+    user_ring.valid = 0;
+
+    // first write to a page used before the ring
+    if( user_ring.seq < 0 )
+        {
+        user_ring.seq = 0;
+        if( FlashUserPageHeader( user_ring.head, user_ring.seq ) != FLASH_COMPLETE )
+            return(FLASH_ERROR_WRITE);
+        }
+
+    // did we fill the page ?
+    if( user_ring.next >= FLASH_USER_RECORDS )
+        {
+        // the next page is the oldest
+        page = user_ring.head + 1;
+        if( page >= FLASH_USER_PAGES )
+            page = 0;
+
+#ifdef  FFDEBUG
+        writeDebugStreamLine("erase page %d, seq is %d\n", page, user_ring.seq + 1);
+#endif
+        // Do erase here
+        FLASHStatus = FLASH_ErasePage( FlashUserPageAddr( page ) );
+
+        // check for error
+        if( FLASHStatus != FLASH_COMPLETE )
+            return(FLASH_ERROR_ERASE);
+
+        // start over in the new page
+        user_ring.head = page;
+        user_ring.seq++;
+        user_ring.next = 0;
+
+        if( FlashUserPageHeader( user_ring.head, user_ring.seq ) != FLASH_COMPLETE )
+            return(FLASH_ERROR_WRITE);
+        }
+
+    u->offset = user_ring.next;
+
+    // index entry for this record
+    index = (uint32_t)(FlashUserPageAddr( user_ring.head ) + (u->offset * sizeof( uint32_t)));
+
+    // start of area to write params
+    p = (uint32_t)(FlashUserPageAddr( user_ring.head ) + ((FLASH_USER_INDEX_SIZE + (u->offset * FLASH_USER_SIZE)) * sizeof( uint32_t)));
+
+    // Save addr for debug
+    u->addr = (uint32_t *)p;
+
+    // Record started
+    FLASHStatus = FLASH_ProgramHalfWord( index, 0 );
+    if( FLASHStatus != FLASH_COMPLETE )
+        return(FLASH_ERROR_WRITE);
+
+    // Write data
+    for(i=0;i<FLASH_USER_SIZE;i++)
+        {
+        FLASHStatus = FLASH_ProgramWord( p, *q++ );
+
+        p += 4;
+
+        // check for error
+        if( FLASHStatus != FLASH_COMPLETE )
+            {
+            ret = FLASH_ERROR_WRITE;
+            break;
+            }
+        }
+
+    // Record complete, only if all the data was written
+    if( ret == 1 )
+        {
+        FLASHStatus = FLASH_ProgramHalfWord( index + 2, 0 );
+
+        // check for error
+        if( FLASHStatus != FLASH_COMPLETE )
+            ret = (FLASH_ERROR_WRITE);
+        }
+
+    // This is now the newest record
+    if( ret == 1 )
+        {
+        user_ring.next   = u->offset + 1;
+        user_ring.page   = user_ring.head;
+        user_ring.offset = u->offset;
+        user_ring.valid  = 1;
+        }
+
+    return( ret );
+}
+
+#endif  // FLASH_USER_KEYED
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Discard the cached location of the user parameters              */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  Call this if the parameter pages have been changed by something other
+ *  than this library, they are scanned again when next used.
+ */
+
+void
+FlashUserCacheInvalidate()
+{
+    user_ring.valid = 0;
+#ifdef  FLASH_USER_KEYED
+    user_keys.valid = 0;
+#endif
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Get the space left in the user parameter pages                  */
+/** @param[out] st pointer to a structure for the results                      */
+/** @returns   1 or FLASH_ERROR_WRITE if st is NULL                            */
+/*-----------------------------------------------------------------------------*/
+/** @details
+ *  The erase count comes from the sequence number of the newest page, the
+ *  pages are used in turn so each has been erased about erases / pages
+ *  times.  Only the first call after a reset reads the flash.
+ */
+
+int
+FlashUserStat( flash_user_stat *st )
+{
+    if( st == NULL )
+        return(FLASH_ERROR_WRITE);
+
+    st->pages = FLASH_USER_PAGES;
+
+#ifdef  FLASH_USER_KEYED
+    if( !user_keys.valid )
+        FlashUserKeyScan();
+
+    st->size = FLASH_USER_PAGE_BYTES - FLASH_USER_KEY_HEADER;
+    if( user_keys.head < 0 )
+        {
+        st->used   = 0;
+        st->erases = 0;
+        }
+    else
+        {
+        // the first page was erased when it was started
+        st->used   = user_keys.next - FLASH_USER_KEY_HEADER;
+        st->erases = user_keys.seq + 1;
+        }
+#else
+    FlashUserScan();
+
+    st->size   = FLASH_USER_RECORDS;
+    st->used   = user_ring.next;
+    st->erases = (user_ring.seq < 0) ? 0 : user_ring.seq;
+#endif
+
+    if( st->used > st->size )
+        st->used = st->size;
+    st->free = st->size - st->used;
+    st->wear = (st->erases + FLASH_USER_PAGES - 1) / FLASH_USER_PAGES;
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/** @brief     Initialize the user parameter memory                            */
+/** @Returns    status or error code                                           */
+/*-----------------------------------------------------------------------------*/
+
+int
+FlashUserInit()
+{
+    static  int erase_done = 0;
+    int     page;
+
+    volatile FLASH_Status FLASHStatus = FLASH_COMPLETE;
+
+    if( !erase_done )
+        {
+        // Unlock the Flash Bank1 Program Erase controller
+        if( FLASH_UnlockBank1() != FLASH_COMPLETE )
+            return(FLASH_ERROR_ERASE);
+
+        // only allow one init per run
+        erase_done = 1;
+
+        // Erase user parameters
+        for(page=0;page<FLASH_USER_PAGES;page++)
+            {
+            FLASHStatus = FLASH_ErasePage( FlashUserPageAddr( page ) );
+
+            // check for error
+            if( FLASHStatus != FLASH_COMPLETE )
+                return(FLASH_ERROR_ERASE);
+            }
+
+        FlashUserCacheInvalidate();
+        }
+    else
+        {
+        return(FLASH_ERROR_ERASE_LIMIT);
+        }
+
+    return(1);
+}
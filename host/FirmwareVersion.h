@@ -0,0 +1,41 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     FirmwareVersion.h                                            */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Stand in for the ROBOTC FirmwareVersion.h on a linux host            */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#ifndef __FIRMWARE_VERSION_HOST__
+#define __FIRMWARE_VERSION_HOST__
+
+// Simulate V4.30 unless told otherwise
+#ifndef kRobotCVersionNumeric
+#define kRobotCVersionNumeric       430
+#endif
+
+// File system location and size on the cortex
+#define kStartOfFileSystem          0x08018000
+#define kMaxNumbofFlashFiles        32
+
+// File types
+#define ftData                      0x0B
+
+#include "robotc.h"
+
+#endif  // __FIRMWARE_VERSION_HOST__
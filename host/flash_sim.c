@@ -0,0 +1,802 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_sim.c                                                  */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Allow writes at the ends of flash     */
+/*                V1.02    17 Oct 2026 - Simulate power failure                */
+/*                V1.03    17 Oct 2026 - Simulate preemption                   */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Simulated STM32F103 flash memory and flash controller                */
+/*                                                                             */
+/*        The flash image and the controller registers are mapped at their     */
+/*        cortex addresses so the library code runs unchanged.  Both mappings  */
+/*        are kept inaccessible, every access faults, the page is opened for   */
+/*        one instruction using the x86 trap flag and the access is then       */
+/*        checked against the controller state.  This enforces the rules of    */
+/*        the real hardware,                                                   */
+/*          - the controller must be unlocked with the key sequence            */
+/*          - flash is only written with PG set and a half word at a time      */
+/*          - a half word can only be programmed if it is erased (0xFFFF)      */
+/*            or is being cleared to 0x0000, otherwise PGERR is set            */
+/*          - erase is by page, PER then STRT with the page in AR              */
+/*          - program or erase of a protected page sets WRPRTERR               */
+/*        and keeps a virtual clock, BSY is set for the program or erase       */
+/*        time and every flash or register access costs a fixed time.         */
+/*                                                                             */
+/*        Linux on x86 and x86_64 only.                                        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "flash_sim.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+#if defined(__x86_64__)
+#define SIM_REG_EFL             REG_EFL
+#define SIM_REG_ERR             REG_ERR
+#elif defined(__i386__)
+#define SIM_REG_EFL             REG_EFL
+#define SIM_REG_ERR             REG_ERR
+#else
+#error "flash_sim needs an x86 host"
+#endif
+
+// x86 trap flag and page fault write bit
+#define SIM_EFL_TF              0x100
+#define SIM_ERR_WRITE           0x002
+
+#define SIM_HOST_PAGE           4096
+
+// register offsets
+#define SIM_ACR                 0x00
+#define SIM_KEYR                0x04
+#define SIM_OPTKEYR             0x08
+#define SIM_SR                  0x0C
+#define SIM_CR                  0x10
+#define SIM_AR                  0x14
+
+// register bits
+#define SIM_SR_BSY              0x00000001
+#define SIM_SR_PGERR            0x00000004
+#define SIM_SR_WRPRTERR         0x00000010
+#define SIM_SR_EOP              0x00000020
+
+#define SIM_CR_PG               0x00000001
+#define SIM_CR_PER              0x00000002
+#define SIM_CR_MER              0x00000004
+#define SIM_CR_STRT             0x00000040
+#define SIM_CR_LOCK             0x00000080
+
+#define SIM_KEY1                0x45670123
+#define SIM_KEY2                0xCDEF89AB
+
+// maximum number of host pages one instruction may touch
+#define SIM_MAX_OPEN            4
+
+/*-----------------------------------------------------------------------------*/
+/*  Controller state                                                           */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_sim {
+    uint8_t            *flash;              // flash image
+    uint32_t           *regs;               // register page
+    int                 fd;                 // image file or -1
+
+    // registers as the hardware holds them
+    uint32_t            acr;
+    uint32_t            sr;
+    uint32_t            cr;
+    uint32_t            ar;
+    int                 keystate;           // 0, 1 after KEY1
+    int                 lockout;            // bad key sequence
+
+    // operation in progress
+    int                 busy;
+    uint64_t            busy_until;
+
+    // protected range
+    uint32_t            wrp_start;
+    uint32_t            wrp_end;
+
+    // the instruction being single stepped
+    int                 nopen;
+    uint8_t            *open[SIM_MAX_OPEN];
+    int                 reg_access;
+    uint32_t            reg_snap[8];
+    int                 flash_write;
+    uint32_t            write_addr;
+    uint32_t            write_base;
+    int                 write_len;
+    uint8_t             write_snap[16];
+
+    // simulated power failure
+    int64_t             power_ops;          // operations until power fails, -1 never
+    int                 power_lost;
+
+    // other tasks run after the next SR read that shows BSY
+    uint64_t            preempt;
+
+    uint64_t            now;
+    flash_sim_timing    timing;
+    flash_sim_stats     stats;
+    } flash_sim;
+
+static  flash_sim   sim;
+
+/*-----------------------------------------------------------------------------*/
+/*  Report misuse of the controller and stop                                   */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_fatal( const char *msg, uint32_t addr )
+{
+    fprintf(stderr, "flash_sim: %s at %08X\n", msg, addr );
+    abort();
+}
+
+static int
+sim_in_flash( uintptr_t a )
+{
+    return( (a >= SIM_FLASH_BASE) && (a < (SIM_FLASH_BASE + SIM_FLASH_SIZE)) );
+}
+
+static int
+sim_in_regs( uintptr_t a )
+{
+    return( (a >= SIM_FLASH_R_BASE) && (a < (SIM_FLASH_R_BASE + SIM_HOST_PAGE)) );
+}
+
+static int
+sim_protected( uint32_t a )
+{
+    return( (a >= sim.wrp_start) && (a < sim.wrp_end) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Count down to a power failure, returns 1 once the power is off and the     */
+/*  operation must not complete                                                */
+/*-----------------------------------------------------------------------------*/
+
+static int
+sim_power_tick( void )
+{
+    if( sim.power_lost )
+        return(1);
+    if( sim.power_ops < 0 )
+        return(0);
+
+    if( sim.power_ops-- == 0 )
+        {
+        sim.power_lost = 1;
+        return(1);
+        }
+
+    return(0);
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Bring the busy state up to date with the virtual clock                     */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_update( void )
+{
+    if( sim.busy && sim.now >= sim.busy_until )
+        {
+        sim.busy = 0;
+        sim.sr  &= ~SIM_SR_BSY;
+        sim.sr  |= SIM_SR_EOP;
+        }
+}
+
+static void
+sim_start_op( uint64_t t )
+{
+    sim.busy       = 1;
+    sim.busy_until = sim.now + t;
+    sim.sr        |= SIM_SR_BSY;
+}
+
+// Accessing flash while an operation is in progress stalls the bus
+static void
+sim_stall( void )
+{
+    if( sim.busy )
+        {
+        sim.now = sim.busy_until;
+        sim_update();
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Page protection helpers                                                    */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_open( void *page, int prot )
+{
+    int i;
+
+    for(i=0;i<sim.nopen;i++)
+        if( sim.open[i] == page )
+            break;
+
+    if( i == sim.nopen )
+        {
+        if( sim.nopen == SIM_MAX_OPEN )
+            sim_fatal("too many pages for one instruction", (uint32_t)(uintptr_t)page );
+        sim.open[sim.nopen++] = (uint8_t *)page;
+        }
+
+    mprotect( page, SIM_HOST_PAGE, prot );
+}
+
+static void
+sim_close_all( void )
+{
+    int i;
+
+    for(i=0;i<sim.nopen;i++)
+        mprotect( sim.open[i], SIM_HOST_PAGE, PROT_NONE );
+    sim.nopen = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Register access, before and after the instruction                          */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_reg_pre( uintptr_t a, int write )
+{
+    uint32_t    off = (uint32_t)(a - SIM_FLASH_R_BASE);
+
+    sim.now += sim.timing.t_reg;
+    sim_update();
+
+    if( write )
+        sim.stats.reg_writes++;
+    else
+        {
+        sim.stats.reg_reads++;
+        if( off == SIM_SR && sim.busy )
+            sim.stats.busy_polls++;
+        }
+
+    sim_open( sim.regs, PROT_READ | PROT_WRITE );
+
+    // present the current register values
+    memset( sim.regs, 0, SIM_HOST_PAGE );
+    sim.regs[SIM_ACR/4] = sim.acr;
+    sim.regs[SIM_SR/4]  = sim.sr;
+    sim.regs[SIM_CR/4]  = sim.cr;
+    sim.regs[SIM_AR/4]  = sim.ar;
+    memcpy( sim.reg_snap, sim.regs, sizeof(sim.reg_snap) );
+
+    // the reader sees BSY and then does not run until the time has passed
+    if( !write && (off == SIM_SR) && sim.busy && (sim.preempt != 0) )
+        {
+        sim.now    += sim.preempt;
+        sim.preempt = 0;
+        }
+
+    sim.reg_access = 1;
+}
+
+static void
+sim_erase_page( uint32_t addr )
+{
+    uint8_t *page;
+
+    addr &= ~(SIM_FLASH_PAGE_SIZE - 1);
+
+    if( !sim_in_flash( addr ) )
+        sim_fatal("erase outside flash", addr );
+
+    if( sim_protected( addr ) )
+        {
+        sim.sr |= SIM_SR_WRPRTERR;
+        sim.stats.wrp_errors++;
+        return;
+        }
+
+    // flash pages are smaller than host pages
+    page = sim.flash + (addr - SIM_FLASH_BASE);
+
+    if( sim.power_lost )
+        return;
+
+    // power fails half way through the erase
+    if( sim_power_tick() )
+        {
+        mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE );
+        memset( page, 0xFF, SIM_FLASH_PAGE_SIZE / 2 );
+        mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+        return;
+        }
+
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE );
+    memset( page, 0xFF, SIM_FLASH_PAGE_SIZE );
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+
+    sim.stats.erases++;
+    sim_start_op( sim.timing.t_erase );
+}
+
+static void
+sim_reg_post( void )
+{
+    uint32_t    v;
+
+    // KEYR, unlock sequence
+    v = sim.regs[SIM_KEYR/4];
+    if( v != sim.reg_snap[SIM_KEYR/4] )
+        {
+        if( sim.keystate == 0 && v == SIM_KEY1 )
+            sim.keystate = 1;
+        else
+        if( sim.keystate == 1 && v == SIM_KEY2 )
+            {
+            sim.keystate = 0;
+            if( !sim.lockout )
+                sim.cr &= ~SIM_CR_LOCK;
+            }
+        else
+            {
+            // wrong sequence locks the FPEC until reset
+            sim.keystate = 0;
+            sim.lockout  = 1;
+            sim.cr      |= SIM_CR_LOCK;
+            sim_fatal("bad flash key sequence", SIM_FLASH_R_BASE + SIM_KEYR );
+            }
+        }
+
+    // SR, error and EOP flags are cleared by writing 1
+    v = sim.regs[SIM_SR/4];
+    if( v != sim.reg_snap[SIM_SR/4] )
+        sim.sr &= ~(v & (SIM_SR_EOP | SIM_SR_PGERR | SIM_SR_WRPRTERR));
+
+    // AR
+    v = sim.regs[SIM_AR/4];
+    if( v != sim.reg_snap[SIM_AR/4] )
+        sim.ar = v;
+
+    // ACR
+    sim.acr = sim.regs[SIM_ACR/4];
+
+    // CR
+    v = sim.regs[SIM_CR/4];
+    if( v != sim.reg_snap[SIM_CR/4] )
+        {
+        if( sim.cr & SIM_CR_LOCK )
+            {
+            if( v & (SIM_CR_PG | SIM_CR_PER | SIM_CR_MER | SIM_CR_STRT) )
+                sim_fatal("CR written while locked", SIM_FLASH_R_BASE + SIM_CR );
+            }
+        else
+            {
+            sim.cr = v & ~SIM_CR_STRT;
+
+            if( v & SIM_CR_STRT )
+                {
+                sim_stall();
+
+                if( v & SIM_CR_MER )
+                    sim_fatal("mass erase not supported", SIM_FLASH_R_BASE + SIM_CR );
+                else
+                if( v & SIM_CR_PER )
+                    sim_erase_page( sim.ar );
+                }
+            }
+        }
+
+    sim.reg_access = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Flash access, before and after the instruction                             */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_flash_pre( uintptr_t a, int write )
+{
+    uint8_t *page = (uint8_t *)(a & ~(uintptr_t)(SIM_HOST_PAGE - 1));
+
+    if( !write )
+        {
+        sim.now += sim.timing.t_read;
+        sim.stats.reads++;
+        sim_open( page, PROT_READ );
+        return;
+        }
+
+    sim.now += sim.timing.t_reg;
+    sim_stall();
+
+    if( !(sim.cr & SIM_CR_PG) )
+        sim_fatal("flash write without PG set", (uint32_t)a );
+
+    sim.flash_write = 1;
+    sim.write_addr  = (uint32_t)a & ~1;
+
+    // bytes around the write that must not change, within the flash
+    sim.write_base  = (sim.write_addr & ~7) - 4;
+    sim.write_len   = 16;
+    if( sim.write_base < SIM_FLASH_BASE )
+        {
+        sim.write_len -= SIM_FLASH_BASE - sim.write_base;
+        sim.write_base = SIM_FLASH_BASE;
+        }
+    if( sim.write_base + sim.write_len > SIM_FLASH_BASE + SIM_FLASH_SIZE )
+        sim.write_len = SIM_FLASH_BASE + SIM_FLASH_SIZE - sim.write_base;
+
+    sim_open( page, PROT_READ | PROT_WRITE );
+    // the check window may cross into the next or previous page
+    if( sim.write_base < (uint32_t)(uintptr_t)page )
+        sim_open( page - SIM_HOST_PAGE, PROT_READ );
+    if( sim.write_base + sim.write_len > (uint32_t)(uintptr_t)page + SIM_HOST_PAGE )
+        sim_open( page + SIM_HOST_PAGE, PROT_READ );
+
+    // keep the surrounding bytes to check the size of the write
+    memcpy( sim.write_snap, sim.flash + (sim.write_base - SIM_FLASH_BASE), sim.write_len );
+}
+
+static void
+sim_flash_post( void )
+{
+    uint32_t    base = sim.write_base;
+    uint8_t    *p    = sim.flash + (base - SIM_FLASH_BASE);
+    int         off  = sim.write_addr - base;
+    uint16_t    old, val;
+    int         i;
+
+    // only the addressed half word may change
+    for(i=0;i<sim.write_len;i++)
+        {
+        if( i == off || i == off+1 )
+            continue;
+        if( p[i] != sim.write_snap[i] )
+            sim_fatal("flash write is not a half word", base + i );
+        }
+
+    old = sim.write_snap[off] | (sim.write_snap[off+1] << 8);
+    val = p[off] | (p[off+1] << 8);
+
+    if( sim_power_tick() )
+        {
+        // no power, the location is unchanged
+        p[off]   = sim.write_snap[off];
+        p[off+1] = sim.write_snap[off+1];
+        }
+    else
+    if( sim_protected( sim.write_addr ) )
+        {
+        p[off]   = sim.write_snap[off];
+        p[off+1] = sim.write_snap[off+1];
+        sim.sr  |= SIM_SR_WRPRTERR;
+        sim.stats.wrp_errors++;
+        }
+    else
+    if( old != 0xFFFF && val != 0x0000 )
+        {
+        // not erased, the location is unchanged
+        p[off]   = sim.write_snap[off];
+        p[off+1] = sim.write_snap[off+1];
+        sim.sr  |= SIM_SR_PGERR;
+        sim.stats.pg_errors++;
+        }
+    else
+        {
+        sim.stats.programs++;
+        sim_start_op( sim.timing.t_prog );
+        }
+
+    sim.flash_write = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Signal handlers                                                            */
+/*-----------------------------------------------------------------------------*/
+
+static void
+sim_segv( int sig, siginfo_t *si, void *ctx )
+{
+    ucontext_t *uc = (ucontext_t *)ctx;
+    uintptr_t   a  = (uintptr_t)si->si_addr;
+    int         write = (uc->uc_mcontext.gregs[SIM_REG_ERR] & SIM_ERR_WRITE) != 0;
+
+    if( sim_in_regs( a ) )
+        sim_reg_pre( a, write );
+    else
+    if( sim_in_flash( a ) )
+        sim_flash_pre( a, write );
+    else
+        {
+        // a real fault, let it happen
+        signal( sig, SIG_DFL );
+        return;
+        }
+
+    // run the instruction then trap
+    uc->uc_mcontext.gregs[SIM_REG_EFL] |= SIM_EFL_TF;
+}
+
+static void
+sim_trap( int sig, siginfo_t *si, void *ctx )
+{
+    ucontext_t *uc = (ucontext_t *)ctx;
+
+    (void)sig;
+    (void)si;
+
+    uc->uc_mcontext.gregs[SIM_REG_EFL] &= ~SIM_EFL_TF;
+
+    if( sim.reg_access )
+        sim_reg_post();
+    if( sim.flash_write )
+        sim_flash_post();
+
+    sim_close_all();
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Public interface                                                           */
+/*-----------------------------------------------------------------------------*/
+
+int
+flash_sim_init( const char *image )
+{
+    struct sigaction sa;
+    struct stat      st;
+    void            *p;
+    int              fresh = 1;
+
+    memset( &sim, 0, sizeof(sim) );
+    sim.fd        = -1;
+    sim.power_ops = -1;
+
+    // typical values from the STM32F103 datasheet, register and read costs
+    // are a rough figure for the ROBOTC virtual machine
+    sim.timing.t_prog  =    52500;
+    sim.timing.t_erase = 20000000;
+    sim.timing.t_reg   =     5000;
+    sim.timing.t_read  =     1000;
+
+    if( image != NULL )
+        {
+        sim.fd = open( image, O_RDWR | O_CREAT, 0644 );
+        if( sim.fd < 0 )
+            {
+            perror( image );
+            return(-1);
+            }
+        if( fstat( sim.fd, &st ) == 0 && st.st_size == SIM_FLASH_SIZE )
+            fresh = 0;
+        else
+        if( ftruncate( sim.fd, SIM_FLASH_SIZE ) != 0 )
+            {
+            perror( image );
+            return(-1);
+            }
+        p = mmap( (void *)SIM_FLASH_BASE, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_FIXED_NOREPLACE, sim.fd, 0 );
+        }
+    else
+        p = mmap( (void *)SIM_FLASH_BASE, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+
+    if( p != (void *)SIM_FLASH_BASE )
+        {
+        fprintf(stderr, "flash_sim: cannot map flash at %08X\n", SIM_FLASH_BASE );
+        return(-1);
+        }
+    sim.flash = (uint8_t *)p;
+
+    p = mmap( (void *)SIM_FLASH_R_BASE, SIM_HOST_PAGE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+    if( p != (void *)SIM_FLASH_R_BASE )
+        {
+        fprintf(stderr, "flash_sim: cannot map registers at %08X\n", SIM_FLASH_R_BASE );
+        return(-1);
+        }
+    sim.regs = (uint32_t *)p;
+
+    if( fresh )
+        memset( sim.flash, 0xFF, SIM_FLASH_SIZE );
+
+    flash_sim_reset();
+
+    memset( &sa, 0, sizeof(sa) );
+    sigemptyset( &sa.sa_mask );
+    sa.sa_flags     = SA_SIGINFO;
+    sa.sa_sigaction = sim_segv;
+    sigaction( SIGSEGV, &sa, NULL );
+    sa.sa_sigaction = sim_trap;
+    sigaction( SIGTRAP, &sa, NULL );
+
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+    mprotect( sim.regs, SIM_HOST_PAGE, PROT_NONE );
+
+    return(0);
+}
+
+void
+flash_sim_close( void )
+{
+    signal( SIGSEGV, SIG_DFL );
+    signal( SIGTRAP, SIG_DFL );
+
+    if( sim.flash != NULL )
+        {
+        mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE );
+        if( sim.fd >= 0 )
+            msync( sim.flash, SIM_FLASH_SIZE, MS_SYNC );
+        munmap( sim.flash, SIM_FLASH_SIZE );
+        }
+    if( sim.regs != NULL )
+        munmap( sim.regs, SIM_HOST_PAGE );
+    if( sim.fd >= 0 )
+        close( sim.fd );
+
+    sim.flash = NULL;
+    sim.regs  = NULL;
+    sim.fd    = -1;
+}
+
+// Set the write protected range, WRP covers the firmware on a real cortex
+void
+flash_sim_protect( uint32_t start, uint32_t end )
+{
+    sim.wrp_start = start;
+    sim.wrp_end   = end;
+}
+
+// Controller state after a system reset
+void
+flash_sim_reset( void )
+{
+    sim.acr        = 0x30;
+    sim.sr         = 0;
+    sim.cr         = SIM_CR_LOCK;
+    sim.ar         = 0;
+    sim.keystate   = 0;
+    sim.lockout    = 0;
+    sim.busy       = 0;
+    sim.busy_until = 0;
+}
+
+// Power fails when ops more program or erase operations have completed,
+// the flash is then unchanged until this is called again with -1
+void
+flash_sim_power_fail( int64_t ops )
+{
+    sim.power_ops  = ops;
+    sim.power_lost = 0;
+}
+
+int
+flash_sim_power_lost( void )
+{
+    return( sim.power_lost );
+}
+
+// The next SR read that returns BSY is followed by ns of other tasks
+// running, the operation finishes before the reader looks again
+void
+flash_sim_preempt( uint64_t ns )
+{
+    sim.preempt = ns;
+}
+
+// Back door access to the flash image, not timed or counted
+void
+flash_sim_fill( uint32_t addr, uint8_t value, uint32_t len )
+{
+    if( !sim_in_flash( addr ) || !sim_in_flash( addr + len - 1 ) )
+        sim_fatal("fill outside flash", addr );
+
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE );
+    memset( sim.flash + (addr - SIM_FLASH_BASE), value, len );
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+}
+
+void
+flash_sim_poke( uint32_t addr, const void *src, uint32_t len )
+{
+    if( !sim_in_flash( addr ) || !sim_in_flash( addr + len - 1 ) )
+        sim_fatal("poke outside flash", addr );
+
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE );
+    memcpy( sim.flash + (addr - SIM_FLASH_BASE), src, len );
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+}
+
+void
+flash_sim_peek( uint32_t addr, void *dst, uint32_t len )
+{
+    if( !sim_in_flash( addr ) || !sim_in_flash( addr + len - 1 ) )
+        sim_fatal("peek outside flash", addr );
+
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_READ );
+    memcpy( dst, sim.flash + (addr - SIM_FLASH_BASE), len );
+    mprotect( sim.flash, SIM_FLASH_SIZE, PROT_NONE );
+}
+
+flash_sim_timing *
+flash_sim_get_timing( void )
+{
+    return( &sim.timing );
+}
+
+flash_sim_stats *
+flash_sim_get_stats( void )
+{
+    return( &sim.stats );
+}
+
+void
+flash_sim_clear_stats( void )
+{
+    memset( &sim.stats, 0, sizeof(sim.stats) );
+}
+
+uint64_t
+flash_sim_time_ns( void )
+{
+    return( sim.now );
+}
+
+// Time passing outside of flash access, waits and other code
+void
+flash_sim_advance_ns( uint64_t ns )
+{
+    sim.now += ns;
+    sim_update();
+}
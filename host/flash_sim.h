@@ -0,0 +1,113 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     flash_sim.h                                                  */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Simulate power failure                */
+/*                V1.02    17 Oct 2026 - Simulate preemption                   */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Simulated STM32F103 flash memory and flash controller (FPEC) for     */
+/*        running the flash library on a linux host                            */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#ifndef __FLASH_SIM__
+#define __FLASH_SIM__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The VEX cortex uses an STM32F103VD, 384K of flash in 2K pages
+#define SIM_FLASH_BASE          0x08000000
+#define SIM_FLASH_SIZE          0x00060000
+#define SIM_FLASH_PAGE_SIZE     0x00000800
+
+// Flash controller registers
+#define SIM_FLASH_R_BASE        0x40022000
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Timing model, all times in nS                                     */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_sim_timing {
+    uint64_t    t_prog;                 ///< half word program time
+    uint64_t    t_erase;                ///< page erase time
+    uint64_t    t_reg;                  ///< cost of one register access
+    uint64_t    t_read;                 ///< cost of one flash read
+    } flash_sim_timing;
+
+/*-----------------------------------------------------------------------------*/
+/** @brief   Access counters                                                   */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _flash_sim_stats {
+    uint64_t    reads;                  ///< flash read accesses
+    uint64_t    reg_reads;              ///< flash controller register reads
+    uint64_t    reg_writes;             ///< flash controller register writes
+    uint64_t    busy_polls;             ///< SR reads that returned BSY
+    uint64_t    programs;               ///< half words programmed
+    uint64_t    erases;                 ///< pages erased
+    uint64_t    pg_errors;              ///< program to a non erased location
+    uint64_t    wrp_errors;             ///< program or erase of protected flash
+    } flash_sim_stats;
+
+int                 flash_sim_init( const char *image );
+void                flash_sim_close( void );
+
+void                flash_sim_protect( uint32_t start, uint32_t end );
+void                flash_sim_reset( void );
+void                flash_sim_power_fail( int64_t ops );
+int                 flash_sim_power_lost( void );
+void                flash_sim_preempt( uint64_t ns );
+void                flash_sim_fill( uint32_t addr, uint8_t value, uint32_t len );
+void                flash_sim_poke( uint32_t addr, const void *src, uint32_t len );
+void                flash_sim_peek( uint32_t addr, void *dst, uint32_t len );
+
+flash_sim_timing   *flash_sim_get_timing( void );
+flash_sim_stats    *flash_sim_get_stats( void );
+void                flash_sim_clear_stats( void );
+
+uint64_t            flash_sim_time_ns( void );
+void                flash_sim_advance_ns( uint64_t ns );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __FLASH_SIM__
@@ -0,0 +1,2916 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     rcfs_bench.c                                                 */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Add background write benchmark        */
+/*                V1.02    17 Oct 2026 - Add erase timeout check               */
+/*                V1.03    17 Oct 2026 - Add user parameter page ring checks   */
+/*                V1.04    17 Oct 2026 - Add keyed user parameter benchmark    */
+/*                V1.05    17 Oct 2026 - Time first FlashUserRead              */
+/*                V1.06    17 Oct 2026 - Add delete and compaction checks      */
+/*                V1.07    17 Oct 2026 - Add circular log checks               */
+/*                V1.08    17 Oct 2026 - Add telemetry file benchmark          */
+/*                V1.09    17 Oct 2026 - Add compressed file benchmark         */
+/*                V1.10    17 Oct 2026 - Add RCFS_Read and RCFS_Map checks     */
+/*                V1.11    17 Oct 2026 - Add record and replay benchmark       */
+/*                V1.12    17 Oct 2026 - Add RCFS_Verify checks                */
+/*                V1.13    17 Oct 2026 - Add RCFS_AddFile power loss checks    */
+/*                V1.14    17 Oct 2026 - Add layout detection checks           */
+/*                V1.15    17 Oct 2026 - Add RCFS_Stat and FlashUserStat check */
+/*                V1.16    17 Oct 2026 - Add write error and verify checks     */
+/*                V1.17    17 Oct 2026 - Add controller lock check             */
+/*                V1.18    17 Oct 2026 - Add sample ring check                 */
+/*                V1.19    17 Oct 2026 - Build the VTOC cache after a reset    */
+/*                V1.20    17 Oct 2026 - Add streamed file power loss checks   */
+/*                V1.21    17 Oct 2026 - Add unlock status and hogCPU checks   */
+/*                V1.22    17 Oct 2026 - Add a file ending at RCFS_DATA_END    */
+/*                V1.23    17 Oct 2026 - Check the VTOC page is not erased     */
+/*                V1.24    17 Oct 2026 - Add failed delete checks              */
+/*                V1.25    17 Oct 2026 - Add a queued write error check        */
+/*                V1.26    17 Oct 2026 - Check telemetry is not compressed     */
+/*                V1.27    17 Oct 2026 - Add a full ring file check            */
+/*                V1.28    17 Oct 2026 - Add a failed close check              */
+/*                V1.29    17 Oct 2026 - Check failed queued files             */
+/*                V1.30    17 Oct 2026 - Use the flash mutex names             */
+/*                V1.31    17 Oct 2026 - Check waits that were preempted       */
+/*                V1.32    17 Oct 2026 - Export a damaged file                 */
+/*                V1.33    17 Oct 2026 - Interrupted keyed FlashUserWrite      */
+/*                V1.34    17 Oct 2026 - Build without -w                      */
+/*                V1.35    17 Oct 2026 - Power lost mid page in the log        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Benchmark the flash library against the simulated flash controller   */
+/*                                                                             */
+/*        Times are from the simulator's virtual clock in uS, flash reads      */
+/*        are counted per access so they show how much of the file system a    */
+/*        call has to look at.                                                 */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include <FirmwareVersion.h>
+
+// no write limit when benchmarking
+#define FLASH_USER_MAX_WRITE    0x7FFF
+
+// 16K circular log
+#define RCFS_LOG_PAGES          8
+
+#include <FlashLib.h>
+
+/*-----------------------------------------------------------------------------*/
+/*  Measurement of one or more calls                                           */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _bench_result {
+    int             calls;
+    uint64_t        t_total;
+    uint64_t        t_min;
+    uint64_t        t_max;
+    uint64_t        reads;
+    uint64_t        programs;
+    uint64_t        erases;
+    uint64_t        polls;
+    } bench_result;
+
+static  uint64_t            bench_t0;
+static  flash_sim_stats     bench_s0;
+static  int                 bench_errors = 0;
+
+static void
+BenchClear( bench_result *r )
+{
+    memset( r, 0, sizeof(bench_result) );
+    r->t_min = ~(uint64_t)0;
+}
+
+static void
+BenchStart()
+{
+    bench_t0 = flash_sim_time_ns();
+    bench_s0 = *flash_sim_get_stats();
+}
+
+static void
+BenchStop( bench_result *r )
+{
+    uint64_t         t = flash_sim_time_ns() - bench_t0;
+    flash_sim_stats *s = flash_sim_get_stats();
+
+    r->calls++;
+    r->t_total  += t;
+    if( t < r->t_min ) r->t_min = t;
+    if( t > r->t_max ) r->t_max = t;
+    r->reads    += s->reads      - bench_s0.reads;
+    r->programs += s->programs   - bench_s0.programs;
+    r->erases   += s->erases     - bench_s0.erases;
+    r->polls    += s->busy_polls - bench_s0.busy_polls;
+}
+
+static double
+BenchMean( bench_result *r )
+{
+    return( r->calls ? (double)r->t_total / r->calls / 1000.0 : 0.0 );
+}
+
+static void
+BenchFail( const char *msg )
+{
+    printf("FAIL: %s\n", msg );
+    bench_errors++;
+}
+
+// Restart the program, only the flash is kept
+static void
+BenchReboot()
+{
+    flash_sim_power_fail( -1 );
+    flash_sim_reset();
+
+    memset( &write_stream, 0, sizeof(write_stream) );
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+#ifdef RCFS_COMPACT
+    compact_checked = 0;
+#endif
+    boot_checked = 0;
+    rcfs_layout.valid = 0;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Create an empty file system, offset and hsize give the ROBOTC layout       */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchFormatLayout( int offset, int hsize, int program )
+{
+    uint32_t        vtoc[2];
+    unsigned char   hdr[24];
+
+    // erase file system and user parameters
+    flash_sim_fill( kStartOfFileSystem, 0xFF, SIM_FLASH_BASE + SIM_FLASH_SIZE - kStartOfFileSystem );
+
+    // file system header, contents are not used by the library
+    flash_sim_fill( kStartOfFileSystem, 0x00, offset );
+
+    // the user program is the first file
+    if( program )
+        {
+        vtoc[0] = 0x200;
+        vtoc[1] = 0x2000;
+        flash_sim_poke( kStartOfFileSystem + offset, vtoc, sizeof(vtoc) );
+
+        memset( hdr, 0, sizeof(hdr) );
+        strcpy( (char *)hdr, "program" );
+        hdr[16] = 0x01;
+        flash_sim_poke( kStartOfFileSystem + vtoc[0], hdr, hsize );
+        }
+
+    // the firmware is write protected
+    flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem );
+    flash_sim_reset();
+
+    rcfs_layout.valid = 0;
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+    FlashUserCacheInvalidate();
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Create an empty file system holding one ROBOTC file                        */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchFormat()
+{
+    BenchFormatLayout( RCFS_BUILD_VTOC_OFFSET, RCFS_BUILD_HEADER_SIZE, 1 );
+}
+
+static void
+BenchFill( unsigned char *buf, int len, int seed )
+{
+    int i;
+
+    for(i=0;i<len;i++)
+        buf[i] = (unsigned char)(seed * 31 + i * 7);
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_AddFile across file sizes                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchAddFile()
+{
+    static int sizes[] = { 16, 256, 1024, 4096, 8192 };
+    static unsigned char buf[MAX_FLASH_FILE_SIZE];
+    bench_result    r;
+    unsigned char  *data;
+    int             datalength;
+    char            name[16];
+    int             i, n;
+
+    printf("\nRCFS_AddFile, 4 files of each size\n");
+    printf("%8s %10s %10s %10s %10s %10s\n", "bytes", "mean uS", "max uS", "KB/s", "prog/call", "poll/call");
+
+    for(i=0;i<(int)(sizeof(sizes)/sizeof(int));i++)
+        {
+        BenchFormat();
+        BenchClear( &r );
+
+        for(n=0;n<4;n++)
+            {
+            BenchFill( buf, sizes[i], n );
+            sprintf( name, "f%03d", n );
+
+            BenchStart();
+            if( RCFS_AddFile( buf, sizes[i], name ) != RCFS_SUCCESS )
+                BenchFail("RCFS_AddFile");
+            BenchStop( &r );
+
+            // check what was written
+            if( RCFS_GetFile( name, &data, &datalength ) != RCFS_SUCCESS ||
+                datalength != sizes[i] || memcmp( data, buf, sizes[i] ) != 0 )
+                BenchFail("file contents");
+            }
+
+        printf("%8d %10.1f %10.1f %10.1f %10.1f %10.1f\n", sizes[i],
+            BenchMean( &r ), r.t_max / 1000.0,
+            (sizes[i] / 1024.0) / (BenchMean( &r ) / 1000000.0),
+            (double)r.programs / r.calls, (double)r.polls / r.calls );
+        }
+}
+
+#ifdef RCFS_COMPRESS
+/*-----------------------------------------------------------------------------*/
+/*  Compressed files                                                           */
+/*-----------------------------------------------------------------------------*/
+
+#define BENCH_LZ_SIZE           MAX_FLASH_FILE_SIZE
+
+// 0 sensor samples, 1 text log, 2 noise
+static void
+BenchLzData( unsigned char *buf, int len, int kind )
+{
+    int     i, n = 0;
+    char    line[48];
+
+    if( kind == 0 )
+        {
+        // time, encoder, gyro and motor as 16 bit values
+        for(i=0;(i+8)<=len;i+=8,n++)
+            {
+            short v[4];
+            v[0] = n * 10;
+            v[1] = (n * n) / 40 - n * 3;
+            v[2] = (short)(900.0 * sin( n / 150.0 ));
+            v[3] = ((n / 50) & 1) ? 127 : -60;
+            memcpy( &buf[i], v, 8 );
+            }
+        for( ;i<len;i++)
+            buf[i] = 0;
+        }
+    else
+    if( kind == 1 )
+        {
+        for(i=0;i<len;)
+            {
+            snprintf( line, sizeof(line), "%6d,%6d,%5d,%4d\n", n * 10, (n * n) / 40 - n * 3,
+                (int)(900.0 * sin( n / 150.0 )), ((n / 50) & 1) ? 127 : -60 );
+            n++;
+            for(int k=0;line[k] && i<len;k++)
+                buf[i++] = line[k];
+            }
+        }
+    else
+        {
+        srand( 1 );
+        for(i=0;i<len;i++)
+            buf[i] = rand();
+        }
+}
+
+static void
+BenchCompress()
+{
+    static const char   *kinds[] = { "sensor", "text", "noise" };
+    static unsigned char buf[BENCH_LZ_SIZE];
+    static unsigned char copy[BENCH_LZ_SIZE];
+    bench_result    plain, lz, rd;
+    unsigned char  *data;
+    int             datalength, plainlength;
+    int             h, i, k, n;
+
+    printf("\nRCFS_AddFile with compression, %d byte files\n", BENCH_LZ_SIZE );
+    printf("%8s %10s %10s %10s %10s %10s %10s\n", "data", "stored", "plain uS", "lz uS", "plain prog", "lz prog", "read uS");
+
+    for(k=0;k<3;k++)
+        {
+        BenchLzData( buf, BENCH_LZ_SIZE, k );
+        BenchFormat();
+
+        BenchClear( &plain );
+        BenchStart();
+        if( RCFS_AddFile( buf, BENCH_LZ_SIZE, "plain" ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile plain");
+        BenchStop( &plain );
+
+        RCFS_SetCompression( 1 );
+        BenchClear( &lz );
+        BenchStart();
+        if( RCFS_AddFile( buf, BENCH_LZ_SIZE, "lz" ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile compressed");
+        BenchStop( &lz );
+        RCFS_SetCompression( 0 );
+
+        // whole file and a piece from the middle
+        BenchClear( &rd );
+        BenchStart();
+        n = RCFS_ReadFile( "lz", copy, 0, BENCH_LZ_SIZE );
+        BenchStop( &rd );
+        if( n != BENCH_LZ_SIZE || memcmp( copy, buf, n ) != 0 )
+            BenchFail("RCFS_ReadFile compressed");
+        if( RCFS_ReadFile( "lz", copy, 5000, 4000 ) != BENCH_LZ_SIZE - 5000 || memcmp( copy, buf + 5000, BENCH_LZ_SIZE - 5000 ) != 0 )
+            BenchFail("RCFS_ReadFile offset");
+        if( RCFS_ReadFile( "plain", copy, 100, 50 ) != 50 || memcmp( copy, buf + 100, 50 ) != 0 )
+            BenchFail("RCFS_ReadFile plain");
+
+        RCFS_GetFile( "plain", &data, &plainlength );
+        RCFS_GetFile( "lz", &data, &datalength );
+        printf("%8s %10d %10.1f %10.1f %10" PRIu64 " %10" PRIu64 " %10.1f\n", kinds[k], datalength,
+            BenchMean( &plain ), BenchMean( &lz ), plain.programs, lz.programs, BenchMean( &rd ) );
+        }
+
+    // streamed in odd sized pieces, then a file that was never closed
+    BenchLzData( buf, BENCH_LZ_SIZE, 0 );
+    RCFS_SetCompression( 1 );
+    if( (h = RCFS_OpenWrite( "lzs" )) < 0 )
+        BenchFail("RCFS_OpenWrite compressed");
+    for(i=0;i<BENCH_LZ_SIZE;i+=n)
+        {
+        n = (BENCH_LZ_SIZE - i < 37) ? BENCH_LZ_SIZE - i : 37;
+        if( RCFS_Append( h, buf + i, n ) != RCFS_SUCCESS )
+            BenchFail("RCFS_Append compressed");
+        }
+    if( RCFS_Close( h ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Close compressed");
+    if( RCFS_ReadFile( "lzs", copy, 0, BENCH_LZ_SIZE ) != BENCH_LZ_SIZE || memcmp( copy, buf, BENCH_LZ_SIZE ) != 0 )
+        BenchFail("RCFS_ReadFile streamed");
+
+    if( (h = RCFS_OpenWrite( "lzu" )) < 0 ||
+        RCFS_Append( h, buf, BENCH_LZ_SIZE ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Append compressed");
+    memset( &write_stream, 0, sizeof(write_stream) );
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+    RCFS_SetCompression( 0 );
+
+    n = RCFS_ReadFile( "lzu", copy, 0, BENCH_LZ_SIZE );
+    if( n < BENCH_LZ_SIZE - 512 || memcmp( copy, buf, n ) != 0 )
+        BenchFail("RCFS_ReadFile not closed");
+    printf("file not closed, %d of %d bytes recovered\n", n, BENCH_LZ_SIZE );
+}
+#endif
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_GetFile and directory access across file counts                       */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchGetFile()
+{
+    static int counts[] = { 1, 8, 16, 31 };
+    unsigned char   buf[64];
+    unsigned char  *data;
+    int             datalength;
+    char            name[16];
+    char            last[16];
+    bench_result    cold, first, lastf, miss, lastname, walk;
+    flash_file      f;
+    int             i, n, k;
+
+    printf("\nRCFS_GetFile and directory, 64 byte files, uS (flash reads)\n");
+    printf("%6s %16s %16s %16s %16s %16s %16s\n", "files", "cold", "first", "last", "missing", "lastname", "walk");
+
+    for(i=0;i<(int)(sizeof(counts)/sizeof(int));i++)
+        {
+        BenchFormat();
+        BenchFill( buf, sizeof(buf), i );
+
+        for(n=0;n<counts[i];n++)
+            {
+            sprintf( name, "f%03d", n );
+            if( RCFS_AddFile( buf, sizeof(buf), name ) != RCFS_SUCCESS )
+                BenchFail("RCFS_AddFile");
+            }
+
+        BenchClear( &cold );
+        BenchClear( &first );
+        BenchClear( &lastf );
+        BenchClear( &miss );
+        BenchClear( &lastname );
+        BenchClear( &walk );
+
+        sprintf( name, "f%03d", counts[i] - 1 );
+
+        // the first access after a reset
+#ifdef RCFS_VTOC_CACHE
+        RCFS_CacheInvalidate();
+#endif
+        BenchStart();
+        if( RCFS_GetFile( name, &data, &datalength ) != RCFS_SUCCESS )
+            BenchFail("RCFS_GetFile cold");
+        BenchStop( &cold );
+
+        for(k=0;k<8;k++)
+            {
+            BenchStart();
+            if( RCFS_GetFile( "f000", &data, &datalength ) != RCFS_SUCCESS )
+                BenchFail("RCFS_GetFile first");
+            BenchStop( &first );
+
+            BenchStart();
+            if( RCFS_GetFile( name, &data, &datalength ) != RCFS_SUCCESS || datalength != sizeof(buf) )
+                BenchFail("RCFS_GetFile last");
+            BenchStop( &lastf );
+
+            BenchStart();
+            if( RCFS_GetFile( "nofile", &data, &datalength ) != RCFS_ERROR )
+                BenchFail("RCFS_GetFile missing");
+            BenchStop( &miss );
+
+            BenchStart();
+            if( RCFS_GetLastFilename( last, 16 ) != RCFS_SUCCESS || strcmp( last, name ) != 0 )
+                BenchFail("RCFS_GetLastFilename");
+            BenchStop( &lastname );
+
+            BenchStart();
+            n = 0;
+            if( RCFS_FindFirstFile( &f ) >= 0 )
+                {
+                do {
+                    n++;
+                    } while( RCFS_FindNextFile( &f ) >= 0 );
+                }
+            BenchStop( &walk );
+            if( n != counts[i] + 1 )
+                BenchFail("directory walk");
+            }
+
+        printf("%6d %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ")\n", counts[i],
+            BenchMean( &cold ),     (cold.reads / cold.calls),
+            BenchMean( &first ),    (first.reads / first.calls),
+            BenchMean( &lastf ),    (lastf.reads / lastf.calls),
+            BenchMean( &miss ),     (miss.reads / miss.calls),
+            BenchMean( &lastname ), (lastname.reads / lastname.calls),
+            BenchMean( &walk ),     (walk.reads / walk.calls) );
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_Read and RCFS_Map by handle                                           */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchRead()
+{
+    static unsigned char buf[4096];
+    unsigned char   copy[64];
+    unsigned char  *data, *ptr;
+    int             datalength, length;
+    bench_result    open, rd, map;
+    char            name[16];
+    int             h, i, n;
+
+    printf("\nRCFS_OpenRead, RCFS_Read and RCFS_Map, 16 files of 4096 bytes, uS (flash reads)\n");
+
+    BenchFormat();
+    for(i=0;i<16;i++)
+        {
+        BenchFill( buf, sizeof(buf), i );
+        sprintf( name, "r%03d", i );
+        if( RCFS_AddFile( buf, sizeof(buf), name ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile");
+        }
+
+    BenchClear( &open );
+    BenchClear( &rd );
+    BenchClear( &map );
+
+    BenchStart();
+    h = RCFS_OpenRead( "r015" );
+    BenchStop( &open );
+    if( h < 0 || RCFS_GetFile( "r015", &data, &datalength ) != RCFS_SUCCESS )
+        BenchFail("RCFS_OpenRead");
+
+    // 64 byte reads through the file
+    for(i=0;i<(int)sizeof(buf);i+=sizeof(copy))
+        {
+        BenchStart();
+        n = RCFS_Read( h, i, copy, sizeof(copy) );
+        BenchStop( &rd );
+        if( n != (int)sizeof(copy) || memcmp( copy, buf + i, n ) != 0 )
+            BenchFail("RCFS_Read");
+
+        BenchStart();
+        if( RCFS_Map( h, i, &ptr, &length ) != RCFS_SUCCESS )
+            BenchFail("RCFS_Map");
+        BenchStop( &map );
+        if( ptr != data + i || length != (int)sizeof(buf) - i )
+            BenchFail("RCFS_Map span");
+        }
+
+    // bounds
+    if( RCFS_Read( h, sizeof(buf) - 10, copy, sizeof(copy) ) != 10 ||
+        RCFS_Read( h, sizeof(buf) + 10, copy, sizeof(copy) ) != 0 ||
+        RCFS_Read( h, -1, copy, sizeof(copy) ) != RCFS_ERROR ||
+        RCFS_Map( h, sizeof(buf) + 1, &ptr, &length ) != RCFS_ERROR ||
+        RCFS_Read( 40, 0, copy, sizeof(copy) ) != RCFS_ERROR )
+        BenchFail("RCFS_Read bounds");
+
+    // deleted files have no handle
+    h = RCFS_OpenRead( "r003" );
+    RCFS_DeleteFile( "r003" );
+    if( RCFS_Read( h, 0, copy, sizeof(copy) ) != RCFS_ERROR || RCFS_OpenRead( "r003" ) != RCFS_ERROR )
+        BenchFail("RCFS_Read deleted");
+
+#ifdef RCFS_COMPRESS
+    // compressed files can be read but not mapped
+    RCFS_SetCompression( 1 );
+    RCFS_AddFile( buf, sizeof(buf), "rlz" );
+    RCFS_SetCompression( 0 );
+    h = RCFS_OpenRead( "rlz" );
+    if( RCFS_Read( h, 1000, copy, sizeof(copy) ) != (int)sizeof(copy) || memcmp( copy, buf + 1000, sizeof(copy) ) != 0 ||
+        RCFS_Map( h, 0, &ptr, &length ) != RCFS_ERROR )
+        BenchFail("RCFS_Read compressed");
+#endif
+
+    printf("%16s %16s %16s\n", "open", "read 64", "map");
+    printf("%7.1f (%6" PRIu64 ") %7.1f (%6" PRIu64 ") %7.1f (%6" PRIu64 ")\n",
+        BenchMean( &open ), open.reads / open.calls,
+        BenchMean( &rd ),   rd.reads / rd.calls,
+        BenchMean( &map ),  map.reads / map.calls );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_OpenWrite, RCFS_Append and RCFS_Close                                 */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchStream()
+{
+    static int      sizes[] = { 8, 16, 64 };
+    static unsigned char buf[0x4000];
+    bench_result    app, cls;
+    unsigned char  *data;
+    int             datalength;
+    int             total, expect;
+    int             i, n, h;
+
+    printf("\nRCFS_Append, 16K streamed file, %d byte ring buffer\n", RCFS_STREAM_BUFFER_SIZE );
+    printf("%8s %10s %10s %10s %10s\n", "bytes", "mean uS", "max uS", "KB/s", "close uS");
+
+    for(i=0;i<(int)(sizeof(sizes)/sizeof(int));i++)
+        {
+        BenchFormat();
+        BenchFill( buf, sizeof(buf), i );
+        BenchClear( &app );
+        BenchClear( &cls );
+
+        if( (h = RCFS_OpenWrite( "stream" )) < 0 )
+            BenchFail("RCFS_OpenWrite");
+
+        // one byte short so the last half word is padded
+        total = sizeof(buf) - 1;
+        for(n=0;n<total;n+=sizes[i])
+            {
+            BenchStart();
+            if( RCFS_Append( h, buf + n, (total - n) < sizes[i] ? (total - n) : sizes[i] ) != RCFS_SUCCESS )
+                BenchFail("RCFS_Append");
+            BenchStop( &app );
+            }
+
+        BenchStart();
+        if( RCFS_Close( h ) != RCFS_SUCCESS )
+            BenchFail("RCFS_Close");
+        BenchStop( &cls );
+
+        if( RCFS_GetFile( "stream", &data, &datalength ) != RCFS_SUCCESS ||
+            datalength != total || memcmp( data, buf, total ) != 0 )
+            BenchFail("streamed file contents");
+
+        // a file can be added after the stream
+        if( RCFS_AddFile( buf, 64, "after" ) != RCFS_SUCCESS ||
+            RCFS_GetFile( "after", &data, &datalength ) != RCFS_SUCCESS || memcmp( data, buf, 64 ) != 0 )
+            BenchFail("RCFS_AddFile after stream");
+
+        printf("%8d %10.1f %10.1f %10.1f %10.1f\n", sizes[i], BenchMean( &app ), app.t_max / 1000.0,
+            (total / 1024.0) / (app.t_total / 1e9), BenchMean( &cls ) );
+        }
+
+    // stop without closing the file, then recover it
+    BenchFormat();
+    BenchFill( buf, 1000, 7 );
+    h = RCFS_OpenWrite( "crash" );
+    if( RCFS_AddFile( buf, 64, "blocked" ) != RCFS_ERROR )
+        BenchFail("RCFS_AddFile while stream open");
+    RCFS_Append( h, buf, 1000 );
+    RCFS_Flush( h );
+
+    memset( &write_stream, 0, sizeof(write_stream) );
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+
+    for(expect=1000;expect>0 && buf[expect-1] == 0xFF;expect--)
+        ;
+    if( RCFS_GetFile( "crash", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != expect || memcmp( data, buf, expect ) != 0 )
+        BenchFail("stream recovery");
+    if( RCFS_AddFile( buf, 64, "after" ) != RCFS_SUCCESS ||
+        RCFS_GetFile( "after", &data, &datalength ) != RCFS_SUCCESS || memcmp( data, buf, 64 ) != 0 )
+        BenchFail("RCFS_AddFile after recovery");
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_Verify and RCFS_VerifyAll, torn and damaged files                     */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchVerify()
+{
+    static unsigned char buf[2048];
+    bench_result    one, quick, full;
+    unsigned char  *data;
+    int             datalength;
+    unsigned char   b;
+    char            name[16];
+    int             i, h;
+
+    printf("\nRCFS_Verify and RCFS_VerifyAll, 16 files of 2048 bytes, uS (flash reads)\n");
+
+    BenchFormat();
+    for(i=0;i<16;i++)
+        {
+        BenchFill( buf, sizeof(buf), i );
+        sprintf( name, "v%03d", i );
+        if( RCFS_AddFile( buf, sizeof(buf), name ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile");
+        }
+
+    // streamed, odd length
+    h = RCFS_OpenWrite( "vstream" );
+    RCFS_Append( h, buf, 1001 );
+    RCFS_Close( h );
+    if( RCFS_Verify( "vstream" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Verify streamed");
+
+#ifdef RCFS_COMPRESS
+    RCFS_SetCompression( 1 );
+    RCFS_AddFile( buf, sizeof(buf), "vlz" );
+    RCFS_SetCompression( 0 );
+    if( RCFS_Verify( "vlz" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Verify compressed");
+#endif
+
+    BenchClear( &one );
+    BenchClear( &quick );
+    BenchClear( &full );
+
+    BenchStart();
+    i = RCFS_Verify( "v007" );
+    BenchStop( &one );
+    if( i != RCFS_SUCCESS || RCFS_Verify( "none" ) != RCFS_ERROR )
+        BenchFail("RCFS_Verify");
+
+    BenchStart();
+    i = RCFS_VerifyAll( 0 );
+    BenchStop( &quick );
+    if( i != 0 )
+        BenchFail("RCFS_VerifyAll quick");
+
+    BenchStart();
+    i = RCFS_VerifyAll( 1 );
+    BenchStop( &full );
+    if( i != 0 )
+        BenchFail("RCFS_VerifyAll full");
+
+    // a bit cleared in the middle of an older file is only found by a full check
+    RCFS_GetFile( "v003", &data, &datalength );
+    flash_sim_peek( (uint32_t)(uintptr_t)(data + 100), &b, 1 );
+    b &= 0xFE;
+    flash_sim_poke( (uint32_t)(uintptr_t)(data + 100), &b, 1 );
+    if( RCFS_Verify( "v003" ) != RCFS_CRC_ERROR || RCFS_VerifyAll( 0 ) != 0 || RCFS_VerifyAll( 1 ) != 1 )
+        BenchFail("RCFS_Verify damaged file");
+
+    // a streamed file that was never closed has no CRC
+    BenchFormat();
+    h = RCFS_OpenWrite( "open" );
+    RCFS_Append( h, buf, 500 );
+    RCFS_Flush( h );
+    memset( &write_stream, 0, sizeof(write_stream) );
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+    if( RCFS_Verify( "open" ) != RCFS_CRC_NONE || RCFS_VerifyAll( 1 ) != 0 )
+        BenchFail("RCFS_Verify unclosed stream");
+
+    printf("%16s %16s %16s\n", "one file", "all, quick", "all, full");
+    printf("%7.1f (%6" PRIu64 ") %7.1f (%6" PRIu64 ") %7.1f (%6" PRIu64 ")\n",
+        BenchMean( &one ),   one.reads / one.calls,
+        BenchMean( &quick ), quick.reads / quick.calls,
+        BenchMean( &full ),  full.reads / full.calls );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_SetVerify, FLASH_VerifyBuffer and a program error in RCFS_AddFile     */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchWriteError()
+{
+    static uint32_t     words[1024];
+    unsigned char      *buf = (unsigned char *)words;
+    unsigned char      *p;
+    bench_result        r;
+    rcfs_stat           st, st0;
+    flash_file          f;
+    unsigned long       failaddr;
+    uint32_t            addr, vfail;
+    uint16_t            zero = 0;
+    int                 i, j, k;
+
+    printf("\nRCFS_AddFile of 4096 bytes with RCFS_SetVerify, uS (flash reads)\n");
+    printf("%18s %18s\n", "no verify", "verify");
+
+    BenchFormat();
+    BenchFill( buf, sizeof(words), 5 );
+
+    for(i=0;i<2;i++)
+        {
+        RCFS_SetVerify( i );
+        BenchClear( &r );
+        BenchStart();
+        if( RCFS_AddFile( buf, sizeof(words), i ? (char *)"v1" : (char *)"v0" ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile verify");
+        BenchStop( &r );
+        printf("%10.1f (%5" PRIu64 ")", BenchMean( &r ), r.reads );
+        }
+    printf("\n");
+
+    // word, half word and byte aligned compares, and a byte loop in user code
+    printf("\nFLASH_VerifyBuffer of 4000 bytes, uS (flash reads)\n");
+    printf("%18s %18s %18s %18s\n", "word", "half word", "byte", "user code");
+
+    RCFS_FindFile( "v1", &f );
+    addr = f.addr + FLASH_FILE_HEADER_SIZE;
+    for(i=0;i<4;i++)
+        {
+        k = (i == 0) ? 0 : ((i == 1) ? 2 : 1);
+
+        BenchClear( &r );
+        BenchStart();
+        if( i < 3 )
+            {
+            if( FLASH_VerifyBuffer( addr + k, buf + k, 4000, NULL ) != FLASH_COMPLETE )
+                BenchFail("FLASH_VerifyBuffer");
+            }
+        else
+            {
+            p = (unsigned char *)addr;
+            for(j=0;j<4000;j++)
+                if( p[j] != buf[j] )
+                    break;
+            }
+        BenchStop( &r );
+        printf("%10.1f (%5" PRIu64 ")", BenchMean( &r ), r.reads );
+
+        // a difference is found at the right byte
+        if( i < 3 )
+            {
+            buf[k + 1001] ^= 0x10;
+            vfail = 0;
+            if( FLASH_VerifyBuffer( addr + k, buf + k, 4000, &vfail ) != FLASH_ERROR_PG || vfail != addr + k + 1001 )
+                BenchFail("FLASH_VerifyBuffer difference");
+            buf[k + 1001] ^= 0x10;
+            }
+        }
+    printf("\n");
+
+    // a half word in the way of the next file fails to program
+    RCFS_Stat( &st0 );
+    addr = kStartOfFileSystem + RCFS_DATA_OFFSET + st0.used + FLASH_FILE_HEADER_SIZE + 200;
+    flash_sim_poke( addr, &zero, 2 );
+
+    RCFS_GetWriteError( NULL );
+    if( RCFS_AddFile( buf, sizeof(words), "bad" ) != RCFS_ERROR )
+        BenchFail("RCFS_AddFile program error");
+    i = RCFS_GetWriteError( &failaddr );
+    RCFS_Stat( &st );
+    printf("program error %d at 0x%08lX, %ld bytes skipped\n", i, (unsigned long)failaddr, st.deleted - st0.deleted );
+
+    if( i != FLASH_ERROR_PG || failaddr != addr || RCFS_FindFile( "bad", &f ) >= 0 ||
+        st.deleted - st0.deleted != 200 + FLASH_FILE_HEADER_SIZE + 2 || RCFS_GetWriteError( NULL ) != FLASH_COMPLETE )
+        BenchFail("RCFS_AddFile program error");
+
+    // the next file goes after the bad one and verifies
+    if( RCFS_AddFile( buf, sizeof(words), "good" ) != RCFS_SUCCESS || RCFS_Verify( "good" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_AddFile after error");
+
+    // streamed files are verified as they are drained
+    i = RCFS_OpenWrite( "stream" );
+    if( (RCFS_Append( i, buf, 3001 ) != RCFS_SUCCESS) || (RCFS_Close( i ) != RCFS_SUCCESS) ||
+        (RCFS_Verify( "stream" ) != RCFS_SUCCESS) )
+        BenchFail("RCFS_Append verify");
+
+    // a close that cannot be programmed leaves the file open until abandoned
+    i = RCFS_OpenWrite( "unclosed" );
+    RCFS_Append( i, buf, 1000 );
+    RCFS_Flush( i );
+    flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem + RCFS_PAGE_SIZE );
+    j = RCFS_Close( i );
+    flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem );
+    if( j != RCFS_ERROR || RCFS_GetWriteError( NULL ) != FLASH_ERROR_WRP || RCFS_Abandon( i ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Close program error");
+
+    // the cache agrees with the flash
+    RCFS_Stat( &st );
+#ifdef RCFS_VTOC_CACHE
+    RCFS_CacheInvalidate();
+#endif
+    RCFS_Stat( &st0 );
+    if( st.used != st0.used || st.files != st0.files || st.free != st0.free ||
+        RCFS_AddFile( buf, 100, "next" ) != RCFS_SUCCESS || RCFS_Verify( "next" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Abandon");
+
+    // a delete that cannot be programmed leaves the file in place
+    RCFS_Stat( &st0 );
+    RCFS_FindFile( "good", &f );
+    flash_sim_protect( SIM_FLASH_BASE, f.addr + 2 );
+    i = RCFS_DeleteFile( "good" );
+    flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem );
+    RCFS_Stat( &st );
+    if( i != RCFS_ERROR || RCFS_GetWriteError( NULL ) != FLASH_ERROR_WRP ||
+        RCFS_Verify( "good" ) != RCFS_SUCCESS || st.deleted != st0.deleted )
+        BenchFail("RCFS_DeleteFile program error");
+
+    if( RCFS_DeleteFile( "good" ) != RCFS_SUCCESS || RCFS_FindFile( "good", &f ) >= 0 )
+        BenchFail("RCFS_DeleteFile");
+
+    RCFS_SetVerify( 0 );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Power loss while RCFS_AddFile is writing, then recovery                    */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchCommit()
+{
+    static unsigned char buf[1000];
+    unsigned char  *data;
+    int             datalength;
+    bench_result    rec;
+    int             ops, k;
+    int             added = 0, removed = 0, bad = 0;
+
+    BenchFormat();
+    BenchFill( buf, sizeof(buf), 5 );
+    RCFS_AddFile( buf, 64, "first" );
+    flash_sim_clear_stats();
+    RCFS_AddFile( buf, sizeof(buf), "new" );
+    ops = (int)flash_sim_get_stats()->programs;
+
+    printf("\nRCFS_AddFile of %d bytes, power lost after each of %d half words\n", (int)sizeof(buf), ops );
+
+    BenchClear( &rec );
+
+    // every half word of the header and VTOC entry, some of the data
+    for(k=0;k<ops;k++)
+        {
+        if( (k >= 16) && (k < ops - 16) && (k % 23) != 0 )
+            continue;
+
+        BenchFormat();
+        RCFS_AddFile( buf, 64, "first" );
+
+        flash_sim_power_fail( k );
+        RCFS_AddFile( buf, sizeof(buf), "new" );
+        BenchReboot();
+
+        // first use of the file system finishes or removes the file, the
+        // VTOC cache can be built before anything else
+        BenchStart();
+#ifdef RCFS_VTOC_CACHE
+        if( k & 1 )
+            RCFS_CacheInit();
+#endif
+        RCFS_GetFile( "first", &data, &datalength );
+        BenchStop( &rec );
+
+        if( RCFS_GetFile( "new", &data, &datalength ) == RCFS_SUCCESS )
+            {
+            if( datalength != (int)sizeof(buf) || memcmp( data, buf, sizeof(buf) ) != 0 ||
+                RCFS_Verify( "new" ) != RCFS_SUCCESS )
+                bad++;
+            added++;
+            }
+        else
+            removed++;
+
+        if( RCFS_Verify( "first" ) != RCFS_SUCCESS || RCFS_VerifyAll( 1 ) != 0 || RCFS_Recover() != 0 ||
+            RCFS_AddFile( buf, 100, "after" ) != RCFS_SUCCESS ||
+            RCFS_GetFile( "after", &data, &datalength ) != RCFS_SUCCESS || datalength != 100 )
+            bad++;
+        }
+
+    // a streamed file, power lost while the header and VTOC entry are written
+    for(k=0;k<24;k++)
+        {
+        rcfs_dir    d;
+        flash_file  f;
+        int         h;
+
+        BenchFormat();
+        RCFS_AddFile( buf, 64, "first" );
+
+        flash_sim_power_fail( k );
+        if( (h = RCFS_OpenWrite( "stream" )) >= 0 )
+            {
+            RCFS_Append( h, buf, 100 );
+            RCFS_Close( h );
+            }
+        BenchReboot();
+
+#ifdef RCFS_VTOC_CACHE
+        if( k & 1 )
+            RCFS_CacheInit();
+#endif
+        RCFS_DirOpen( &d );
+        while( RCFS_DirNext( &d, &f ) >= 0 )
+            {
+            if( strcmp( (char *)f.name, "program" ) != 0 && strcmp( (char *)f.name, "first" ) != 0 &&
+                strcmp( (char *)f.name, "stream" ) != 0 )
+                bad++;
+            }
+        RCFS_DirClose( &d );
+
+        if( RCFS_Verify( "first" ) != RCFS_SUCCESS || RCFS_VerifyAll( 1 ) != 0 ||
+            RCFS_AddFile( buf, 100, "after" ) != RCFS_SUCCESS ||
+            RCFS_GetFile( "after", &data, &datalength ) != RCFS_SUCCESS || datalength != 100 )
+            bad++;
+        }
+
+    // a file left open is only closed by recovery, reading the file
+    // system does not program the flash
+    BenchFormat();
+    if( (k = RCFS_OpenWrite( "stream" )) >= 0 )
+        {
+        rcfs_dir    d;
+        flash_file  f;
+        rcfs_stat   st;
+
+        RCFS_Append( k, buf, 100 );
+        RCFS_Flush( k );
+        BenchReboot();
+        flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem + RCFS_PAGE_SIZE );
+        RCFS_Stat( &st );
+        if( RCFS_GetWriteError( NULL ) == FLASH_COMPLETE )
+            bad++;
+        flash_sim_clear_stats();
+        RCFS_Stat( &st );
+        RCFS_DirOpen( &d );
+        while( RCFS_DirNext( &d, &f ) >= 0 )
+            ;
+        RCFS_DirClose( &d );
+        if( flash_sim_get_stats()->programs != 0 || flash_sim_get_stats()->wrp_errors != 0 ||
+            st.files != 2 )
+            bad++;
+        flash_sim_protect( SIM_FLASH_BASE, kStartOfFileSystem );
+        BenchReboot();
+        if( RCFS_GetFile( "stream", &data, &datalength ) != RCFS_SUCCESS || datalength != 100 )
+            bad++;
+        }
+    else
+        bad++;
+
+#ifdef RCFS_COMPRESS
+    // a compressed file is streamed, it is deleted if not closed
+    BenchFormat();
+    RCFS_SetCompression( 1 );
+    flash_sim_power_fail( 200 );
+    RCFS_AddFile( buf, sizeof(buf), "new" );
+    RCFS_SetCompression( 0 );
+    BenchReboot();
+    if( RCFS_GetFile( "new", &data, &datalength ) != RCFS_ERROR ||
+        RCFS_AddFile( buf, 100, "after" ) != RCFS_SUCCESS )
+        bad++;
+#endif
+
+    if( bad )
+        BenchFail("RCFS_AddFile power loss");
+
+    printf("%10s %10s %10s %16s\n", "added", "removed", "damaged", "recovery uS");
+    printf("%10d %10d %10d %7.1f (%6" PRIu64 ")\n", added, removed, bad, BenchMean( &rec ), rec.reads / rec.calls );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_GetInfo, file system layouts of different ROBOTC versions             */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchLayout()
+{
+    static unsigned char buf[1000];
+    static unsigned char junk[0x200];
+    unsigned char   copy[100];
+    unsigned char  *data;
+    int             datalength;
+    rcfs_info       info;
+    bench_result    get;
+    int             i, r;
+
+    printf("\nRCFS_GetInfo, layout found for each format\n");
+    printf("%10s %8s %8s %8s %8s %16s\n", "format", "status", "vtoc", "header", "files", "first use reads");
+
+    BenchFill( buf, sizeof(buf), 9 );
+
+    for(i=0;i<4;i++)
+        {
+        if( i == 0 )
+            BenchFormatLayout( 160, 24, 1 );
+        if( i == 1 )
+            BenchFormatLayout( 28, 22, 1 );
+        if( i == 2 )
+            BenchFormatLayout( 24, 22, 0 );
+        if( i == 3 )
+            {
+            // a header and VTOC that do not match any layout
+            BenchFormat();
+            BenchFill( junk, sizeof(junk), 1 );
+            flash_sim_poke( kStartOfFileSystem, junk, sizeof(junk) );
+            rcfs_layout.valid = 0;
+#ifdef RCFS_VTOC_CACHE
+            RCFS_CacheInvalidate();
+#endif
+            }
+        boot_checked = 0;
+
+        BenchClear( &get );
+        BenchStart();
+        r = RCFS_GetFile( "none", &data, &datalength );
+        BenchStop( &get );
+
+        RCFS_GetInfo( &info );
+        printf("%10s %8d %8d %8d %8d %16" PRIu64 "\n", i == 0 ? "V4.26" : i == 1 ? "V3.60" : i == 2 ? "empty" : "garbage",
+            info.status, info.vtoc_offset, info.header_size, info.files, get.reads );
+
+        if( i < 3 )
+            {
+#ifdef RCFS_COMPRESS
+            // no room for the size of a compressed file in a V3 header
+            RCFS_SetCompression( i == 1 );
+#endif
+            if( info.status != RCFS_SUCCESS || r != RCFS_ERROR ||
+                RCFS_AddFile( buf, sizeof(buf), "layout" ) != RCFS_SUCCESS ||
+                RCFS_GetFile( "layout", &data, &datalength ) != RCFS_SUCCESS ||
+                datalength != (int)sizeof(buf) || memcmp( data, buf, sizeof(buf) ) != 0 ||
+                RCFS_ReadFile( "layout", copy, 500, sizeof(copy) ) != (int)sizeof(copy) ||
+                memcmp( copy, buf + 500, sizeof(copy) ) != 0 ||
+                RCFS_Verify( "layout" ) != RCFS_SUCCESS )
+                BenchFail("RCFS layout");
+#ifdef RCFS_COMPRESS
+            RCFS_SetCompression( 0 );
+#endif
+            RCFS_GetInfo( &info );
+            // an empty VTOC gives the build layout
+            if( info.files != ((i == 2) ? 1 : 2) || info.detected != (i != 2) )
+                BenchFail("RCFS_GetInfo files");
+            }
+        else
+            {
+            if( info.status != RCFS_ERROR || r != RCFS_ERROR ||
+                RCFS_AddFile( buf, sizeof(buf), "layout" ) != RCFS_ERROR || get.reads > 100 )
+                BenchFail("RCFS layout not found");
+            }
+        }
+
+    BenchFormat();
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_Stat as files are added, deleted and streamed                         */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchStat()
+{
+    static unsigned char buf[1000];
+    static unsigned char big[MAX_FLASH_FILE_SIZE];
+    static unsigned char after[RCFS_PAGE_SIZE], copy[RCFS_PAGE_SIZE];
+    rcfs_stat       st;
+    bench_result    stat;
+    long            total = RCFS_DATA_END - RCFS_DATA_OFFSET;
+    char            name[16];
+    int             i, h;
+
+    printf("\nRCFS_Stat, 8 files of %d bytes, one deleted, one streamed\n", (int)sizeof(buf) );
+    printf("%8s %8s %8s %8s %8s %8s %16s\n", "used", "deleted", "free", "largest", "files", "slots", "uS (flash reads)");
+
+    BenchFormat();
+    BenchFill( buf, sizeof(buf), 2 );
+
+    if( RCFS_Stat( &st ) != RCFS_SUCCESS || st.used != 0 || st.free != total || st.files != 1 ||
+        st.slots != kMaxNumbofFlashFiles - 1 || st.deleted != 0 ||
+        st.largest != ((total - FLASH_FILE_HEADER_SIZE) > RCFS_STREAM_MAX_SIZE ? RCFS_STREAM_MAX_SIZE : total - FLASH_FILE_HEADER_SIZE) )
+        BenchFail("RCFS_Stat empty");
+
+    for(i=0;i<8;i++)
+        {
+        sprintf( name, "s%03d", i );
+        RCFS_AddFile( buf, sizeof(buf), name );
+        }
+    RCFS_DeleteFile( "s003" );
+
+    BenchClear( &stat );
+    BenchStart();
+    RCFS_Stat( &st );
+    BenchStop( &stat );
+
+    if( st.used != 8 * (FLASH_FILE_HEADER_SIZE + (long)sizeof(buf)) || st.deleted != FLASH_FILE_HEADER_SIZE + (long)sizeof(buf) ||
+        st.used + st.free != total || st.files != 9 || st.slots != kMaxNumbofFlashFiles - 9 )
+        BenchFail("RCFS_Stat files");
+
+    printf("%8ld %8ld %8ld %8ld %8d %8d %7.1f (%6" PRIu64 ")\n", st.used, st.deleted, st.free, st.largest,
+        st.files, st.slots, BenchMean( &stat ), stat.reads );
+
+    // a streamed file owns the free space
+    h = RCFS_OpenWrite( "s008" );
+    RCFS_Append( h, buf, 501 );
+    RCFS_Stat( &st );
+    if( st.used != 9 * (long)FLASH_FILE_HEADER_SIZE + 8 * (long)sizeof(buf) + 502 || st.files != 10 ||
+        st.largest != write_stream.maxlength - 501 )
+        BenchFail("RCFS_Stat stream");
+    RCFS_Close( h );
+    RCFS_Stat( &st );
+    if( st.used != 9 * (long)FLASH_FILE_HEADER_SIZE + 8 * (long)sizeof(buf) + 502 || st.used + st.free != total )
+        BenchFail("RCFS_Stat closed stream");
+
+#ifdef RCFS_COMPACT
+    // s004 to s008 move and take new VTOC entries
+    RCFS_Compact();
+    RCFS_Stat( &st );
+    if( st.deleted != 0 || st.files != 15 || st.used != 8 * (long)FLASH_FILE_HEADER_SIZE + 7 * (long)sizeof(buf) + 502 )
+        BenchFail("RCFS_Stat after compact");
+#endif
+
+    // fill to the end of the file area, the header counts against the space
+    BenchFormat();
+    flash_sim_peek( kStartOfFileSystem + RCFS_DATA_END, after, sizeof(after) );
+    for(i=0;;i++)
+        {
+        RCFS_Stat( &st );
+        if( st.free - FLASH_FILE_HEADER_SIZE <= MAX_FLASH_FILE_SIZE )
+            break;
+        sprintf( name, "f%03d", i );
+        if( RCFS_AddFile( big, MAX_FLASH_FILE_SIZE, name ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile fill");
+        }
+    h = (int)(st.free - FLASH_FILE_HEADER_SIZE);
+    if( RCFS_AddFile( big, h + 2, "last" ) != RCFS_ERROR ||
+        RCFS_AddFile( big, h, "last" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_AddFile to the end");
+    RCFS_Stat( &st );
+    flash_sim_peek( kStartOfFileSystem + RCFS_DATA_END, copy, sizeof(copy) );
+    if( st.free != 0 || memcmp( after, copy, sizeof(after) ) != 0 ||
+        RCFS_AddFile( big, 2, "over" ) != RCFS_ERROR || RCFS_VerifyAll( 1 ) != 0 )
+        BenchFail("RCFS_Stat full");
+
+#ifdef RCFS_COMPACT
+    sprintf( name, "f%03d", i - 1 );
+    RCFS_DeleteFile( name );
+    if( RCFS_Compact() != RCFS_SUCCESS || RCFS_VerifyAll( 1 ) != 0 ||
+        RCFS_Verify( "last" ) != RCFS_SUCCESS || RCFS_Stat( &st ) != RCFS_SUCCESS ||
+        st.free != FLASH_FILE_HEADER_SIZE + MAX_FLASH_FILE_SIZE )
+        BenchFail("RCFS_Compact full");
+    flash_sim_peek( kStartOfFileSystem + RCFS_DATA_END, copy, sizeof(copy) );
+    if( memcmp( after, copy, sizeof(after) ) != 0 )
+        BenchFail("RCFS_Compact past the end");
+#endif
+}
+
+#ifdef RCFS_COMPACT
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_DeleteFile and RCFS_Compact, then power loss during compaction        */
+/*-----------------------------------------------------------------------------*/
+
+static int  bench_compact_sizes[] = { 300, 1001, 64, 1500, 777, 1024, 1201, 100 };
+static int  bench_compact_deleted[] = { 0, 1, 0, 1, 0, 0, 1, 0 };
+
+#define BENCH_COMPACT_FILES     (int)(sizeof(bench_compact_sizes)/sizeof(int))
+
+static void
+BenchCompactSetup()
+{
+    static unsigned char buf[MAX_FLASH_FILE_SIZE];
+    char            name[16];
+    int             i;
+
+    BenchFormat();
+
+    for(i=0;i<BENCH_COMPACT_FILES;i++)
+        {
+        BenchFill( buf, bench_compact_sizes[i], i + 10 );
+        sprintf( name, "c%d", i );
+        if( RCFS_AddFile( buf, bench_compact_sizes[i], name ) != RCFS_SUCCESS )
+            BenchFail("RCFS_AddFile");
+        }
+
+    for(i=0;i<BENCH_COMPACT_FILES;i++)
+        {
+        sprintf( name, "c%d", i );
+        if( bench_compact_deleted[i] && RCFS_DeleteFile( name ) != RCFS_SUCCESS )
+            BenchFail("RCFS_DeleteFile");
+        }
+}
+
+// Returns the number of files that are wrong
+static int
+BenchCompactCheck()
+{
+    static unsigned char buf[MAX_FLASH_FILE_SIZE];
+    static unsigned char copy[MAX_FLASH_FILE_SIZE];
+    unsigned char  *data;
+    int             datalength;
+    char            name[16];
+    flash_file      f;
+    int             i, n, live, bad = 0;
+
+    for(i=0,live=0;i<BENCH_COMPACT_FILES;i++)
+        {
+        sprintf( name, "c%d", i );
+        BenchFill( buf, bench_compact_sizes[i], i + 10 );
+
+        if( bench_compact_deleted[i] )
+            {
+            if( RCFS_GetFile( name, &data, &datalength ) != RCFS_ERROR )
+                bad++;
+            }
+        else
+            {
+            live++;
+            if( RCFS_GetFile( name, &data, &datalength ) != RCFS_SUCCESS ||
+                datalength != bench_compact_sizes[i] )
+                bad++;
+            else
+                {
+                flash_sim_peek( (uint32_t)(uintptr_t)data, copy, datalength );
+                if( memcmp( copy, buf, datalength ) != 0 )
+                    bad++;
+                }
+            }
+        }
+
+    // deleted files are not in the directory
+    n = 0;
+    if( RCFS_FindFirstFile( &f ) >= 0 )
+        {
+        do {
+            n++;
+            } while( RCFS_FindNextFile( &f ) >= 0 );
+        }
+    if( n != live + 1 )
+        bad++;
+
+    return(bad);
+}
+
+static void
+BenchCompact()
+{
+    static unsigned char image[RCFS_END_OFFSET];
+    static unsigned char vtoc0[RCFS_PAGE_SIZE], vtoc[RCFS_PAGE_SIZE];
+    static unsigned char buf[64];
+    bench_result    r;
+    unsigned char  *data;
+    int             datalength;
+    char            name[16];
+    short           slot;
+    long            before, after, expect;
+    uint64_t        ops;
+    int             i, k, step, points, bad, failed;
+
+    printf("\nRCFS_DeleteFile and RCFS_Compact, %d files, %d deleted\n", BENCH_COMPACT_FILES, 3 );
+
+    BenchCompactSetup();
+    if( BenchCompactCheck() != 0 )
+        BenchFail("files after delete");
+    if( RCFS_DeleteFile( "program" ) != RCFS_ERROR )
+        BenchFail("RCFS_DeleteFile ROBOTC file");
+    if( RCFS_DeleteFile( "c1" ) != RCFS_ERROR )
+        BenchFail("RCFS_DeleteFile twice");
+
+    RCFS_FindFreeSpace( &slot, &before );
+    flash_sim_peek( kStartOfFileSystem, vtoc0, sizeof(vtoc0) );
+
+    BenchClear( &r );
+    BenchStart();
+    if( RCFS_Compact() != RCFS_SUCCESS )
+        BenchFail("RCFS_Compact");
+    BenchStop( &r );
+    ops = r.programs + r.erases;
+
+    if( BenchCompactCheck() != 0 )
+        BenchFail("files after compaction");
+    // live files packed on word boundaries
+    for(i=0,expect=RCFS_DATA_OFFSET;i<BENCH_COMPACT_FILES;i++)
+        {
+        if( !bench_compact_deleted[i] )
+            expect = ((expect + 1) & ~1) + bench_compact_sizes[i] + FLASH_FILE_HEADER_SIZE;
+        }
+    RCFS_FindFreeSpace( &slot, &after );
+    if( after != ((expect + 1) & ~1) || slot != 1 + BENCH_COMPACT_FILES + 4 )
+        BenchFail("free space after compaction");
+
+    // the VTOC page is never erased, bits are only cleared
+    flash_sim_peek( kStartOfFileSystem, vtoc, sizeof(vtoc) );
+    for(i=0;i<(int)sizeof(vtoc);i++)
+        {
+        if( vtoc[i] & ~vtoc0[i] )
+            BenchFail("VTOC page erased");
+        }
+
+    printf("%10s %10s %10s %10s\n", "mS", "erases", "programs", "reclaimed");
+    printf("%10.1f %10" PRIu64 " %10" PRIu64 " %10ld\n", r.t_total / 1e6, r.erases, r.programs, (long)(before - after) );
+
+    // nothing more to do
+    BenchClear( &r );
+    BenchStart();
+    if( RCFS_Compact() != RCFS_SUCCESS )
+        BenchFail("RCFS_Compact again");
+    BenchStop( &r );
+    if( r.erases != 0 || r.programs != 0 )
+        BenchFail("RCFS_Compact with nothing to do");
+
+    BenchFill( buf, sizeof(buf), 3 );
+    if( RCFS_AddFile( buf, sizeof(buf), "after" ) != RCFS_SUCCESS ||
+        RCFS_GetFile( "after", &data, &datalength ) != RCFS_SUCCESS || memcmp( data, buf, sizeof(buf) ) != 0 )
+        BenchFail("RCFS_AddFile after compaction");
+
+    // not enough free VTOC entries for the files that would move
+    BenchFormat();
+    for(i=0;i<kMaxNumbofFlashFiles - 2;i++)
+        {
+        sprintf( name, "v%02d", i );
+        RCFS_AddFile( buf, sizeof(buf), name );
+        }
+    RCFS_DeleteFile( "v00" );
+    BenchClear( &r );
+    BenchStart();
+    if( RCFS_Compact() != RCFS_ERROR )
+        BenchFail("RCFS_Compact with a full VTOC");
+    BenchStop( &r );
+    if( r.erases != 0 || r.programs != 0 || RCFS_VerifyAll( 1 ) != 0 ||
+        RCFS_GetFile( "v29", &data, &datalength ) != RCFS_SUCCESS )
+        BenchFail("RCFS_Compact changed a full VTOC");
+
+    // power lost at points through the compaction and often near the end
+    // where the VTOC is changed, every fourth point loses power again while
+    // the compaction is being finished
+    BenchCompactSetup();
+    flash_sim_peek( kStartOfFileSystem, image, sizeof(image) );
+
+    step   = (int)(ops / 11) + 1;
+    failed = 0;
+    for(points=0;points<33;points++)
+        {
+        k = (points < 11) ? points * step : (int)ops - 66 + ((points - 11) * 3);
+
+        flash_sim_poke( kStartOfFileSystem, image, sizeof(image) );
+        BenchReboot();
+
+        flash_sim_power_fail( k );
+        RCFS_Compact();
+        BenchReboot();
+
+        if( (points & 3) == 3 )
+            {
+            flash_sim_power_fail( k / 3 );
+            BenchCompactCheck();
+            BenchReboot();
+            }
+
+        bad = BenchCompactCheck();
+        if( bad || RCFS_JournalValid() )
+            failed++;
+        }
+
+    printf("power lost at %d points in %" PRIu64 " operations, %d not recovered\n", points, ops, failed );
+    if( failed )
+        BenchFail("compaction after power loss");
+}
+#endif
+
+/*-----------------------------------------------------------------------------*/
+/*  Circular log, writes across several wraps and power lost in a record      */
+/*-----------------------------------------------------------------------------*/
+
+#define BENCH_LOG_RECORDS       300
+
+static int
+BenchLogLength( int n )
+{
+    return( 5 + (n * 37) % 180 );
+}
+
+static void
+BenchLogRecord( unsigned char *buf, int n )
+{
+    BenchFill( buf, BenchLogLength( n ), n );
+    memcpy( buf, &n, sizeof(n) );
+}
+
+// Restart the program, only the flash is kept
+static void
+BenchLogReboot()
+{
+    flash_sim_power_fail( -1 );
+    flash_sim_reset();
+    log_state.valid = 0;
+}
+
+// Check the records are in order and intact, returns the number read
+// or -1, *last is set to the number of the newest record
+static int
+BenchLogCheck( int *last )
+{
+    static unsigned char buf[RCFS_LOG_RECORD_MAX];
+    static unsigned char copy[RCFS_LOG_RECORD_MAX];
+    rcfs_log_cursor c;
+    unsigned char  *data;
+    int             length;
+    int             n, count = 0;
+
+    *last = -1;
+    if( RCFS_LogFirst( &c ) != RCFS_SUCCESS )
+        return(-1);
+
+    while( RCFS_LogNext( &c, &data, &length ) == RCFS_SUCCESS )
+        {
+        flash_sim_peek( (uint32_t)(uintptr_t)data, copy, length );
+        memcpy( &n, copy, sizeof(n) );
+
+        BenchLogRecord( buf, n );
+        if( (count > 0 && n != *last + 1) || length != BenchLogLength( n ) || memcmp( copy, buf, length ) != 0 )
+            return(-1);
+
+        *last = n;
+        count++;
+        }
+
+    return(count);
+}
+
+static void
+BenchLog()
+{
+    static unsigned char image[RCFS_LOG_PAGES * RCFS_PAGE_SIZE];
+    static unsigned char buf[RCFS_LOG_RECORD_MAX];
+    bench_result    w, ws, sv, scan;
+    int             i, k, n, last, points, failed;
+    int             count, head, torn, next;
+    uint64_t        erases;
+
+    printf("\nRCFS_LogWrite, %d pages, %d records of 5 to 184 bytes\n", RCFS_LOG_PAGES, BENCH_LOG_RECORDS );
+
+    BenchFormat();
+    if( RCFS_LogErase() != RCFS_SUCCESS )
+        BenchFail("RCFS_LogErase");
+
+    // page erased when the log moves on
+    BenchClear( &w );
+    for(i=0;i<BENCH_LOG_RECORDS;i++)
+        {
+        BenchLogRecord( buf, i );
+        BenchStart();
+        if( RCFS_LogWrite( buf, BenchLogLength( i ) ) != RCFS_SUCCESS )
+            BenchFail("RCFS_LogWrite");
+        BenchStop( &w );
+        }
+
+    // boot scan
+    BenchLogReboot();
+    BenchClear( &scan );
+    BenchStart();
+    RCFS_LogScan();
+    BenchStop( &scan );
+
+    n = BenchLogCheck( &last );
+    if( n < 0 || last != BENCH_LOG_RECORDS - 1 )
+        BenchFail("log after reboot");
+    // all but the page being erased next
+    else if( n < ((RCFS_LOG_PAGES - 1) * (RCFS_PAGE_SIZE - RCFS_LOG_HEADER_SIZE)) / (2 + 184) )
+        BenchFail("records kept in the log");
+
+    // page erased ahead by RCFS_LogService
+    BenchClear( &ws );
+    BenchClear( &sv );
+    for(i=BENCH_LOG_RECORDS;i<2*BENCH_LOG_RECORDS;i++)
+        {
+        BenchLogRecord( buf, i );
+        BenchStart();
+        if( RCFS_LogWrite( buf, BenchLogLength( i ) ) != RCFS_SUCCESS )
+            BenchFail("RCFS_LogWrite");
+        BenchStop( &ws );
+
+        BenchStart();
+        if( RCFS_LogService() )
+            BenchStop( &sv );
+        }
+    if( BenchLogCheck( &last ) < 0 || last != 2*BENCH_LOG_RECORDS - 1 )
+        BenchFail("log with service");
+
+    printf("%-22s %10s %10s %10s %10s\n", "", "mean uS", "max uS", "erases", "records");
+    printf("%-22s %10.1f %10.1f %10" PRIu64 " %10d\n", "write",
+        BenchMean( &w ), w.t_max / 1000.0, w.erases, w.calls );
+    printf("%-22s %10.1f %10.1f %10" PRIu64 " %10d\n", "write with service",
+        BenchMean( &ws ), ws.t_max / 1000.0, ws.erases, ws.calls );
+    printf("%-22s %10.1f %10.1f %10" PRIu64 " %10d\n", "service erase",
+        BenchMean( &sv ), sv.t_max / 1000.0, sv.erases, sv.calls );
+    printf("%-22s %10.1f %10s %10s %10d\n", "boot scan", BenchMean( &scan ), "", "", n );
+
+    // power lost while writing a record that starts a new page
+    BenchLogRecord( buf, 0 );
+    flash_sim_peek( kStartOfFileSystem + RCFS_LOG_OFFSET, image, sizeof(image) );
+
+    points = 0;
+    failed = 0;
+    for(k=0;k<100;k+=10)
+        {
+        flash_sim_poke( kStartOfFileSystem + RCFS_LOG_OFFSET, image, sizeof(image) );
+        BenchLogReboot();
+
+        // fill the head page then lose power
+        for(i=2*BENCH_LOG_RECORDS;;i++)
+            {
+            BenchLogRecord( buf, i );
+            if( (log_state.offset + 2 + BenchLogLength( i ) + 1) > RCFS_PAGE_SIZE )
+                break;
+            RCFS_LogWrite( buf, BenchLogLength( i ) );
+            }
+        flash_sim_power_fail( k );
+        RCFS_LogWrite( buf, BenchLogLength( i ) );
+        BenchLogReboot();
+
+        // interrupted record may or may not be there
+        n = BenchLogCheck( &last );
+        if( n <= 0 || (last != i - 1 && last != i) )
+            failed++;
+        else
+            {
+            BenchLogRecord( buf, last + 1 );
+            if( RCFS_LogWrite( buf, BenchLogLength( last + 1 ) ) != RCFS_SUCCESS ||
+                BenchLogCheck( &n ) <= 0 || n != last + 1 )
+                failed++;
+            }
+        points++;
+        }
+
+    printf("power lost at %d points in a record, %d not recovered\n", points, failed );
+    if( failed )
+        BenchFail("log after power loss");
+
+    // power lost in a record with room in the head page, the rest of the
+    // page is still used and nothing is erased
+    points = 0;
+    failed = 0;
+    torn   = 0;
+    for(k=0;k<5;k++)
+        {
+        flash_sim_poke( kStartOfFileSystem + RCFS_LOG_OFFSET, image, sizeof(image) );
+        BenchLogReboot();
+
+        count = BenchLogCheck( &last );
+        for(i=last+1;;i++)
+            {
+            BenchLogRecord( buf, i );
+            if( (log_state.offset > RCFS_LOG_HEADER_SIZE) &&
+                (log_state.offset + 2 + BenchLogLength( i ) + 1) <= RCFS_PAGE_SIZE )
+                break;
+            RCFS_LogWrite( buf, BenchLogLength( i ) );
+            }
+        count = BenchLogCheck( &last );
+        head  = log_state.head;
+
+        flash_sim_power_fail( k );
+        RCFS_LogWrite( buf, BenchLogLength( i ) );
+        BenchLogReboot();
+
+        erases = flash_sim_get_stats()->erases;
+        n = BenchLogCheck( &last );
+        if( last == i - 1 )
+            torn++;
+
+        // interrupted record may or may not be there
+        if( n < count || (last != i - 1 && last != i) || log_state.head != head ||
+            flash_sim_get_stats()->erases != erases )
+            failed++;
+        else
+            {
+            BenchLogRecord( buf, last + 1 );
+            if( RCFS_LogWrite( buf, BenchLogLength( last + 1 ) ) != RCFS_SUCCESS ||
+                BenchLogCheck( &next ) != n + 1 || next != last + 1 || log_state.head != head )
+                failed++;
+            }
+        points++;
+        }
+
+    printf("power lost at %d points in a record mid page, %d not recovered\n", points, failed );
+    if( failed || torn == 0 )
+        BenchFail("log after power loss mid page");
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Telemetry file of robot like sensor data                                   */
+/*-----------------------------------------------------------------------------*/
+
+#define BENCH_TELEM_SAMPLES     2000
+#define BENCH_TELEM_FIELDS      4
+
+// time mS, encoder, gyro in 0.1 deg and motor power
+static void
+BenchTelemValues( int n, long *v )
+{
+    v[0] = 1000 + n * 10;
+    v[1] = (n * n) / 40 - n * 3;
+    v[2] = (long)(900.0 * sin( n / 150.0 ));
+    v[3] = ((n / 50) & 1) ? 127 - (n % 50) : -60 + (n % 7);
+}
+
+// Decode the file and compare with the values written, returns the number
+// of samples that match
+static int
+BenchTelemCheck( unsigned char *p, int length )
+{
+    static int  types[BENCH_TELEM_FIELDS] = { RCFS_TELEM_DELTA, RCFS_TELEM_DELTA, RCFS_TELEM_DELTA, RCFS_TELEM_VALUE };
+    long        v[BENCH_TELEM_FIELDS], last[BENCH_TELEM_FIELDS], x;
+    uint32_t    u;
+    int         i, k, shift, n = 0;
+
+    if( length < 4 + 4 * BENCH_TELEM_FIELDS || p[0] != 'R' || p[1] != 'T' || p[3] != BENCH_TELEM_FIELDS )
+        return(-1);
+
+    k = 4 + 4 * BENCH_TELEM_FIELDS;
+    memset( last, 0, sizeof(last) );
+    while( k < length )
+        {
+        BenchTelemValues( n, v );
+        for(i=0;i<BENCH_TELEM_FIELDS;i++)
+            {
+            for(u=0,shift=0;p[k] & 0x80;shift+=7)
+                u |= (uint32_t)(p[k++] & 0x7F) << shift;
+            u |= (uint32_t)p[k++] << shift;
+
+            x = (long)((u >> 1) ^ (0 - (u & 1)));
+            if( types[i] == RCFS_TELEM_DELTA )
+                x += last[i];
+            if( x != v[i] )
+                return(n);
+            last[i] = x;
+            }
+        n++;
+        }
+
+    return(n);
+}
+
+static void
+BenchTelem()
+{
+    static unsigned char copy[RCFS_STREAM_MAX_SIZE];
+    bench_result    r;
+    unsigned char  *data;
+    int             datalength;
+    long            v[BENCH_TELEM_FIELDS];
+    int             f[BENCH_TELEM_FIELDS];
+#ifdef RCFS_COMPRESS
+    flash_file      ff;
+#endif
+    int             i, k;
+
+    printf("\nRCFS_TelemSample, %d samples of %d fields\n", BENCH_TELEM_SAMPLES, BENCH_TELEM_FIELDS );
+
+    BenchFormat();
+
+    // telemetry is never compressed
+#ifdef RCFS_COMPRESS
+    RCFS_SetCompression( 1 );
+#endif
+    if( RCFS_TelemOpen( "telem" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_TelemOpen");
+#ifdef RCFS_COMPRESS
+    RCFS_SetCompression( 0 );
+#endif
+    f[0] = RCFS_TelemField( 1, RCFS_TELEM_DELTA, -3 );
+    f[1] = RCFS_TelemField( 2, RCFS_TELEM_DELTA,  0 );
+    f[2] = RCFS_TelemField( 3, RCFS_TELEM_DELTA, -1 );
+    f[3] = RCFS_TelemField( 4, RCFS_TELEM_VALUE,  0 );
+    if( RCFS_TelemField( 256, RCFS_TELEM_VALUE, 0 ) != RCFS_ERROR )
+        BenchFail("RCFS_TelemField bad id");
+
+    BenchClear( &r );
+    for(i=0;i<BENCH_TELEM_SAMPLES;i++)
+        {
+        BenchTelemValues( i, v );
+        for(k=0;k<BENCH_TELEM_FIELDS;k++)
+            RCFS_TelemSet( f[k], v[k] );
+
+        BenchStart();
+        if( RCFS_TelemSample() != RCFS_SUCCESS )
+            BenchFail("RCFS_TelemSample");
+        BenchStop( &r );
+        }
+
+    if( RCFS_TelemField( 5, RCFS_TELEM_VALUE, 0 ) != RCFS_ERROR )
+        BenchFail("RCFS_TelemField after first sample");
+    if( RCFS_TelemClose() != RCFS_SUCCESS )
+        BenchFail("RCFS_TelemClose");
+#ifdef RCFS_COMPRESS
+    if( RCFS_FindFile( "telem", &ff ) < 0 || (RCFS_FileFlags( &ff ) & RCFS_FILE_LZ) )
+        BenchFail("RCFS_TelemOpen compressed");
+#endif
+
+    if( RCFS_GetFile( "telem", &data, &datalength ) != RCFS_SUCCESS )
+        BenchFail("RCFS_GetFile telem");
+    else
+        {
+        flash_sim_peek( (uint32_t)(uintptr_t)data, copy, datalength );
+        if( BenchTelemCheck( copy, datalength ) != BENCH_TELEM_SAMPLES )
+            BenchFail("telemetry samples");
+
+        printf("%10s %10s %10s %10s\n", "mean uS", "max uS", "bytes", "fixed");
+        printf("%10.1f %10.1f %10d %10d\n", BenchMean( &r ), r.t_max / 1000.0,
+            datalength, BENCH_TELEM_SAMPLES * BENCH_TELEM_FIELDS * 4 );
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Record at 20mS from a jittery loop and replay from a slower one           */
+/*-----------------------------------------------------------------------------*/
+
+#define BENCH_REPLAY_MS         15000
+
+// a ramp and a step, the ramp interpolates exactly
+static int
+BenchReplayValue( int ch, long t )
+{
+    if( ch == 0 )
+        return( (int)(t / 20) - 300 );
+    return( ((t / 1000) & 1) ? 127 : -127 );
+}
+
+static void
+BenchReplay()
+{
+    bench_result    rec, upd, get;
+    long            t, start;
+    int             i, v, worst, late, steps;
+
+    printf("\nRCFS_RecordSample and RCFS_Replay, 20mS period, %d mS\n", BENCH_REPLAY_MS );
+
+    BenchFormat();
+    srand( 2 );
+
+    if( RCFS_RecordStart( "path", 2, 20 ) != RCFS_SUCCESS )
+        BenchFail("RCFS_RecordStart");
+    if( RCFS_RecordStart( "path2", 2, 20 ) != RCFS_ERROR )
+        BenchFail("RCFS_RecordStart twice");
+
+    BenchClear( &rec );
+    start = nSysTime;
+    while( (t = nSysTime - start) < BENCH_REPLAY_MS )
+        {
+        for(i=0;i<2;i++)
+            RCFS_RecordSet( i, BenchReplayValue( i, t ) );
+
+        BenchStart();
+        if( RCFS_RecordSample() == RCFS_ERROR )
+            BenchFail("RCFS_RecordSample");
+        BenchStop( &rec );
+
+        // driver loop of 5 to 25mS
+        wait1Msec( 5 + rand() % 21 );
+        }
+    if( RCFS_RecordStop() != RCFS_SUCCESS )
+        BenchFail("RCFS_RecordStop");
+
+    BenchClear( &upd );
+    BenchClear( &get );
+    if( RCFS_ReplayStart( "path" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_ReplayStart");
+
+    worst = 0;
+    late  = 0;
+    steps = 0;
+    start = nSysTime;
+    while( 1 )
+        {
+        BenchStart();
+        i = RCFS_ReplayUpdate();
+        BenchStop( &upd );
+        if( !i )
+            break;
+
+        t = nSysTime - start;
+
+        BenchStart();
+        v = RCFS_ReplayGet( 0 );
+        BenchStop( &get );
+
+        // the ramp is recorded with jitter, allow a count of rounding
+        if( abs( v - BenchReplayValue( 0, t ) ) > worst )
+            worst = abs( v - BenchReplayValue( 0, t ) );
+        if( RCFS_ReplayGetStep( 1 ) != BenchReplayValue( 1, t ) )
+            steps++;
+
+        // autonomous loop of 30 to 50mS
+        wait1Msec( 30 + rand() % 21 );
+        }
+    late = (int)((nSysTime - start) - BENCH_REPLAY_MS);
+
+    printf("%10s %10s %10s %10s %10s %10s\n", "samples", "record uS", "update uS", "get uS", "ram", "end mS");
+    printf("%10ld %10.1f %10.1f %10.1f %10d %10d\n", (long)record.samples, BenchMean( &rec ),
+        BenchMean( &upd ), BenchMean( &get ), (int)sizeof(rcfs_replay), late );
+
+    if( worst > 1 )
+        BenchFail("RCFS_ReplayGet interpolation");
+    // a step can only be wrong for up to a sample after it changes
+    if( steps > 2 * (BENCH_REPLAY_MS / 1000) )
+        BenchFail("RCFS_ReplayGetStep");
+    if( late < -60 || late > 60 )
+        BenchFail("replay length");
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Sample ring from a 10mS control loop, the yield hook is the logger task    */
+/*-----------------------------------------------------------------------------*/
+
+#define BENCH_RING_SAMPLES      2000
+#define BENCH_RING_SIZE         16
+
+#define BENCH_RING_YIELDS       100000
+
+static  bench_result    ring_svc;
+static  int             ring_cross;
+static  long            ring_yields;
+
+static void
+BenchRingLogger()
+{
+    unsigned long   start = write_stream.addr + FLASH_FILE_HEADER_SIZE + write_stream.written;
+    unsigned long   end;
+    int             n;
+
+    BenchStart();
+    n = RCFS_RingService();
+    BenchStop( &ring_svc );
+
+    if( n < 0 )
+        BenchFail("RCFS_RingService");
+
+    // a batch only goes into the next page to finish a record
+    end = write_stream.addr + FLASH_FILE_HEADER_SIZE + write_stream.written;
+    if( n > 0 && (start / RCFS_PAGE_SIZE) != ((end - 1) / RCFS_PAGE_SIZE) &&
+        (end % RCFS_PAGE_SIZE) >= BENCH_RING_SIZE )
+        ring_cross++;
+}
+
+// the control loop, a record each time the logger task lets it run
+static void
+BenchRingProducer()
+{
+    unsigned char   rec[BENCH_RING_SIZE];
+
+    // the logger task has not stopped, end it
+    if( ++ring_yields >= BENCH_RING_YIELDS )
+        ring.closing = 1;
+
+    BenchFill( rec, BENCH_RING_SIZE, ring_yields );
+    RCFS_RingPush( rec );
+}
+
+static void
+BenchRing()
+{
+    static unsigned char buf[BENCH_RING_SAMPLES * BENCH_RING_SIZE];
+    unsigned char   rec[BENCH_RING_SIZE];
+    unsigned char  *data;
+    int             datalength;
+    bench_result    push;
+    rcfs_ring_stat  st;
+    long            next;
+    int             i, late;
+
+    printf("\nRCFS_RingPush from a 10mS loop, %d records of %d bytes\n", BENCH_RING_SAMPLES, BENCH_RING_SIZE );
+
+    BenchFormat();
+    for(i=0;i<BENCH_RING_SAMPLES;i++)
+        BenchFill( &buf[i * BENCH_RING_SIZE], BENCH_RING_SIZE, i );
+
+    if( RCFS_RingOpen( "ring", BENCH_RING_SIZE ) != RCFS_SUCCESS )
+        BenchFail("RCFS_RingOpen");
+    if( RCFS_RingOpen( "ring2", BENCH_RING_SIZE ) != RCFS_ERROR )
+        BenchFail("RCFS_RingOpen twice");
+
+    BenchClear( &push );
+    BenchClear( &ring_svc );
+    ring_cross = 0;
+    late = 0;
+    robotc_yield_hook = BenchRingLogger;
+
+    next = nSysTime;
+    for(i=0;i<BENCH_RING_SAMPLES;i++)
+        {
+        if( (long)nSysTime > next )
+            late++;
+
+        BenchStart();
+        if( RCFS_RingPush( &buf[i * BENCH_RING_SIZE] ) != RCFS_SUCCESS )
+            BenchFail("RCFS_RingPush");
+        BenchStop( &push );
+
+        // the logger runs while the loop waits
+        next += 10;
+        while( (long)nSysTime < next )
+            wait1Msec( 1 );
+        }
+
+    robotc_yield_hook = NULL;
+    RCFS_RingStat( &st );
+    if( RCFS_RingClose() != RCFS_SUCCESS )
+        BenchFail("RCFS_RingClose");
+
+    printf("%10s %10s %10s %10s %10s %10s %10s\n", "push uS", "prog/push", "batches", "uS/batch", "max uS", "high", "late");
+    printf("%10.1f %10.1f %10ld %10.1f %10.1f %10d %10d\n", BenchMean( &push ), (double)push.programs / push.calls,
+        (long)st.batches, ring_svc.t_total / 1000.0 / st.batches, ring_svc.t_max / 1000.0, st.high, late );
+
+    if( push.programs != 0 || push.reads != 0 || late != 0 )
+        BenchFail("RCFS_RingPush used flash");
+    if( st.pushed != BENCH_RING_SAMPLES || st.dropped != 0 || ring_cross != 0 )
+        BenchFail("RCFS_RingService batches");
+    if( RCFS_GetFile( "ring", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != sizeof(buf) || memcmp( data, buf, sizeof(buf) ) != 0 )
+        BenchFail("ring file contents");
+
+    // no logger, the ring fills and then drops records
+    if( RCFS_RingOpen( "ring2", BENCH_RING_SIZE ) != RCFS_SUCCESS )
+        BenchFail("RCFS_RingOpen again");
+    for(i=0;i<100;i++)
+        {
+        BenchFill( rec, BENCH_RING_SIZE, i );
+        RCFS_RingPush( rec );
+        if( i == 79 && RCFS_RingService() <= 0 )
+            BenchFail("RCFS_RingService full ring");
+        }
+    RCFS_RingStat( &st );
+
+    printf("%-10s %10s %10s %10s %10s\n", "overflow", "records", "pushed", "dropped", "overflows");
+    printf("%-10s %10d %10ld %10ld %10ld\n", "", st.records, (long)st.pushed, (long)st.dropped, (long)st.overflows );
+
+    if( st.pushed != st.records + st.written || st.dropped != 100 - st.pushed || st.overflows != 2 )
+        BenchFail("ring overflow counters");
+    if( RCFS_RingClose() != RCFS_SUCCESS )
+        BenchFail("RCFS_RingClose full ring");
+    if( RCFS_GetFile( "ring2", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != st.pushed * BENCH_RING_SIZE || memcmp( data, buf, st.records * BENCH_RING_SIZE ) != 0 )
+        BenchFail("full ring file contents");
+
+    // the logger task stops when the file is full
+    BenchFormat();
+    if( RCFS_RingOpen( "ring3", BENCH_RING_SIZE ) != RCFS_SUCCESS || RCFS_RingStart() != RCFS_SUCCESS )
+        BenchFail("RCFS_RingStart");
+    ring_yields = 0;
+    robotc_yield_hook = BenchRingProducer;
+    RCFS_RingTask();
+    robotc_yield_hook = NULL;
+    RCFS_RingStat( &st );
+
+    if( ring_yields >= BENCH_RING_YIELDS || ring.running || RCFS_RingPush( rec ) != RCFS_ERROR ||
+        RCFS_RingClose() != RCFS_ERROR )
+        BenchFail("RCFS_RingTask full file");
+    if( RCFS_GetFile( "ring3", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != RCFS_STREAM_MAX_SIZE || datalength != st.written * BENCH_RING_SIZE ||
+        RCFS_AddFile( rec, BENCH_RING_SIZE, "after" ) != RCFS_SUCCESS )
+        BenchFail("full ring file");
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Background writes, the service function stands in for the writer task     */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchQueue()
+{
+    static int      budgets[] = { 32, 64, 128, 256 };
+    static unsigned char buf[4096];
+    bench_result    slice;
+    unsigned char  *data;
+    int             datalength;
+    flash_user      u;
+    int             hf1, hf2, hu;
+    flash_file      f;
+    uint64_t        programs;
+    uint32_t        addr;
+    uint16_t        zero = 0;
+    int             i;
+
+    printf("\nFlashQueueService, 4096 and 1024 byte files and a user write, uS per slice\n");
+    printf("%8s %10s %10s %10s %10s\n", "budget", "slices", "mean uS", "max file", "max all");
+
+    for(i=0;i<(int)(sizeof(budgets)/sizeof(int));i++)
+        {
+        uint64_t    file_max = 0;
+
+        BenchFormat();
+        BenchFill( buf, sizeof(buf), i );
+        BenchClear( &slice );
+        FlashQueueSetBudget( budgets[i] );
+
+        memset( &u, 0, sizeof(u) );
+        u.data[0] = i + 1;
+
+        hf1 = FlashQueueFile( buf, 4096, "queue1" );
+        hu  = FlashQueueUser( &u );
+        hf2 = FlashQueueFile( buf, 1024, "queue2" );
+        if( hf1 <= 0 || hu <= 0 || hf2 <= 0 )
+            BenchFail("FlashQueue");
+
+        // user parameters were copied
+        u.data[0] = 0;
+
+        if( FlashQueueStatus( hf1 ) != FLASH_REQ_PENDING )
+            BenchFail("FlashQueueStatus pending");
+
+        for(;;)
+            {
+            int more, user;
+
+            user = (FlashQueueStatus( hf1 ) == FLASH_REQ_DONE) && (FlashQueueStatus( hu ) == FLASH_REQ_PENDING);
+
+            BenchStart();
+            more = FlashQueueService();
+            BenchStop( &slice );
+
+            if( !user && (flash_sim_time_ns() - bench_t0) > file_max )
+                file_max = flash_sim_time_ns() - bench_t0;
+            if( !more )
+                break;
+            }
+
+        if( FlashQueueStatus( hf1 ) != FLASH_REQ_DONE || FlashQueueStatus( hf2 ) != FLASH_REQ_DONE ||
+            FlashQueueStatus( hu ) != FLASH_REQ_DONE )
+            BenchFail("FlashQueueStatus done");
+        if( RCFS_GetFile( "queue1", &data, &datalength ) != RCFS_SUCCESS ||
+            datalength != 4096 || memcmp( data, buf, 4096 ) != 0 )
+            BenchFail("queued file contents");
+        if( RCFS_GetFile( "queue2", &data, &datalength ) != RCFS_SUCCESS ||
+            datalength != 1024 || memcmp( data, buf, 1024 ) != 0 )
+            BenchFail("queued file contents");
+        if( FlashUserRead()->data[0] != i + 1 )
+            BenchFail("queued user write");
+
+        printf("%8d %10d %10.1f %10.1f %10.1f\n", budgets[i], slice.calls, BenchMean( &slice ),
+            file_max / 1000.0, slice.t_max / 1000.0 );
+        }
+
+    // a file that cannot be written or closed fails and the next one is written
+    BenchFormat();
+    addr = kStartOfFileSystem + RCFS_DATA_OFFSET + FLASH_FILE_HEADER_SIZE + 200;
+    flash_sim_poke( addr, &zero, 2 );
+    hf1 = FlashQueueFile( buf, 1024, "bad" );
+    hf2 = FlashQueueFile( buf, 1024, "good" );
+    while( FlashQueueService() )
+        ;
+    if( FlashQueueStatus( hf1 ) != RCFS_ERROR || FlashQueueStatus( hf2 ) != FLASH_REQ_DONE ||
+        RCFS_FindFile( "bad", &f ) >= 0 || RCFS_GetFile( "good", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != 1024 || memcmp( data, buf, 1024 ) != 0 )
+        BenchFail("queued file after write error");
+
+    // a file that cannot fit is refused before anything is programmed
+    programs = flash_sim_get_stats()->programs;
+    hf1 = FlashQueueFile( buf, RCFS_STREAM_MAX_SIZE + 2, "big" );
+    while( FlashQueueService() )
+        ;
+    if( FlashQueueStatus( hf1 ) != RCFS_ERROR || flash_sim_get_stats()->programs != programs ||
+        RCFS_FindFile( "big", &f ) >= 0 )
+        BenchFail("queued file too big");
+
+    FlashQueueSetBudget( FLASH_QUEUE_SLICE_BYTES );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Page erase wait and timeout                                                */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchWait()
+{
+    flash_sim_timing   *t = flash_sim_get_timing();
+    uint64_t            t_erase = t->t_erase;
+    bench_result        r;
+    FLASH_Status        status;
+
+    printf("\nFLASH_ErasePage, EraseTimeout %d mS\n", EraseTimeout );
+    printf("%10s %10s %10s %10s\n", "erase mS", "status", "wait mS", "SR reads");
+
+    BenchFormat();
+    FLASH_UnlockBank1();
+
+    // normal erase then an erase that is too slow
+    for( t->t_erase = t_erase; t->t_erase <= 100000000; t->t_erase += 80000000 )
+        {
+        uint64_t reg0 = flash_sim_get_stats()->reg_reads;
+
+        BenchClear( &r );
+        BenchStart();
+        status = FLASH_ErasePage( FLASH_USER_PAGE_ADDR );
+        BenchStop( &r );
+
+        printf("%10.1f %10s %10.1f %10" PRIu64 "\n", t->t_erase / 1e6,
+            status == FLASH_COMPLETE ? "complete" : (status == FLASH_TIMEOUT ? "timeout" : "error"), r.t_total / 1e6,
+            flash_sim_get_stats()->reg_reads - reg0 );
+
+        if( t->t_erase == t_erase && status != FLASH_COMPLETE )
+            BenchFail("FLASH_ErasePage");
+        if( t->t_erase != t_erase && (status != FLASH_TIMEOUT ||
+            r.t_total < EraseTimeout * 1000000ull || r.t_total > (EraseTimeout + 2) * 1000000ull) )
+            BenchFail("FLASH_ErasePage timeout");
+
+        // let it finish
+        FLASH_WaitForLastOperation( 200 );
+        }
+
+    t->t_erase = t_erase;
+
+    // another task ran for longer than the timeout after BSY was seen, the
+    // operation finished meanwhile
+    flash_sim_preempt( (EraseTimeout + 5) * 1000000ull );
+    if( FLASH_ErasePage( FLASH_USER_PAGE_ADDR ) != FLASH_COMPLETE )
+        BenchFail("FLASH_ErasePage preempted");
+    flash_sim_preempt( (ProgramTimeout + 5) * 1000000ull );
+    if( FLASH_ProgramHalfWord( FLASH_USER_PAGE_ADDR, 0x1234 ) != FLASH_COMPLETE )
+        BenchFail("FLASH_ProgramHalfWord preempted");
+    flash_sim_preempt( (ProgramTimeout + 5) * 1000000ull );
+    if( FLASH_ProgramBuffer( FLASH_USER_PAGE_ADDR + 2, (uint16_t *)&t_erase, 4, NULL ) != FLASH_COMPLETE )
+        BenchFail("FLASH_ProgramBuffer preempted");
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Controller mutex, the yield hook is a second task programming the user    */
+/*  page a half word at a time                                                 */
+/*-----------------------------------------------------------------------------*/
+
+static  int     mutex_ok, mutex_busy, mutex_bad;
+
+static void
+BenchMutexTask()
+{
+    uint32_t        addr = FLASH_USER_PAGE_ADDR + mutex_ok * 2;
+    uint16_t        v;
+    FLASH_Status    status;
+
+    status = FLASH_ProgramHalfWord( addr, 0x5A00 + mutex_ok );
+    flash_sim_peek( addr, &v, 2 );
+
+    if( status == FLASH_COMPLETE && v == 0x5A00 + mutex_ok )
+        mutex_ok++;
+    else
+    if( status == FLASH_BUSY && v == 0xFFFF )
+        mutex_busy++;
+    else
+        mutex_bad++;
+}
+
+static void
+BenchMutex()
+{
+    static unsigned char    buf[8192];
+    unsigned char  *data;
+    long            datalength;
+    uint64_t        t0, programs;
+    uint16_t        v;
+    FLASH_Status    status;
+    flash_user     *u;
+    int             busy;
+
+    printf("\nFlash controller mutex, MutexTimeout %d mS\n", MutexTimeout );
+
+    BenchFormat();
+    FLASH_UnlockBank1();
+    if( RCFS_AddFile( buf, 100, "kept" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_AddFile before mutex");
+
+    // held by another task, the write gives up after MutexTimeout
+    if( FLASH_MutexTryTake() != 1 || FLASH_MutexTryTake() != 0 || !FLASH_MutexHeld() )
+        BenchFail("FLASH_MutexTryTake");
+
+    programs = flash_sim_get_stats()->programs;
+    t0 = flash_sim_time_ns();
+    status = FLASH_ProgramHalfWord( FLASH_USER_PAGE_ADDR, 0x1234 );
+    t0 = flash_sim_time_ns() - t0;
+    flash_sim_peek( FLASH_USER_PAGE_ADDR, &v, 2 );
+
+    printf("%-24s %10s %10.1f mS\n", "write while locked",
+        status == FLASH_BUSY ? "busy" : "not busy", t0 / 1e6 );
+
+    if( status != FLASH_BUSY || v != 0xFFFF || flash_sim_get_stats()->programs != programs ||
+        t0 < MutexTimeout * 1000000ull || t0 > (MutexTimeout + 2) * 1000000ull )
+        BenchFail("write while locked");
+
+    // unlock and clearing flags fail as well, and so do the writes after them
+    if( FLASH_UnlockBank1() != FLASH_BUSY ||
+        FLASH_ClearFlag( FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR ) != FLASH_BUSY )
+        BenchFail("unlock while locked");
+    RCFS_GetWriteError( NULL );
+    u = FlashUserRead();
+    u->data[0] ^= 0xFF;
+    if( RCFS_AddFile( buf, 100, "locked" ) != RCFS_ERROR || RCFS_GetWriteError( NULL ) != FLASH_BUSY ||
+        FlashUserWrite( u ) != FLASH_ERROR_WRITE || RCFS_DeleteFile( "kept" ) != RCFS_ERROR ||
+        RCFS_GetWriteError( NULL ) != FLASH_BUSY || flash_sim_get_stats()->programs != programs )
+        BenchFail("write after unlock while locked");
+
+    FLASH_MutexGive();
+    if( FLASH_MutexHeld() || FLASH_ProgramHalfWord( FLASH_USER_PAGE_ADDR, 0x1234 ) != FLASH_COMPLETE ||
+        RCFS_Verify( "kept" ) != RCFS_SUCCESS )
+        BenchFail("FLASH_MutexGive");
+
+    // the test and set does not end a caller's hold on the CPU
+    FLASH_HogCPU();
+    FLASH_HogCPU();
+    if( FLASH_MutexTryTake() != 1 || !robotc_hog )
+        BenchFail("FLASH_MutexTryTake with FLASH_HogCPU");
+    FLASH_MutexGive();
+    FLASH_ReleaseCPU();
+    if( !robotc_hog )
+        BenchFail("FLASH_ReleaseCPU nested");
+    FLASH_ReleaseCPU();
+    if( robotc_hog )
+        BenchFail("FLASH_ReleaseCPU");
+
+    // second task writes between file blocks, not during an erase
+    FLASH_ErasePage( FLASH_USER_PAGE_ADDR );
+    mutex_ok = mutex_busy = mutex_bad = 0;
+    robotc_yield_hook = BenchMutexTask;
+
+    BenchFill( buf, sizeof(buf), 24 );
+    if( RCFS_AddFile( buf, sizeof(buf), "locked" ) != RCFS_SUCCESS )
+        BenchFail("RCFS_AddFile with second task");
+    busy = mutex_busy;
+
+    status = FLASH_ErasePage( FLASH_USER_PAGE_ADDR - RCFS_PAGE_SIZE );
+
+    robotc_yield_hook = NULL;
+
+    printf("%-24s %10d writes %4d busy\n", "RCFS_AddFile", mutex_ok, busy );
+    printf("%-24s %10s %10d busy\n", "FLASH_ErasePage", status == FLASH_COMPLETE ? "complete" : "error",
+        mutex_busy - busy );
+
+    if( RCFS_GetFile( "locked", &data, &datalength ) != RCFS_SUCCESS ||
+        datalength != sizeof(buf) || memcmp( data, buf, sizeof(buf) ) != 0 )
+        BenchFail("file written with second task");
+    if( mutex_ok == 0 || busy != 0 || mutex_bad != 0 )
+        BenchFail("second task writes");
+    if( status != FLASH_COMPLETE || mutex_busy == busy )
+        BenchFail("erase with second task");
+    if( FLASH_MutexHeld() )
+        BenchFail("mutex left held");
+}
+
+#ifndef FLASH_USER_KEYED
+/*-----------------------------------------------------------------------------*/
+/*  FlashUserWrite and FlashUserRead                                           */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchUser()
+{
+    static int      points[] = { 1, 28, 56 };
+    bench_result    wr, rd, cold;
+    flash_user     *u;
+    int             i, n, p;
+
+    BenchFormat();
+
+    printf("\nFlashUserWrite, 112 writes\n");
+    printf("%10s %10s %10s %10s %10s\n", "mean uS", "min uS", "max uS", "prog/call", "erases");
+
+    BenchClear( &wr );
+    for(n=0;n<112;n++)
+        {
+        u = FlashUserRead();
+        u->data[0] = n;
+
+        BenchStart();
+        if( FlashUserWrite( u ) != 1 )
+            BenchFail("FlashUserWrite");
+        BenchStop( &wr );
+
+        if( FlashUserRead()->data[0] != n )
+            BenchFail("FlashUserRead after write");
+        }
+
+    printf("%10.1f %10.1f %10.1f %10.1f %10" PRIu64 "\n", BenchMean( &wr ), wr.t_min / 1000.0, wr.t_max / 1000.0,
+        (double)wr.programs / wr.calls, wr.erases );
+
+    printf("\nFlashUserRead, by number of records in the page, uS (flash reads)\n");
+    printf("%10s %16s %16s\n", "records", "first read", "read");
+
+    for(i=0,n=0;i<(int)(sizeof(points)/sizeof(int));i++)
+        {
+        // erased page then enough writes to reach this point
+        if( i == 0 )
+            {
+            BenchFormat();
+            n = 0;
+            }
+        for(;n<points[i];n++)
+            {
+            u = FlashUserRead();
+            u->data[1] = n;
+            FlashUserWrite( u );
+            }
+
+        // first read after a reset has to find the newest record
+        BenchClear( &cold );
+        FlashUserCacheInvalidate();
+        BenchStart();
+        u = FlashUserRead();
+        BenchStop( &cold );
+
+        BenchClear( &rd );
+        for(p=0;p<8;p++)
+            {
+            BenchStart();
+            u = FlashUserRead();
+            BenchStop( &rd );
+            }
+        if( u->data[1] != (unsigned char)(n - 1) )
+            BenchFail("FlashUserRead");
+
+        printf("%10d %8.1f (%5" PRIu64 ") %8.1f (%5" PRIu64 ")\n", points[i],
+            BenchMean( &cold ), cold.reads, BenchMean( &rd ), (rd.reads / rd.calls) );
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  User parameter page ring, wear and interrupted writes                      */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchUserRing()
+{
+    flash_user_stat st;
+    flash_user     *u;
+    uint32_t        words[FLASH_USER_SIZE];
+    uint32_t        zero = 0;
+    uint16_t        half = 0;
+    uint64_t        e0;
+    int             n, erases;
+
+    printf("\nFlashUserWrite page ring, %d pages of %d records\n", FLASH_USER_PAGES, FLASH_USER_RECORDS );
+
+    // wear, every page is erased in turn, stop with space in the last page
+    BenchFormat();
+    e0 = flash_sim_get_stats()->erases;
+    for(n=0;n<FLASH_USER_RECORDS * 10 - 5;n++)
+        {
+        u = FlashUserRead();
+        u->data[0] = n;
+        u->data[4] = n >> 8;
+        if( FlashUserWrite( u ) != 1 )
+            BenchFail("FlashUserWrite ring");
+        }
+    erases = flash_sim_get_stats()->erases - e0;
+    u = FlashUserRead();
+    if( (u->data[0] | (u->data[4] << 8)) != n - 1 )
+        BenchFail("FlashUserRead ring");
+    printf("%6d writes, %d erases, page %d seq %d\n", n, erases, user_ring.page, user_ring.seq );
+    if( erases != 9 || user_ring.seq != 9 )
+        BenchFail("page ring erases");
+
+    FlashUserStat( &st );
+    printf("   FlashUserStat %d of %d records free, %ld erases, %ld per page\n", st.free, st.size, st.erases, st.wear );
+    if( st.erases != erases || st.free != 5 || st.used != FLASH_USER_RECORDS - 5 || st.wear != 5 )
+        BenchFail("FlashUserStat ring");
+
+    // power lost while writing a record, the index entry is started but
+    // not complete
+    FlashUserScan();
+    flash_sim_poke( FlashUserPageAddr( user_ring.head ) + user_ring.next * 4, &half, 2 );
+    flash_sim_poke( FlashUserPageAddr( user_ring.head ) + (FLASH_USER_INDEX_SIZE + user_ring.next * FLASH_USER_SIZE) * 4, &zero, 4 );
+    FlashUserCacheInvalidate();
+    if( FlashUserRead()->data[0] != (unsigned char)(n - 1) )
+        BenchFail("FlashUserRead after interrupted write");
+    u = FlashUserRead();
+    u->data[0] = 0xA5;
+    if( FlashUserWrite( u ) != 1 || FlashUserRead()->data[0] != 0xA5 )
+        BenchFail("FlashUserWrite after interrupted write");
+
+    // power lost after the next page was erased, fill this page first
+    for(FlashUserScan();user_ring.next < FLASH_USER_RECORDS;FlashUserScan())
+        {
+        u = FlashUserRead();
+        u->data[0] = user_ring.next;
+        FlashUserWrite( u );
+        }
+    n = (user_ring.head + 1) % FLASH_USER_PAGES;
+    FLASH_ErasePage( FlashUserPageAddr( n ) );
+    FlashUserPageHeader( n, user_ring.seq + 1 );
+    FlashUserCacheInvalidate();
+    if( FlashUserRead()->data[0] != FLASH_USER_RECORDS - 1 || user_ring.page == n )
+        BenchFail("FlashUserRead after interrupted page change");
+    e0 = flash_sim_get_stats()->erases;
+    u = FlashUserRead();
+    u->data[0] = 0x5A;
+    if( FlashUserWrite( u ) != 1 || FlashUserRead()->data[0] != 0x5A || user_ring.page != n ||
+        flash_sim_get_stats()->erases != e0 )
+        BenchFail("FlashUserWrite after interrupted page change");
+
+    // parameters written before the ring, three records in the old page
+    BenchFormat();
+    for(n=0;n<3;n++)
+        {
+        memset( words, 0, sizeof(words) );
+        words[0] = 100 + n;
+        flash_sim_poke( FLASH_USER_PAGE_ADDR + n * 4, &zero, 4 );
+        flash_sim_poke( FLASH_USER_PAGE_ADDR + (FLASH_USER_INDEX_SIZE + n * FLASH_USER_SIZE) * 4, words, sizeof(words) );
+        }
+    FlashUserCacheInvalidate();
+    u = FlashUserRead();
+    if( u->offset != 2 || u->data[0] != 102 )
+        BenchFail("FlashUserRead old page");
+    u->data[0] = 103;
+    if( FlashUserWrite( u ) != 1 || u->offset != 3 || FlashUserRead()->data[0] != 103 ||
+        user_ring.page != (FLASH_USER_PAGE_ADDR - FLASH_USER_BASE_ADDR) / FLASH_USER_PAGE_BYTES )
+        BenchFail("FlashUserWrite old page");
+}
+
+#else
+/*-----------------------------------------------------------------------------*/
+/*  Keyed user parameters                                                      */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchUserKeys()
+{
+    static unsigned char image[FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES];
+    flash_user_stat st;
+    flash_user     *u;
+    unsigned char   val[FLASH_USER_KEY_MAX_LEN];
+    unsigned char   out[FLASH_USER_KEY_MAX_LEN];
+    unsigned char   before[FLASH_USER_SIZE * sizeof(uint32_t)];
+    unsigned char   after[FLASH_USER_SIZE * sizeof(uint32_t)];
+    bench_result    wr;
+    uint16_t        tag;
+    uint64_t        p0;
+    int             key, n, len, k, done, failed;
+
+    printf("\nFlashUserKeyWrite, %d keys, 20 with values of 1 to %d bytes\n", FLASH_USER_KEYS, FLASH_USER_KEY_MAX_LEN );
+    printf("%10s %10s %10s %10s %10s\n", "writes", "mean uS", "max uS", "prog/call", "erases");
+
+    BenchFormat();
+    BenchClear( &wr );
+
+    // values change in turn, the page fills and is compacted
+    for(n=0;n<400;n++)
+        {
+        key = n % 20;
+        len = 1 + (key * 7) % FLASH_USER_KEY_MAX_LEN;
+        BenchFill( val, len, n );
+
+        BenchStart();
+        if( FlashUserKeyWrite( key, val, len ) != 1 )
+            BenchFail("FlashUserKeyWrite");
+        BenchStop( &wr );
+
+        if( FlashUserKeyRead( key, out, sizeof(out) ) != len || memcmp( out, val, len ) != 0 )
+            BenchFail("FlashUserKeyRead");
+        }
+
+    printf("%10d %10.1f %10.1f %10.1f %10" PRIu64 "\n", wr.calls, BenchMean( &wr ), wr.t_max / 1000.0,
+        (double)wr.programs / wr.calls, wr.erases );
+
+    // every key has its newest value after a fresh scan
+    user_keys.valid = 0;
+    for(key=0;key<20;key++)
+        {
+        len = 1 + (key * 7) % FLASH_USER_KEY_MAX_LEN;
+        BenchFill( val, len, 380 + key );
+        if( FlashUserKeyRead( key, out, sizeof(out) ) != len || memcmp( out, val, len ) != 0 )
+            BenchFail("FlashUserKeyRead after scan");
+        }
+    if( FlashUserKeyRead( 25, out, sizeof(out) ) != -1 )
+        BenchFail("FlashUserKeyRead missing key");
+
+    // an unchanged value is not written
+    p0 = flash_sim_get_stats()->programs;
+    if( FlashUserKeyWrite( 19, val, 1 + (19 * 7) % FLASH_USER_KEY_MAX_LEN ) != 1 || flash_sim_get_stats()->programs != p0 )
+        BenchFail("FlashUserKeyWrite unchanged");
+
+    // power lost while writing an entry, only the tag was programmed
+    tag = (3 << 8) | 4;
+    flash_sim_poke( FlashUserPageAddr( user_keys.head ) + user_keys.next, &tag, 2 );
+    user_keys.valid = 0;
+    BenchFill( val, 1 + (3 * 7) % FLASH_USER_KEY_MAX_LEN, 383 );
+    if( FlashUserKeyRead( 3, out, sizeof(out) ) != 1 + (3 * 7) % FLASH_USER_KEY_MAX_LEN || memcmp( out, val, 22 ) != 0 )
+        BenchFail("FlashUserKeyRead after interrupted write");
+
+    // power lost while compacting, the new page has no magic number
+    n = (user_keys.head + 1) % FLASH_USER_PAGES;
+    FLASH_ErasePage( FlashUserPageAddr( n ) );
+    FLASH_ProgramWord( FlashUserPageAddr( n ), user_keys.seq + 1 );
+    user_keys.valid = 0;
+    if( FlashUserKeyRead( 3, out, sizeof(out) ) != 22 || user_keys.head == n )
+        BenchFail("FlashUserKeyRead after interrupted compaction");
+
+    // parameter words are keys, one changed word is one small entry
+    printf("\nFlashUserWrite keyed, 112 writes of data[0]\n");
+    printf("%10s %10s %10s %10s\n", "mean uS", "max uS", "prog/call", "erases");
+
+    BenchFormat();
+    BenchClear( &wr );
+    for(n=0;n<112;n++)
+        {
+        u = FlashUserRead();
+        u->data[0] = n;
+        u->data[8] = 0x42;
+
+        BenchStart();
+        if( FlashUserWrite( u ) != 1 )
+            BenchFail("FlashUserWrite keyed");
+        BenchStop( &wr );
+
+        u = FlashUserRead();
+        if( u->data[0] != n || u->data[8] != 0x42 || u->data[1] != 0xFF || u->data[31] != 0xFF )
+            BenchFail("FlashUserRead keyed");
+        }
+    printf("%10.1f %10.1f %10.1f %10" PRIu64 "\n", BenchMean( &wr ), wr.t_max / 1000.0,
+        (double)wr.programs / wr.calls, wr.erases );
+
+    FlashUserStat( &st );
+    printf("   FlashUserStat %d of %d bytes free, %ld erases, %ld per page\n", st.free, st.size, st.erases, st.wear );
+    if( st.erases != (long)wr.erases || st.used != user_keys.next - FLASH_USER_KEY_HEADER || st.used + st.free != st.size )
+        BenchFail("FlashUserStat keyed");
+
+    // power lost while every word changes, all of them change or none do
+    flash_sim_peek( FlashUserPageAddr( 0 ), image, sizeof(image) );
+    failed = 0;
+    done   = 0;
+    for(k=0;k<30;k++)
+        {
+        flash_sim_poke( FlashUserPageAddr( 0 ), image, sizeof(image) );
+        user_keys.valid = 0;
+
+        u = FlashUserRead();
+        memcpy( before, u->data, sizeof(before) );
+        for(n=0;n<(int)sizeof(before);n++)
+            u->data[n] = before[n] + 1;
+        memcpy( after, u->data, sizeof(after) );
+
+        flash_sim_power_fail( k );
+        FlashUserWrite( u );
+        flash_sim_power_fail( -1 );
+        flash_sim_reset();
+        user_keys.valid = 0;
+
+        u = FlashUserRead();
+        if( memcmp( u->data, after, sizeof(after) ) == 0 )
+            done++;
+        else
+        if( memcmp( u->data, before, sizeof(before) ) != 0 )
+            failed++;
+        }
+    printf("power lost at %d points in a write of every word, %d not all or nothing\n", k, failed );
+    if( failed || done == 0 )
+        BenchFail("FlashUserWrite keyed after power loss");
+
+    // writes that change nothing do not count towards FLASH_USER_MAX_WRITE
+    for(n=0;n<FLASH_USER_MAX_WRITE;n++)
+        {
+        if( FlashUserKeyWrite( 0, u->data, sizeof(uint32_t) ) != 1 )
+            break;
+        }
+    val[0] = 0x5A;
+    if( n != FLASH_USER_MAX_WRITE || FlashUserKeyWrite( 25, val, 1 ) != 1 )
+        BenchFail("unchanged FlashUserKeyWrite counted");
+}
+#endif
+
+/*-----------------------------------------------------------------------------*/
+/*  RCFS_ExportAll and FlashUserExport against FlashUserDebug                  */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchExport( const char *capture )
+{
+    static unsigned char buf[2048];
+    rcfs_stat       st;
+    flash_file      f;
+    unsigned char   v;
+    FILE           *fp;
+    char            line[256];
+    char            name[16];
+    uint64_t        t0;
+    double          t_all, t_user, t_debug;
+    long            frames, chars;
+    int             i, n, lines, longest;
+
+    printf("\nRCFS_ExportAll, 16 files of %d bytes, then the user pages\n", (int)sizeof(buf) );
+    printf("%12s %8s %8s %8s %10s %8s %8s\n", "", "bytes", "frames", "chars", "mS", "KB/s", "waits");
+
+    BenchFormat();
+    for(i=0;i<16;i++)
+        {
+        BenchFill( buf, sizeof(buf), i );
+        sprintf( name, "e%03d", i );
+        RCFS_AddFile( buf, sizeof(buf), name );
+        }
+
+    RCFS_Stat( &st );
+
+    fp = (capture != NULL) ? fopen( capture, "w+" ) : tmpfile();
+    if( fp == NULL )
+        {
+        BenchFail("export capture");
+        return;
+        }
+    robotc_debug_capture = fp;
+
+    t0 = flash_sim_time_ns();
+    if( RCFS_ExportAll() != st.files )
+        BenchFail("RCFS_ExportAll");
+    t_all = (flash_sim_time_ns() - t0) / 1e6;
+    frames = xfer.frames;
+    chars  = xfer.chars;
+
+    printf("%12s %8ld %8ld %8ld %10.1f %8.2f %8ld\n", "files", xfer.bytes, xfer.frames, xfer.chars,
+        t_all, xfer.bytes / t_all, xfer.waits );
+
+    // never more than the buffer ahead of the PC
+    if( xfer.chars > RCFS_EXPORT_BUFFER + (long)(t_all * RCFS_EXPORT_RATE) + RCFS_EXPORT_LINE )
+        BenchFail("export rate");
+
+    t0 = flash_sim_time_ns();
+    if( FlashUserExport() != FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES )
+        BenchFail("FlashUserExport");
+    t_user = (flash_sim_time_ns() - t0) / 1e6;
+    frames += xfer.frames;
+    chars  += xfer.chars;
+
+    printf("%12s %8d %8ld %8ld %10.1f %8.2f %8ld\n", "user", FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES, xfer.frames,
+        xfer.chars, t_user, FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES / t_user, xfer.waits );
+
+    robotc_debug_capture = NULL;
+
+    // the hex dump for comparison
+    t0 = flash_sim_time_ns();
+    FlashUserDebug();
+    t_debug = (flash_sim_time_ns() - t0) / 1e6;
+    printf("%12s %8d %8s %8s %10.1f %8.2f\n", "FlashUserDebug", FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES, "", "",
+        t_debug, FLASH_USER_PAGE_BYTES * FLASH_USER_PAGES / t_debug );
+
+    // one line for each frame
+    rewind( fp );
+    lines = longest = 0;
+    while( fgets( line, sizeof(line), fp ) != NULL )
+        {
+        n = strlen( line );
+        if( line[0] == ':' )
+            lines++;
+        if( n > longest )
+            longest = n;
+        }
+    fclose( fp );
+
+    if( lines != frames || longest > RCFS_EXPORT_LINE )
+        BenchFail("export lines");
+
+#ifdef RCFS_COMPRESS
+    // compressed files are sent as the original data
+    for(i=0;i<(int)sizeof(buf);i++)
+        buf[i] = "the quick brown fox "[i % 20];
+    RCFS_SetCompression( 1 );
+    RCFS_AddFile( buf, sizeof(buf), "lz" );
+    RCFS_SetCompression( 0 );
+    if( RCFS_ExportFile( "lz" ) != (long)sizeof(buf) )
+        BenchFail("RCFS_ExportFile compressed");
+#endif
+
+    // a damaged file ends with a length the receiver rejects
+    RCFS_FindFile( "e003", &f );
+    flash_sim_peek( (uint32_t)(uintptr_t)f.data + 10, &v, 1 );
+    v ^= 0x55;
+    flash_sim_poke( (uint32_t)(uintptr_t)f.data + 10, &v, 1 );
+    if( RCFS_ExportFile( "e003" ) != RCFS_ERROR || xfer.failed != 1 )
+        BenchFail("RCFS_ExportFile damaged");
+    if( RCFS_ExportAll() != RCFS_ERROR || xfer.failed != 1 )
+        BenchFail("RCFS_ExportAll damaged");
+}
+
+#ifdef FLASH_TRACE
+/*-----------------------------------------------------------------------------*/
+/*  FLASH_TRACE counts and histograms against the simulator                    */
+/*-----------------------------------------------------------------------------*/
+
+static void
+BenchTrace()
+{
+    static unsigned char buf[4096];
+    static const char   *names[FLASH_TRACE_OPS] = { "halfword", "word", "buffer", "erase", "wait" };
+    flash_trace    *t;
+    unsigned long   sum;
+    char            name[16];
+    int             i, b, op;
+
+    printf("\nFLASH_TRACE, 8 files of %d bytes, a user write and a failed program\n", (int)sizeof(buf) );
+    printf("%10s %8s %8s %8s %8s %8s  %s\n", "", "count", "errors", "min uS", "max uS", "mean uS", "histogram, uS:count");
+
+    BenchFormat();
+    FLASH_TraceClear();
+    flash_sim_clear_stats();
+
+    for(i=0;i<8;i++)
+        {
+        BenchFill( buf, sizeof(buf), i );
+        sprintf( name, "t%03d", i );
+        RCFS_AddFile( buf, sizeof(buf), name );
+        }
+    RCFS_DeleteFile( "t001" );
+#ifdef RCFS_COMPACT
+    RCFS_Compact();
+#endif
+    FlashUserWrite( FlashUserRead() );
+
+    // the first half word of the file system is programmed
+    FLASH_UnlockBank1();
+    FLASH_ProgramHalfWord( kStartOfFileSystem + RCFS_DATA_OFFSET, 0x1234 );
+
+    for(op=0;op<FLASH_TRACE_OPS;op++)
+        {
+        t = &flash_trace_ops[op];
+        printf("%10s %8lu %8lu %8ld %8ld %8lu ", names[op], (unsigned long)t->count, (unsigned long)t->errors,
+            (long)t->min, (long)t->max, t->count ? (unsigned long)(t->total / t->count) : 0ul );
+
+        sum = 0;
+        for(b=0;b<FLASH_TRACE_BUCKETS;b++)
+            {
+            if( t->hist[b] )
+                printf(" %d:%lu", b ? (1 << b) : 0, (unsigned long)t->hist[b] );
+            sum += t->hist[b];
+            }
+        printf("\n");
+
+        if( sum != t->count )
+            BenchFail("FLASH_TRACE histogram");
+        }
+
+    if( flash_trace_ops[FLASH_TRACE_ERASE].count != flash_sim_get_stats()->erases )
+        BenchFail("FLASH_TRACE erases");
+    if( flash_trace_ops[FLASH_TRACE_HALFWORD].errors != 1 ||
+        flash_trace_ops[FLASH_TRACE_HALFWORD].last_error != FLASH_ERROR_PG )
+        BenchFail("FLASH_TRACE errors");
+    if( flash_trace_ops[FLASH_TRACE_ERASE].count &&
+        flash_trace_ops[FLASH_TRACE_ERASE].min < (int)(flash_sim_get_timing()->t_erase / 1000) )
+        BenchFail("FLASH_TRACE erase time");
+}
+#endif
+
+/*-----------------------------------------------------------------------------*/
+/*  Run all benchmarks                                                         */
+/*-----------------------------------------------------------------------------*/
+
+int
+main( int argc, char **argv )
+{
+    char           *image = NULL;
+    char           *capture = NULL;
+    struct timespec t0, t1;
+    int             c;
+
+    while( (c = getopt( argc, argv, "vi:e:" )) != -1 )
+        {
+        switch( c )
+            {
+            case 'v':
+                robotc_debug_enable = 1;
+                break;
+            case 'i':
+                image = optarg;
+                break;
+            case 'e':
+                capture = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-v] [-i flash_image] [-e export_capture]\n", argv[0] );
+                return(2);
+            }
+        }
+
+    if( flash_sim_init( image ) != 0 )
+        return(2);
+
+    printf("Simulated STM32F103 flash, program %.1f uS, erase %.1f mS\n",
+        flash_sim_get_timing()->t_prog / 1000.0, flash_sim_get_timing()->t_erase / 1000000.0 );
+#ifdef FLASH_TRACE
+    printf("FLASH_TRACE enabled\n");
+#endif
+#ifdef RCFS_VTOC_CACHE
+    printf("RCFS VTOC cache enabled\n");
+#else
+    printf("RCFS VTOC cache disabled\n");
+#endif
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+
+    BenchAddFile();
+    BenchGetFile();
+    BenchRead();
+    BenchStream();
+    BenchVerify();
+    BenchWriteError();
+    BenchCommit();
+    BenchLayout();
+    BenchStat();
+#ifdef RCFS_COMPRESS
+    BenchCompress();
+#endif
+#ifdef RCFS_COMPACT
+    BenchCompact();
+#endif
+    BenchLog();
+    BenchTelem();
+    BenchReplay();
+    BenchRing();
+    BenchQueue();
+    BenchWait();
+    BenchMutex();
+#ifndef FLASH_USER_KEYED
+    BenchUser();
+    BenchUserRing();
+#else
+    BenchUserKeys();
+#endif
+    BenchExport( capture );
+#ifdef FLASH_TRACE
+    BenchTrace();
+#endif
+
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+    printf("\n%s, %.2f S host time\n", bench_errors ? "ERRORS" : "OK",
+        (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9 );
+
+    flash_sim_close();
+
+    return( bench_errors ? 1 : 0 );
+}
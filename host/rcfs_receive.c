@@ -0,0 +1,389 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     rcfs_receive.c                                               */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Report read errors                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Rebuild files sent by flash_export.c from a capture of the debug     */
+/*        stream, such as the debug window saved to a file.                    */
+/*                                                                             */
+/*          rcfs_receive -l capture           list and check the files         */
+/*          rcfs_receive [-d dir] capture     write the files to dir           */
+/*                                                                             */
+/*        With no capture file stdin is read.  A file with a bad CRC or        */
+/*        lost frames is written with .bad added to the name, the exit         */
+/*        status is 1 if any file was not received.                            */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define FRAME_MAX           256
+#define EXPORT_VERSION      1
+
+static  const char *outdir = ".";
+static  int         list   = 0;
+
+/*-----------------------------------------------------------------------------*/
+/*  Same CRC32 as zlib                                                         */
+/*-----------------------------------------------------------------------------*/
+
+static uint32_t
+Crc32( uint32_t crc, const uint8_t *data, uint32_t length )
+{
+    uint32_t    i;
+    int         k;
+
+    for(i=0;i<length;i++)
+        {
+        crc ^= data[i];
+        for(k=0;k<8;k++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+
+    return(crc);
+}
+
+static uint32_t
+Long( const uint8_t *p )
+{
+    return( p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Decode the base64 after the ':', returns the number of bytes or -1         */
+/*-----------------------------------------------------------------------------*/
+
+static int
+Base64Value( int c )
+{
+    if( c >= 'A' && c <= 'Z' ) return( c - 'A' );
+    if( c >= 'a' && c <= 'z' ) return( c - 'a' + 26 );
+    if( c >= '0' && c <= '9' ) return( c - '0' + 52 );
+    if( c == '+' )             return( 62 );
+    if( c == '/' )             return( 63 );
+
+    return(-1);
+}
+
+static int
+Base64Decode( const char *s, uint8_t *out, int max )
+{
+    uint32_t    v = 0;
+    int         bits = 0;
+    int         n = 0;
+    int         d;
+
+    for( ;*s && *s != '=' && *s != '\r' && *s != '\n';s++)
+        {
+        if( (d = Base64Value( *s )) < 0 )
+            return(-1);
+
+        v = (v << 6) | d;
+        bits += 6;
+        if( bits >= 8 )
+            {
+            bits -= 8;
+            if( n >= max )
+                return(-1);
+            out[n++] = (v >> bits) & 0xFF;
+            }
+        }
+
+    return(n);
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  The file being received                                                    */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _rx_file {
+    int             open;
+    int             damaged;            // frames were lost or out of order
+    char            name[20];
+    int             type;
+    uint8_t        *data;
+    uint32_t        size;               // bytes allocated
+    uint32_t        next;               // offset of the next data frame
+    } rx_file;
+
+static  rx_file     rx;
+static  int         files_ok, files_bad;
+
+static void
+FileWrite( const char *suffix )
+{
+    char        path[1024];
+    FILE       *fp;
+
+    snprintf( path, sizeof(path), "%s/%s%s", outdir, rx.name, suffix );
+    if( (fp = fopen( path, "wb" )) == NULL )
+        {
+        perror( path );
+        return;
+        }
+    if( rx.next && fwrite( rx.data, 1, rx.next, fp ) != rx.next )
+        perror( path );
+    fclose( fp );
+}
+
+static void
+FileEnd( int closed, uint32_t length, uint32_t crc )
+{
+    const char *status = "ok";
+
+    if( !rx.open )
+        return;
+
+    if( !closed )
+        status = "not finished";
+    else
+    if( length == 0xFFFFFFFF )
+        status = "read error";
+    else
+    if( rx.damaged || length != rx.next )
+        status = "frames lost";
+    else
+    if( Crc32( 0xFFFFFFFF, rx.data, rx.next ) != ~crc )
+        status = "bad CRC";
+
+    printf("%-16s %3d %8u  %s\n", rx.name, rx.type, rx.next, status );
+
+    if( strcmp( status, "ok" ) == 0 )
+        {
+        files_ok++;
+        if( !list )
+            FileWrite( "" );
+        }
+    else
+        {
+        files_bad++;
+        if( !list )
+            FileWrite( ".bad" );
+        }
+
+    rx.open = 0;
+}
+
+static void
+FileStart( const uint8_t *p, int n )
+{
+    int     i;
+
+    FileEnd( 0, 0, 0 );
+
+    rx.open    = 1;
+    rx.damaged = 0;
+    rx.next    = 0;
+    rx.type    = p[0];
+
+    // names from the robot are not trusted as paths
+    memset( rx.name, 0, sizeof(rx.name) );
+    for(i=1;i<n && i<=16;i++)
+        rx.name[i-1] = (p[i] > ' ' && p[i] < 0x7F && p[i] != '/') ? p[i] : '_';
+    if( rx.name[0] == 0 || rx.name[0] == '.' )
+        rx.name[0] = '_';
+}
+
+static void
+FileData( const uint8_t *p, int n )
+{
+    uint32_t    offset = Long( p );
+
+    if( !rx.open )
+        return;
+
+    // a frame was lost, offsets must follow on
+    if( offset != rx.next )
+        {
+        rx.damaged = 1;
+        return;
+        }
+
+    n -= 4;
+    if( rx.next + n > rx.size )
+        {
+        rx.size = (rx.size ? rx.size * 2 : 4096) + n;
+        rx.data = realloc( rx.data, rx.size );
+        if( rx.data == NULL )
+            {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+            }
+        }
+
+    memcpy( rx.data + rx.next, p + 4, n );
+    rx.next += n;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Check a frame and pass it on                                               */
+/*-----------------------------------------------------------------------------*/
+
+static  int         expect = -1;
+static  long        frames, bad, lost;
+
+static void
+Frame( const uint8_t *f, int n )
+{
+    int     seq, len;
+
+    if( n < 8 )
+        {
+        bad++;
+        return;
+        }
+
+    len = f[3];
+    if( len != n - 8 || Crc32( 0xFFFFFFFF, f, n - 4 ) != ~Long( f + n - 4 ) )
+        {
+        bad++;
+        if( rx.open )
+            rx.damaged = 1;
+        return;
+        }
+
+    frames++;
+    seq = f[1] | (f[2] << 8);
+
+    if( f[0] == 'B' )
+        {
+        if( f[4] != EXPORT_VERSION )
+            fprintf(stderr, "export version %d, expected %d\n", f[4], EXPORT_VERSION );
+        FileEnd( 0, 0, 0 );
+        }
+    else
+    if( expect >= 0 && seq != expect )
+        {
+        lost += (seq - expect) & 0xFFFF;
+        if( rx.open )
+            rx.damaged = 1;
+        }
+    expect = (seq + 1) & 0xFFFF;
+
+    switch( f[0] )
+        {
+        case 'F':
+            if( len >= 1 )
+                FileStart( f + 4, len );
+            break;
+        case 'D':
+            if( len >= 4 )
+                FileData( f + 4, len );
+            break;
+        case 'C':
+            if( len == 8 )
+                FileEnd( 1, Long( f + 4 ), Long( f + 8 ) );
+            break;
+        case 'E':
+            FileEnd( 0, 0, 0 );
+            expect = -1;
+            break;
+        }
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Read the capture                                                           */
+/*-----------------------------------------------------------------------------*/
+
+static void
+Usage( char *prog )
+{
+    fprintf(stderr, "usage: %s [-l] [-d dir] [capture]\n", prog );
+    exit(2);
+}
+
+int
+main( int argc, char **argv )
+{
+    uint8_t     f[FRAME_MAX];
+    char        line[1024];
+    char       *p;
+    FILE       *fp = stdin;
+    int         c, n;
+
+    while( (c = getopt( argc, argv, "ld:" )) != -1 )
+        {
+        switch( c )
+            {
+            case 'l':
+                list = 1;
+                break;
+            case 'd':
+                outdir = optarg;
+                break;
+            default:
+                Usage( argv[0] );
+            }
+        }
+
+    if( optind + 1 < argc )
+        Usage( argv[0] );
+    if( optind < argc && strcmp( argv[optind], "-" ) != 0 )
+        {
+        if( (fp = fopen( argv[optind], "r" )) == NULL )
+            {
+            perror( argv[optind] );
+            return(1);
+            }
+        }
+
+    while( fgets( line, sizeof(line), fp ) != NULL )
+        {
+        // other debug output is skipped
+        for(p=line;*p == ' ' || *p == '\t';p++)
+            ;
+        if( *p != ':' )
+            continue;
+
+        if( (n = Base64Decode( p + 1, f, sizeof(f) )) < 0 )
+            {
+            bad++;
+            continue;
+            }
+        Frame( f, n );
+        }
+
+    FileEnd( 0, 0, 0 );
+
+    fprintf(stderr, "%d files, %d damaged, %ld frames, %ld bad, %ld lost\n",
+        files_ok + files_bad, files_bad, frames, bad, lost );
+
+    return( (files_bad || bad || lost) ? 1 : 0 );
+}
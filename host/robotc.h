@@ -0,0 +1,139 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     robotc.h                                                     */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Add task and priority stubs           */
+/*                V1.02    17 Oct 2026 - Capture the debug stream to a file    */
+/*                V1.03    17 Oct 2026 - Add FLASH_TRACE_CLOCK                 */
+/*                V1.04    17 Oct 2026 - Add a yield hook for a second task    */
+/*                V1.05    17 Oct 2026 - Track hogCPU                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        The parts of the ROBOTC runtime used by the flash library, for       */
+/*        building on a linux host.  Time is the simulator's virtual clock.    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#ifndef __ROBOTC_HOST__
+#define __ROBOTC_HOST__
+
+// All system headers must come before long is redefined
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "flash_sim.h"
+
+// Debug stream goes to stderr when enabled, and to a capture file if one
+// is open so it can be given to rcfs_receive
+static  int     robotc_debug_enable = 0;
+static  FILE   *robotc_debug_capture = NULL;
+
+static void
+robotc_debug( int newline, const char *fmt, ... )
+{
+    va_list args;
+
+    if( robotc_debug_capture != NULL )
+        {
+        va_start( args, fmt );
+        vfprintf( robotc_debug_capture, fmt, args );
+        va_end( args );
+
+        if( newline )
+            fputc( '\n', robotc_debug_capture );
+        }
+
+    if( !robotc_debug_enable )
+        return;
+
+    va_start( args, fmt );
+    vfprintf( stderr, fmt, args );
+    va_end( args );
+
+    if( newline )
+        fputc( '\n', stderr );
+}
+
+#define writeDebugStream(...)       robotc_debug( 0, __VA_ARGS__ )
+#define writeDebugStreamLine(...)   robotc_debug( 1, __VA_ARGS__ )
+
+// A test can set a hook to stand in for another task, it is called where
+// ROBOTC could switch tasks but not from inside itself or while the CPU
+// is held.  hogCPU does not nest, one releaseCPU ends it.
+static  void  (*robotc_yield_hook)( void ) = NULL;
+static  int     robotc_hog = 0;
+
+static void
+robotc_yield( void )
+{
+    static int  running = 0;
+
+    if( robotc_yield_hook == NULL || running || robotc_hog )
+        return;
+
+    running = 1;
+    robotc_yield_hook();
+    running = 0;
+}
+
+// Timing, a yield costs nothing
+#define wait1Msec(ms)               (flash_sim_advance_ns( (uint64_t)(ms) * 1000000 ), robotc_yield())
+#define wait10Msec(ms)              (flash_sim_advance_ns( (uint64_t)(ms) * 10000000 ), robotc_yield())
+#define abortTimeslice()            robotc_yield()
+#define nSysTime                    ((uint32_t)(flash_sim_time_ns() / 1000000))
+#define nPgmTime                    nSysTime
+
+// uS clock for FLASH_TRACE, the cortex reads SysTick
+#define FLASH_TRACE_CLOCK()         ((long)(flash_sim_time_ns() / 1000))
+
+// Tasks, there is only one so the scheduler calls are empty and code
+// that would run in another task has to be called directly
+#define task                        void
+#define kLowPriority                0
+#define kDefaultTaskPriority        7
+#define kHighPriority               255
+#define startTask(name, ...)        ((void)0)
+#define StartTask(name, ...)        ((void)0)
+#define hogCPU()                    ((void)(robotc_hog = 1))
+#define releaseCPU()                ((void)(robotc_hog = 0))
+
+// ROBOTC long is 32 bits
+#define long                        int
+
+#endif  // __ROBOTC_HOST__
@@ -0,0 +1,328 @@
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                   2026                                      */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     telem_decode.c                                               */
+/*    Author:     James Pearman                                                */
+/*    Created:    17 Oct 2026                                                  */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00    17 Oct 2026 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Skip entries cleared by RCFS_Compact  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        Decode telemetry files written by flash_telem.c to CSV               */
+/*                                                                             */
+/*        The input is a dump of the cortex flash starting at 0x08000000,      */
+/*        such as the image used by rcfs_bench, or starting at the address     */
+/*        given with -b.  The RCFS VTOC is read to find the files.             */
+/*                                                                             */
+/*          telem_decode -l image             list telemetry files             */
+/*          telem_decode image [name]         write a file as CSV to stdout    */
+/*                                                                             */
+/*        With no name the last telemetry file is decoded.                     */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+// Start of the RCFS file system and the VTOC for V4 firmware
+#define FS_START            0x08018000
+#define VTOC_OFFSET         160
+#define FILE_HEADER_SIZE    24
+
+#define TELEM_MAX_FIELDS    255
+
+static  uint8_t    *image;
+static  uint32_t    image_base = 0x08000000;
+static  uint32_t    image_size;
+
+/*-----------------------------------------------------------------------------*/
+/*  Image access, out of range reads are erased flash                          */
+/*-----------------------------------------------------------------------------*/
+
+static uint8_t
+ImageByte( uint32_t addr )
+{
+    if( (addr < image_base) || (addr - image_base >= image_size) )
+        return(0xFF);
+
+    return( image[addr - image_base] );
+}
+
+static uint32_t
+ImageWord( uint32_t addr )
+{
+    return( ImageByte(addr) | (ImageByte(addr+1) << 8) | (ImageByte(addr+2) << 16) | ((uint32_t)ImageByte(addr+3) << 24) );
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  A telemetry file                                                           */
+/*-----------------------------------------------------------------------------*/
+
+typedef struct _telem_file {
+    char            name[16];
+    uint32_t        data;               // address of the data
+    uint32_t        length;             // bytes of data
+    int             fields;
+    uint8_t         id[TELEM_MAX_FIELDS];
+    uint8_t         type[TELEM_MAX_FIELDS];
+    int8_t          scale[TELEM_MAX_FIELDS];
+    } telem_file;
+
+// Read VTOC entry n, returns 0 at the end of the table, -1 if it is not
+// a telemetry file
+static int
+TelemFile( int n, telem_file *t )
+{
+    uint32_t    toc = FS_START + VTOC_OFFSET + (n * 8);
+    uint32_t    addr = ImageWord( toc );
+    uint32_t    size = ImageWord( toc + 4 );
+    uint32_t    next, p;
+    int         i;
+
+    if( addr == 0xFFFFFFFF )
+        return(0);
+
+    // cleared by RCFS_Compact
+    if( addr == 0 )
+        return(-1);
+
+    memset( t, 0, sizeof(telem_file) );
+    for(i=0;i<15;i++)
+        t->name[i] = ImageByte( FS_START + addr + i );
+
+    // deleted
+    if( t->name[0] == 0 && t->name[1] == 0 )
+        return(-1);
+
+    t->data = FS_START + addr + FILE_HEADER_SIZE;
+
+    // not closed, the data ends before the next file or the erased flash
+    if( size == 0xFFFFFFFF )
+        {
+        next = ImageWord( toc + 8 );
+        if( next == 0xFFFFFFFF )
+            next = image_base + image_size - FS_START;
+        for(p=FS_START + next;(p > t->data) && (ImageByte(p-1) == 0xFF);p--)
+            ;
+        size = p - t->data + FILE_HEADER_SIZE;
+        }
+    if( size < FILE_HEADER_SIZE + 4 )
+        return(-1);
+    t->length = size - FILE_HEADER_SIZE;
+
+    if( ImageByte( t->data ) != 'R' || ImageByte( t->data + 1 ) != 'T' || ImageByte( t->data + 2 ) != 1 )
+        return(-1);
+
+    t->fields = ImageByte( t->data + 3 );
+    if( t->fields == 0 || t->length < 4 + 4 * (uint32_t)t->fields )
+        return(-1);
+
+    for(i=0;i<t->fields;i++)
+        {
+        t->id[i]    = ImageByte( t->data + 4 + i*4 );
+        t->type[i]  = ImageByte( t->data + 5 + i*4 );
+        t->scale[i] = (int8_t)ImageByte( t->data + 6 + i*4 );
+        }
+
+    return(1);
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Decode the samples                                                         */
+/*-----------------------------------------------------------------------------*/
+
+static void
+TelemValue( int64_t v, int scale )
+{
+    double  d = (double)v;
+    int     i;
+
+    if( scale >= 0 )
+        {
+        for(i=0;i<scale;i++)
+            v *= 10;
+        printf("%" PRId64, v );
+        }
+    else
+        {
+        for(i=0;i<-scale;i++)
+            d /= 10;
+        printf("%.*f", -scale, d );
+        }
+}
+
+static int
+TelemDecode( telem_file *t )
+{
+    int32_t     last[TELEM_MAX_FIELDS];
+    int32_t     v[TELEM_MAX_FIELDS];
+    uint32_t    p   = t->data + 4 + 4 * t->fields;
+    uint32_t    end = t->data + t->length;
+    uint32_t    u;
+    int         shift;
+    int         samples = 0;
+    int         i;
+
+    printf("sample");
+    for(i=0;i<t->fields;i++)
+        printf(",f%d", t->id[i] );
+    printf("\n");
+
+    memset( last, 0, sizeof(last) );
+
+    while( p < end )
+        {
+        for(i=0;i<t->fields;i++)
+            {
+            u = 0;
+            shift = 0;
+            while( p < end && (ImageByte(p) & 0x80) && shift < 28 )
+                {
+                u |= (uint32_t)(ImageByte(p++) & 0x7F) << shift;
+                shift += 7;
+                }
+            // sample cut short
+            if( p >= end )
+                return(samples);
+            u |= (uint32_t)ImageByte(p++) << shift;
+
+            // zigzag
+            v[i] = (int32_t)((u >> 1) ^ (0 - (u & 1)));
+            if( t->type[i] == 1 )
+                v[i] += last[i];
+            }
+
+        printf("%d", samples );
+        for(i=0;i<t->fields;i++)
+            {
+            printf(",");
+            TelemValue( v[i], t->scale[i] );
+            last[i] = v[i];
+            }
+        printf("\n");
+        samples++;
+        }
+
+    return(samples);
+}
+
+/*-----------------------------------------------------------------------------*/
+/*  Read the image and decode or list files                                    */
+/*-----------------------------------------------------------------------------*/
+
+static void
+Usage( char *prog )
+{
+    fprintf(stderr, "usage: %s [-l] [-b base_address] flash_image [name]\n", prog );
+    exit(2);
+}
+
+int
+main( int argc, char **argv )
+{
+    telem_file  t, found;
+    FILE       *fp;
+    long        size;
+    int         list = 0;
+    int         have = 0;
+    int         c, n, ret;
+    char       *name = NULL;
+
+    while( (c = getopt( argc, argv, "lb:" )) != -1 )
+        {
+        switch( c )
+            {
+            case 'l':
+                list = 1;
+                break;
+            case 'b':
+                image_base = strtoul( optarg, NULL, 0 );
+                break;
+            default:
+                Usage( argv[0] );
+            }
+        }
+
+    if( optind >= argc )
+        Usage( argv[0] );
+    if( optind + 1 < argc )
+        name = argv[optind + 1];
+
+    if( (fp = fopen( argv[optind], "rb" )) == NULL )
+        {
+        perror( argv[optind] );
+        return(1);
+        }
+    fseek( fp, 0, SEEK_END );
+    size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+    image = malloc( size );
+    if( image == NULL || fread( image, 1, size, fp ) != (size_t)size )
+        {
+        fprintf(stderr, "%s: read failed\n", argv[optind] );
+        return(1);
+        }
+    fclose( fp );
+    image_size = size;
+
+    for(n=0;(ret = TelemFile( n, &t )) != 0;n++)
+        {
+        if( ret < 0 )
+            continue;
+
+        if( list )
+            printf("%-16s %3d fields %6u bytes\n", t.name, t.fields, t.length );
+
+        if( name == NULL || strcmp( name, t.name ) == 0 )
+            {
+            found = t;
+            have  = 1;
+            }
+        }
+
+    if( list )
+        return(0);
+
+    if( !have )
+        {
+        fprintf(stderr, "no telemetry file%s%s\n", name ? " " : "", name ? name : "" );
+        return(1);
+        }
+
+    n = TelemDecode( &found );
+    fprintf(stderr, "%s, %d samples\n", found.name, n );
+
+    return(0);
+}
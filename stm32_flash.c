@@ -1,396 +1,887 @@
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*                        Copyright (c) James Pearman                          */
-/*                                 2012-2014                                   */
-/*                            All Rights Reserved                              */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    Module:     stm32_flash.c                                                */
-/*    Author:     James Pearman                                                */
-/*    Created:    21 August 2012                                               */
-/*                                                                             */
-/*    Revisions:                                                               */
-/*                V1.00     7 Jan 2014 - Initial release                       */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*    The author is supplying this software for use with the VEX cortex        */
-/*    control system. this is free software; you can redistribute it           */
-/*    and/or modify it under the terms of the GNU General Public License       */
-/*    as published by the Free Software Foundation; either version 3 of        */
-/*    the License, or (at your option) any later version.                      */
-/*                                                                             */
-/*    This software is distributed in the hope that it will be useful,         */
-/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
-/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
-/*    GNU General Public License for more details.                             */
-/*                                                                             */
-/*    You should have received a copy of the GNU General Public License        */
-/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
-/*                                                                             */
-/*    The author can be contacted on the vex forums as jpearman                */
-/*    or electronic mail using jbpearman_at_mac_dot_com                        */
-/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-/*                                                                             */
-/*        Description:                                                         */
-/*                                                                             */
-/*        ROBOTC port of stm32 peripheral library                              */
-/*                                                                             */
-/*-----------------------------------------------------------------------------*/
-
-typedef unsigned long  uint32_t;
-typedef unsigned short uint16_t;
-
-typedef struct
-{
-    uint32_t ACR;
-    uint32_t KEYR;
-    uint32_t OPTKEYR;
-    uint32_t SR;
-    uint32_t CR;
-    uint32_t AR;
-    uint32_t RESERVED;
-    uint32_t OBR;
-    uint32_t WRPR;
-} FLASH_TypeDef;
-
-#define FLASH_BASE                  (0x08000000)        /*!< FLASH base address in the alias region */
-#define SRAM_BASE                   (0x20000000)        /*!< SRAM base address in the alias region */
-#define PERIPH_BASE                 (0x40000000)        /*!< Peripheral base address in the alias region */
-#define APB1PERIPH_BASE             PERIPH_BASE
-#define APB2PERIPH_BASE             (PERIPH_BASE + 0x10000)
-#define AHBPERIPH_BASE              (PERIPH_BASE + 0x20000)
-#define FLASH_R_BASE                (AHBPERIPH_BASE + 0x2000) /*!< Flash registers base address */
-#define FLASH                       ((FLASH_TypeDef *) FLASH_R_BASE)
-
-#define FLASH_FLAG_BSY              (0x00000001)        /*!< FLASH Busy flag */
-#define FLASH_FLAG_EOP              (0x00000020)        /*!< FLASH End of Operation flag */
-#define FLASH_FLAG_PGERR            (0x00000004)        /*!< FLASH Program error flag */
-#define FLASH_FLAG_WRPRTERR         (0x00000010)        /*!< FLASH Write protected error flag */
-#define FLASH_FLAG_OPTERR           (0x00000001)        /*!< FLASH Option Byte error flag */
-
-#define FLASH_FLAG_BANK1_BSY        FLASH_FLAG_BSY      /*!< FLASH BANK1 Busy flag*/
-#define FLASH_FLAG_BANK1_EOP        FLASH_FLAG_EOP      /*!< FLASH BANK1 End of Operation flag */
-#define FLASH_FLAG_BANK1_PGERR      FLASH_FLAG_PGERR    /*!< FLASH BANK1 Program error flag */
-#define FLASH_FLAG_BANK1_WRPRTERR   FLASH_FLAG_WRPRTERR /*!< FLASH BANK1 Write protected error flag */
-
-#define IS_FLASH_CLEAR_FLAG(FLAG)   ((((FLAG) & (uint32_t)0xFFFFFFCA) == 0x00000000) && ((FLAG) != 0x00000000))
-#define IS_FLASH_GET_FLAG(FLAG)       ((FLAG) == FLASH_FLAG_BSY) || ((FLAG) == FLASH_FLAG_EOP) || \
-                                      ((FLAG) == FLASH_FLAG_PGERR) || ((FLAG) == FLASH_FLAG_WRPRTERR) || \
-								      ((FLAG) == FLASH_FLAG_BANK1_BSY) || ((FLAG) == FLASH_FLAG_BANK1_EOP) || \
-                                      ((FLAG) == FLASH_FLAG_BANK1_PGERR) || ((FLAG) == FLASH_FLAG_BANK1_WRPRTERR) || \
-                                      ((FLAG) == FLASH_FLAG_OPTERR))
-
-/** @defgroup FLASH_Private_Defines
-  * @{
-  */
-
-/* Flash Access Control Register bits */
-#define ACR_LATENCY_Mask            (0x00000038)
-#define ACR_HLFCYA_Mask             (0xFFFFFFF7)
-#define ACR_PRFTBE_Mask             (0xFFFFFFEF)
-
-/* Flash Access Control Register bits */
-#define ACR_PRFTBS_Mask             (0x00000020)
-
-/* Flash Control Register bits */
-#define CR_PG_Set                   (0x00000001)
-#define CR_PG_Reset                 (0x00001FFE)
-#define CR_PER_Set                  (0x00000002)
-#define CR_PER_Reset                (0x00001FFD)
-#define CR_MER_Set                  (0x00000004)
-#define CR_MER_Reset                (0x00001FFB)
-#define CR_OPTPG_Set                (0x00000010)
-#define CR_OPTPG_Reset              (0x00001FEF)
-#define CR_OPTER_Set                (0x00000020)
-#define CR_OPTER_Reset              (0x00001FDF)
-#define CR_STRT_Set                 (0x00000040)
-#define CR_LOCK_Set                 (0x00000080)
-
-/* FLASH Mask */
-#define RDPRT_Mask                  (0x00000002)
-#define WRP0_Mask                   (0x000000FF)
-#define WRP1_Mask                   (0x0000FF00)
-#define WRP2_Mask                   (0x00FF0000)
-#define WRP3_Mask                   (0xFF000000)
-#define OB_USER_BFB2                ((uint16_t)0x0008)
-
-/* FLASH Keys */
-#define RDP_Key                     ((uint16_t)0x00A5)
-#define FLASH_KEY1                  (0x45670123)
-#define FLASH_KEY2                  (0xCDEF89AB)
-
-/* FLASH BANK address */
-#define FLASH_BANK1_END_ADDRESS     (0x807FFFF)
-
-/* Delay definition */
-#define EraseTimeout                (0x000B0000)
-#define ProgramTimeout              (0x00002000)
-
-// V4 changed the way enums are handled
-#if kRobotCVersionNumeric < 400
-typedef enum
-#else
-typedef enum _FLASH_Status
-#endif
-{
-  FLASH_BUSY = 1,
-  FLASH_ERROR_PG,
-  FLASH_ERROR_WRP,
-  FLASH_COMPLETE,
-  FLASH_TIMEOUT
-}FLASH_Status;
-
-
-// For user functions, these are not in the stm32 library
-#define FLASH_ERROR_WRITE         (-1)
-#define FLASH_ERROR_WRITE_LIMIT   (-2)
-#define FLASH_ERROR_ERASE         (-3)
-#define FLASH_ERROR_ERASE_LIMIT   (-4)
-
-
-
-/**
-  * @brief  Returns the FLASH Bank1 Status.
-  * @note   This function can be used for all STM32F10x devices, it is equivalent
-  *         to FLASH_GetStatus function.
-  * @param  None
-  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
-  *         FLASH_ERROR_WRP or FLASH_COMPLETE
-  */
-
-FLASH_Status FLASH_GetBank1Status(void)
-{
-  FLASH_Status flashstatus = FLASH_COMPLETE;
-  FLASH_TypeDef   *f = FLASH;
-  long      tmp;
-
-  tmp = f->SR;
-
-  if((tmp & FLASH_FLAG_BANK1_BSY) == FLASH_FLAG_BSY)
-  {
-    flashstatus = FLASH_BUSY;
-  }
-  else
-  {
-    if((tmp & FLASH_FLAG_BANK1_PGERR) != 0)
-    {
-      flashstatus = FLASH_ERROR_PG;
-    }
-    else
-    {
-      if((tmp & FLASH_FLAG_BANK1_WRPRTERR) != 0 )
-      {
-        flashstatus = FLASH_ERROR_WRP;
-      }
-      else
-      {
-        flashstatus = FLASH_COMPLETE;
-      }
-    }
-  }
-  /* Return the Flash Status */
-  return flashstatus;
-}
-
-/**
-  * @brief  Waits for a Flash operation to complete or a TIMEOUT to occur.
-  * @note   This function can be used for all STM32F10x devices,
-  *         it is equivalent to FLASH_WaitForLastBank1Operation.
-  *         - For STM32F10X_XL devices this function waits for a Bank1 Flash operation
-  *           to complete or a TIMEOUT to occur.
-  *         - For all other devices it waits for a Flash operation to complete
-  *           or a TIMEOUT to occur.
-  * @param  Timeout: FLASH programming Timeout
-  * @retval FLASH Status: The returned value can be: FLASH_ERROR_PG,
-  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
-  */
-
-FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout)
-{
-  FLASH_Status status = FLASH_COMPLETE;
-
-  /* Check for the Flash Status */
-  status = FLASH_GetBank1Status();
-  /* Wait for a Flash operation to complete or a TIMEOUT to occur */
-  while((status == FLASH_BUSY) && (Timeout != 0x00))
-  {
-    status = FLASH_GetBank1Status();
-    Timeout--;
-  }
-  if(Timeout == 0x00 )
-  {
-    status = FLASH_TIMEOUT;
-  }
-  /* Return the operation status */
-  return status;
-}
-
-/**
-  * @brief  Erases a specified FLASH page.
-  * @note   This function can be used for all STM32F10x devices.
-  * @param  Page_Address: The page address to be erased.
-  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
-  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
-  */
-FLASH_Status FLASH_ErasePage(uint32_t Page_Address)
-{
-  FLASH_Status status = FLASH_COMPLETE;
-  FLASH_TypeDef   *f = FLASH;
-
-  /* Wait for last operation to be completed */
-  status = FLASH_WaitForLastOperation(EraseTimeout);
-
-  if(status == FLASH_COMPLETE)
-  {
-    /* if the previous operation is completed, proceed to erase the page */
-    f->CR |= CR_PER_Set;
-    f->AR  = Page_Address;
-    f->CR |= CR_STRT_Set;
-
-    /* Wait for last operation to be completed */
-    status = FLASH_WaitForLastOperation(EraseTimeout);
-
-    /* Disable the PER Bit */
-    f->CR &= CR_PER_Reset;
-  }
-
-  /* Return the Erase Status */
-  return status;
-}
-
-/**
-  * @brief  Clears the FLASH's pending flags.
-  * @note   This function can be used for all STM32F10x devices.
-  *         - For STM32F10X_XL devices, this function clears Bank1 or Bank2s pending flags
-  *         - For other devices, it clears Bank1s pending flags.
-  * @param  FLASH_FLAG: specifies the FLASH flags to clear.
-  *   This parameter can be any combination of the following values:
-  *     @arg FLASH_FLAG_PGERR: FLASH Program error flag
-  *     @arg FLASH_FLAG_WRPRTERR: FLASH Write protected error flag
-  *     @arg FLASH_FLAG_EOP: FLASH End of Operation flag
-  * @retval None
-  */
-void FLASH_ClearFlag(uint32_t FLASH_FLAG)
-{
-    FLASH_TypeDef   *f = FLASH;
-
-    /* Clear the flags */
-    f->SR = FLASH_FLAG;
-}
-
-/**
-  * @brief  Programs a word at a specified address.
-  * @note   This function can be used for all STM32F10x devices.
-  * @param  Address: specifies the address to be programmed.
-  * @param  Data: specifies the data to be programmed.
-  * @retval FLASH Status: The returned value can be: FLASH_ERROR_PG,
-  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
-  */
-
-FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
-{
-  FLASH_Status status = FLASH_COMPLETE;
-  FLASH_TypeDef   *f = FLASH;
-  short *Addr = (short *)Address;
-
-  /* Wait for last operation to be completed */
-  status = FLASH_WaitForLastOperation(ProgramTimeout);
-
-  if(status == FLASH_COMPLETE)
-  {
-    /* if the previous operation is completed, proceed to program the new first
-    half word */
-    f->CR |= CR_PG_Set;
-
-    *Addr = (uint16_t)(Data & 0xFFFF);
-
-    /* Wait for last operation to be completed */
-    status = FLASH_WaitForLastOperation(ProgramTimeout);
-
-    if(status == FLASH_COMPLETE)
-    {
-      /* if the previous operation is completed, proceed to program the new second
-      half word */
-      Addr++;
-
-      *Addr = (uint16_t)(Data >> 16);
-
-      /* Wait for last operation to be completed */
-      status = FLASH_WaitForLastOperation(ProgramTimeout);
-
-      /* Disable the PG Bit */
-      f->CR &= CR_PG_Reset;
-    }
-    else
-    {
-        writeDebugStreamLine("status error %d", status );
-
-      /* Disable the PG Bit */
-      f->CR &= CR_PG_Reset;
-    }
-  }
-
-  /* Return the Program Status */
-  return status;
-}
-
-/**
-  * @brief  Programs a half word at a specified address.
-  * @note   This function can be used for all STM32F10x devices.
-  * @param  Address: specifies the address to be programmed.
-  * @param  Data: specifies the data to be programmed.
-  * @retval FLASH Status: The returned value can be: FLASH_ERROR_PG,
-  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
-  */
-FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data)
-{
-  FLASH_Status status = FLASH_COMPLETE;
-  FLASH_TypeDef   *f = FLASH;
-  short *Addr = (short *)Address;
-
-  /* Wait for last operation to be completed */
-  status = FLASH_WaitForLastOperation(ProgramTimeout);
-
-  if(status == FLASH_COMPLETE)
-  {
-    /* if the previous operation is completed, proceed to program the new first
-    half word */
-    f->CR |= CR_PG_Set;
-
-    *Addr = Data;
-
-    /* Wait for last operation to be completed */
-    status = FLASH_WaitForLastOperation(ProgramTimeout);
-
-    /* Disable the PG Bit */
-    f->CR &= CR_PG_Reset;
-  }
-
-  /* Return the Program Status */
-  return status;
-}
-
-
-
-/**
-  * @brief  Unlocks the FLASH Bank1 Program Erase Controller.
-  * @note   This function can be used for all STM32F10x devices.
-  *         - For STM32F10X_XL devices this function unlocks Bank1.
-  *         - For all other devices it unlocks Bank1 and it is
-  *           equivalent to FLASH_Unlock function.
-  * @param  None
-  * @retval None
-  */
-
-void FLASH_UnlockBank1(void)
-{
-  FLASH_TypeDef   *f = FLASH;
-
-  /* Authorize the FPEC of Bank1 Access */
-  f->KEYR = FLASH_KEY1;
-  f->KEYR = FLASH_KEY2;
-}
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        Copyright (c) James Pearman                          */
+/*                                 2012-2014                                   */
+/*                            All Rights Reserved                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    Module:     stm32_flash.c                                                */
+/*    Author:     James Pearman                                                */
+/*    Created:    21 August 2012                                               */
+/*                                                                             */
+/*    Revisions:                                                               */
+/*                V1.00     7 Jan 2014 - Initial release                       */
+/*                V1.01    17 Oct 2026 - Add FLASH_ProgramBuffer               */
+/*                V1.02    17 Oct 2026 - Time based wait for last operation    */
+/*                V1.03    17 Oct 2026 - Add FLASH_TRACE operation timing      */
+/*                V1.04    17 Oct 2026 - Add FLASH_VerifyBuffer                */
+/*                V1.05    17 Oct 2026 - Add controller lock                   */
+/*                V1.06    17 Oct 2026 - Return lock status, nested hogCPU     */
+/*                V1.07    17 Oct 2026 - Rename the lock to a mutex            */
+/*                V1.08    17 Oct 2026 - Check BSY again after a timeout       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*    The author is supplying this software for use with the VEX cortex        */
+/*    control system. this is free software; you can redistribute it           */
+/*    and/or modify it under the terms of the GNU General Public License       */
+/*    as published by the Free Software Foundation; either version 3 of        */
+/*    the License, or (at your option) any later version.                      */
+/*                                                                             */
+/*    This software is distributed in the hope that it will be useful,         */
+/*    but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*    GNU General Public License for more details.                             */
+/*                                                                             */
+/*    You should have received a copy of the GNU General Public License        */
+/*    along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*                                                                             */
+/*    The author can be contacted on the vex forums as jpearman                */
+/*    or electronic mail using jbpearman_at_mac_dot_com                        */
+/*    Mentor for team 8888 RoboLancers, Pasadena CA.                           */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*        Description:                                                         */
+/*                                                                             */
+/*        ROBOTC port of stm32 peripheral library                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+typedef unsigned long  uint32_t;
+typedef unsigned short uint16_t;
+
+typedef struct
+{
+    uint32_t ACR;
+    uint32_t KEYR;
+    uint32_t OPTKEYR;
+    uint32_t SR;
+    uint32_t CR;
+    uint32_t AR;
+    uint32_t RESERVED;
+    uint32_t OBR;
+    uint32_t WRPR;
+} FLASH_TypeDef;
+
+#define FLASH_BASE                  (0x08000000)        /*!< FLASH base address in the alias region */
+#define SRAM_BASE                   (0x20000000)        /*!< SRAM base address in the alias region */
+#define PERIPH_BASE                 (0x40000000)        /*!< Peripheral base address in the alias region */
+#define APB1PERIPH_BASE             PERIPH_BASE
+#define APB2PERIPH_BASE             (PERIPH_BASE + 0x10000)
+#define AHBPERIPH_BASE              (PERIPH_BASE + 0x20000)
+#define FLASH_R_BASE                (AHBPERIPH_BASE + 0x2000) /*!< Flash registers base address */
+#define FLASH                       ((FLASH_TypeDef *) FLASH_R_BASE)
+
+#define FLASH_FLAG_BSY              (0x00000001)        /*!< FLASH Busy flag */
+#define FLASH_FLAG_EOP              (0x00000020)        /*!< FLASH End of Operation flag */
+#define FLASH_FLAG_PGERR            (0x00000004)        /*!< FLASH Program error flag */
+#define FLASH_FLAG_WRPRTERR         (0x00000010)        /*!< FLASH Write protected error flag */
+#define FLASH_FLAG_OPTERR           (0x00000001)        /*!< FLASH Option Byte error flag */
+
+#define FLASH_FLAG_BANK1_BSY        FLASH_FLAG_BSY      /*!< FLASH BANK1 Busy flag*/
+#define FLASH_FLAG_BANK1_EOP        FLASH_FLAG_EOP      /*!< FLASH BANK1 End of Operation flag */
+#define FLASH_FLAG_BANK1_PGERR      FLASH_FLAG_PGERR    /*!< FLASH BANK1 Program error flag */
+#define FLASH_FLAG_BANK1_WRPRTERR   FLASH_FLAG_WRPRTERR /*!< FLASH BANK1 Write protected error flag */
+
+#define IS_FLASH_CLEAR_FLAG(FLAG)   ((((FLAG) & (uint32_t)0xFFFFFFCA) == 0x00000000) && ((FLAG) != 0x00000000))
+#define IS_FLASH_GET_FLAG(FLAG)       ((FLAG) == FLASH_FLAG_BSY) || ((FLAG) == FLASH_FLAG_EOP) || \
+                                      ((FLAG) == FLASH_FLAG_PGERR) || ((FLAG) == FLASH_FLAG_WRPRTERR) || \
+								      ((FLAG) == FLASH_FLAG_BANK1_BSY) || ((FLAG) == FLASH_FLAG_BANK1_EOP) || \
+                                      ((FLAG) == FLASH_FLAG_BANK1_PGERR) || ((FLAG) == FLASH_FLAG_BANK1_WRPRTERR) || \
+                                      ((FLAG) == FLASH_FLAG_OPTERR))
+
+/** @defgroup FLASH_Private_Defines
+  * @{
+  */
+
+/* Flash Access Control Register bits */
+#define ACR_LATENCY_Mask            (0x00000038)
+#define ACR_HLFCYA_Mask             (0xFFFFFFF7)
+#define ACR_PRFTBE_Mask             (0xFFFFFFEF)
+
+/* Flash Access Control Register bits */
+#define ACR_PRFTBS_Mask             (0x00000020)
+
+/* Flash Control Register bits */
+#define CR_PG_Set                   (0x00000001)
+#define CR_PG_Reset                 (0x00001FFE)
+#define CR_PER_Set                  (0x00000002)
+#define CR_PER_Reset                (0x00001FFD)
+#define CR_MER_Set                  (0x00000004)
+#define CR_MER_Reset                (0x00001FFB)
+#define CR_OPTPG_Set                (0x00000010)
+#define CR_OPTPG_Reset              (0x00001FEF)
+#define CR_OPTER_Set                (0x00000020)
+#define CR_OPTER_Reset              (0x00001FDF)
+#define CR_STRT_Set                 (0x00000040)
+#define CR_LOCK_Set                 (0x00000080)
+
+/* FLASH Mask */
+#define RDPRT_Mask                  (0x00000002)
+#define WRP0_Mask                   (0x000000FF)
+#define WRP1_Mask                   (0x0000FF00)
+#define WRP2_Mask                   (0x00FF0000)
+#define WRP3_Mask                   (0xFF000000)
+#define OB_USER_BFB2                ((uint16_t)0x0008)
+
+/* FLASH Keys */
+#define RDP_Key                     ((uint16_t)0x00A5)
+#define FLASH_KEY1                  (0x45670123)
+#define FLASH_KEY2                  (0xCDEF89AB)
+
+/* FLASH BANK address */
+#define FLASH_BANK1_END_ADDRESS     (0x807FFFF)
+
+/* Timeouts in mS, nSysTime has 1mS resolution so the actual timeout can be
+   up to 1mS longer.  Page erase takes up to 40mS, programming up to 70uS. */
+#define EraseTimeout                (40)
+#define ProgramTimeout              (1)
+
+/* Waits with a longer timeout than this let other tasks run */
+#define YieldTimeout                (ProgramTimeout)
+
+/* Longest wait for another task to finish with the controller, an erase
+   holds it for up to EraseTimeout */
+#define MutexTimeout                (100)
+
+// V4 changed the way enums are handled
+#if kRobotCVersionNumeric < 400
+typedef enum
+#else
+typedef enum _FLASH_Status
+#endif
+{
+  FLASH_BUSY = 1,
+  FLASH_ERROR_PG,
+  FLASH_ERROR_WRP,
+  FLASH_COMPLETE,
+  FLASH_TIMEOUT
+}FLASH_Status;
+
+
+// For user functions, these are not in the stm32 library
+#define FLASH_ERROR_WRITE         (-1)
+#define FLASH_ERROR_WRITE_LIMIT   (-2)
+#define FLASH_ERROR_ERASE         (-3)
+#define FLASH_ERROR_ERASE_LIMIT   (-4)
+
+#ifdef FLASH_TRACE
+/* Operation timing, define FLASH_TRACE before including FlashLib.h.  Each
+   traced function records a count, errors, min, max and total uS and a
+   histogram with bucket n holding times of 2^n to 2^(n+1)-1 uS, bucket 0
+   also holds 0 uS and the last bucket everything longer.  Nothing is
+   compiled in without FLASH_TRACE. */
+#define FLASH_TRACE_HALFWORD      0
+#define FLASH_TRACE_WORD          1
+#define FLASH_TRACE_BUFFER        2
+#define FLASH_TRACE_ERASE         3
+#define FLASH_TRACE_WAIT          4
+#define FLASH_TRACE_OPS           5
+
+#define FLASH_TRACE_BUCKETS       16
+
+typedef struct _flash_trace {
+  unsigned long count;
+  unsigned long errors;
+           long min;
+           long max;
+  unsigned long total;
+  FLASH_Status  last_error;
+  unsigned long hist[FLASH_TRACE_BUCKETS];
+} flash_trace;
+
+static flash_trace flash_trace_ops[FLASH_TRACE_OPS];
+
+/**
+  * @brief  Returns a free running uS clock for tracing.
+  * @note   Not in the stm32 library.  SysTick counts down from LOAD to 0
+  *         once each mS, the count since the last tick is added to nSysTime.
+  *         Define FLASH_TRACE_CLOCK() to use a different clock.
+  * @param  None
+  * @retval Time in uS, it wraps so only differences are meaningful.
+  */
+
+#ifndef FLASH_TRACE_CLOCK
+static long FLASH_TraceClock(void)
+{
+  unsigned long  *st;
+  long  tmp = 0xE000E010;
+  long  ms, load, val;
+
+  st = (unsigned long *)tmp;
+
+  /* read the count again if the tick happened in between */
+  do {
+    ms  = nSysTime;
+    val = st[2];
+  } while( ms != nSysTime );
+
+  load = st[1] + 1;
+
+  return( ms * 1000 + ((load - val) * 1000) / load );
+}
+#define FLASH_TRACE_CLOCK()       FLASH_TraceClock()
+#endif
+
+/**
+  * @brief  Adds one operation to the trace.
+  * @param  op: FLASH_TRACE_xxx
+  * @param  start: FLASH_TRACE_CLOCK() when the operation started
+  * @param  status: status returned by the operation
+  * @retval None
+  */
+
+static void FLASH_TraceAdd(int op, long start, FLASH_Status status)
+{
+  flash_trace *t = &flash_trace_ops[op];
+  long  us = FLASH_TRACE_CLOCK() - start;
+  long  v;
+  int   b;
+
+  if( us < 0 )
+    us = 0;
+
+  if( t->count == 0 || us < t->min )
+    t->min = us;
+  if( us > t->max )
+    t->max = us;
+  t->count++;
+  t->total += us;
+
+  if( status != FLASH_COMPLETE )
+  {
+    t->errors++;
+    t->last_error = status;
+  }
+
+  /* log2 bucket */
+  for( b = 0, v = us; (v > 1) && (b < FLASH_TRACE_BUCKETS - 1); b++ )
+    v >>= 1;
+  t->hist[b]++;
+}
+
+/**
+  * @brief  Clears the trace.
+  * @param  None
+  * @retval None
+  */
+
+void FLASH_TraceClear(void)
+{
+  memset( flash_trace_ops, 0, sizeof(flash_trace_ops) );
+}
+
+/**
+  * @brief  Prints the trace in the debug stream.
+  * @note   One line for each operation then the non empty histogram buckets
+  *         as lower bound in uS and count.
+  * @param  None
+  * @retval None
+  */
+
+void FLASH_TraceDebug(void)
+{
+  flash_trace *t;
+  int   op, b;
+
+  writeDebugStreamLine("op         count  errors  min uS  max uS mean uS");
+
+  for( op = 0; op < FLASH_TRACE_OPS; op++ )
+  {
+    t = &flash_trace_ops[op];
+
+    if( op == FLASH_TRACE_HALFWORD ) writeDebugStream("halfword ");
+    if( op == FLASH_TRACE_WORD )     writeDebugStream("word     ");
+    if( op == FLASH_TRACE_BUFFER )   writeDebugStream("buffer   ");
+    if( op == FLASH_TRACE_ERASE )    writeDebugStream("erase    ");
+    if( op == FLASH_TRACE_WAIT )     writeDebugStream("wait     ");
+
+    writeDebugStreamLine("%7d %7d %7d %7d %7d", t->count, t->errors, t->min, t->max,
+      t->count ? t->total / t->count : 0 );
+
+    for( b = 0; b < FLASH_TRACE_BUCKETS; b++ )
+    {
+      if( t->hist[b] != 0 )
+        writeDebugStreamLine("    %6d %7d", b ? ((long)1 << b) : 0, t->hist[b] );
+    }
+
+    /* allow debugger to empty buffer */
+    wait1Msec(5);
+  }
+}
+#endif
+
+
+
+/* Controller mutex.  Each FLASH_ function that writes a controller register
+   holds the mutex for the whole operation so that tasks cannot interleave
+   unlock, PG or PER sequences or clear each other's flags.  Reading flash
+   does not take the mutex.  ROBOTC has no task id so the mutex is not
+   recursive, it must not be held when calling the FLASH_ functions. */
+static short flash_mutex = 0;
+
+/* hogCPU does not nest, the first releaseCPU lets other tasks run.  Code
+   that holds the CPU around FLASH_ calls uses FLASH_HogCPU instead so the
+   test and set in FLASH_MutexTryTake does not end it early. */
+static short flash_hog = 0;
+
+/**
+  * @brief  Stops other tasks running, calls may be nested.
+  * @note   Not in the stm32 library.
+  * @param  None
+  * @retval None
+  */
+void FLASH_HogCPU(void)
+{
+  if( flash_hog++ == 0 )
+    hogCPU();
+}
+
+/**
+  * @brief  Ends a FLASH_HogCPU, other tasks run after the outermost call.
+  * @note   Not in the stm32 library.
+  * @param  None
+  * @retval None
+  */
+void FLASH_ReleaseCPU(void)
+{
+  if( (flash_hog > 0) && (--flash_hog == 0) )
+    releaseCPU();
+}
+
+/**
+  * @brief  Takes the controller mutex if it is free.
+  * @note   Not in the stm32 library.  Does not wait, for time critical tasks
+  *         that would rather skip or queue a write than be held up by an
+  *         erase in another task.  The test and set is done with
+  *         FLASH_HogCPU so a caller holding the CPU keeps it.
+  * @param  None
+  * @retval 1 if the mutex was taken, 0 if another task has it.
+  */
+short FLASH_MutexTryTake(void)
+{
+  short got;
+
+  FLASH_HogCPU();
+  got = !flash_mutex;
+  flash_mutex = 1;
+  FLASH_ReleaseCPU();
+
+  return got;
+}
+
+/**
+  * @brief  Takes the controller mutex, waiting for another task to release it.
+  * @note   Not in the stm32 library.  Other tasks run while waiting.
+  * @param  Timeout: longest wait in mS
+  * @retval FLASH Status: FLASH_COMPLETE when the mutex was taken or
+  *         FLASH_BUSY if another task still has it after Timeout.
+  */
+FLASH_Status FLASH_MutexTake(uint32_t Timeout)
+{
+  long  start = nSysTime;
+
+  while( !FLASH_MutexTryTake() )
+  {
+    if( (nSysTime - start) > Timeout )
+      return FLASH_BUSY;
+
+    wait1Msec(1);
+  }
+
+  return FLASH_COMPLETE;
+}
+
+/**
+  * @brief  Releases the controller mutex.
+  * @note   Not in the stm32 library.
+  * @param  None
+  * @retval None
+  */
+void FLASH_MutexGive(void)
+{
+  flash_mutex = 0;
+}
+
+/**
+  * @brief  Checks the controller mutex without taking it.
+  * @note   Not in the stm32 library.
+  * @param  None
+  * @retval 1 if a task has the mutex.
+  */
+short FLASH_MutexHeld(void)
+{
+  return flash_mutex;
+}
+
+/**
+  * @brief  Returns the FLASH Bank1 Status.
+  * @note   This function can be used for all STM32F10x devices, it is equivalent
+  *         to FLASH_GetStatus function.
+  * @param  None
+  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP or FLASH_COMPLETE
+  */
+
+FLASH_Status FLASH_GetBank1Status(void)
+{
+  FLASH_Status flashstatus = FLASH_COMPLETE;
+  FLASH_TypeDef   *f = FLASH;
+  long      tmp;
+
+  tmp = f->SR;
+
+  if((tmp & FLASH_FLAG_BANK1_BSY) == FLASH_FLAG_BSY)
+  {
+    flashstatus = FLASH_BUSY;
+  }
+  else
+  {
+    if((tmp & FLASH_FLAG_BANK1_PGERR) != 0)
+    {
+      flashstatus = FLASH_ERROR_PG;
+    }
+    else
+    {
+      if((tmp & FLASH_FLAG_BANK1_WRPRTERR) != 0 )
+      {
+        flashstatus = FLASH_ERROR_WRP;
+      }
+      else
+      {
+        flashstatus = FLASH_COMPLETE;
+      }
+    }
+  }
+  /* Return the Flash Status */
+  return flashstatus;
+}
+
+/**
+  * @brief  Waits for a Flash operation to complete or a TIMEOUT to occur.
+  * @note   This function can be used for all STM32F10x devices,
+  *         it is equivalent to FLASH_WaitForLastBank1Operation.
+  *         - For STM32F10X_XL devices this function waits for a Bank1 Flash operation
+  *           to complete or a TIMEOUT to occur.
+  *         - For all other devices it waits for a Flash operation to complete
+  *           or a TIMEOUT to occur.
+  * @note   Changed from the stm32 library, the timeout is in mS measured with
+  *         nSysTime rather than a loop count.  Waits longer than YieldTimeout,
+  *         page erase, let other tasks run, program waits are a busy loop.
+  * @param  Timeout: FLASH operation Timeout in mS
+  * @retval FLASH Status: The returned value can be: FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
+  */
+
+FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout)
+{
+  FLASH_Status status = FLASH_COMPLETE;
+  long  start = nSysTime;
+#ifdef FLASH_TRACE
+  long  trace_t0 = FLASH_TRACE_CLOCK();
+#endif
+
+  /* Wait for a Flash operation to complete or a TIMEOUT to occur */
+  while((status = FLASH_GetBank1Status()) == FLASH_BUSY)
+  {
+    /* more than Timeout mS have gone by, the task may have been preempted
+       for all of them so look at BSY once more */
+    if( (nSysTime - start) > Timeout )
+    {
+      if( (status = FLASH_GetBank1Status()) == FLASH_BUSY )
+        status = FLASH_TIMEOUT;
+      break;
+    }
+
+    /* let other tasks run */
+    if( Timeout > YieldTimeout )
+      abortTimeslice();
+  }
+
+#ifdef FLASH_TRACE
+  FLASH_TraceAdd( FLASH_TRACE_WAIT, trace_t0, status );
+#endif
+
+  /* Return the operation status */
+  return status;
+}
+
+/**
+  * @brief  Erases a specified FLASH page.
+  * @note   This function can be used for all STM32F10x devices.
+  * @param  Page_Address: The page address to be erased.
+  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
+  */
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address)
+{
+  FLASH_Status status = FLASH_COMPLETE;
+  FLASH_TypeDef   *f = FLASH;
+#ifdef FLASH_TRACE
+  long  trace_t0 = FLASH_TRACE_CLOCK();
+#endif
+
+  /* Another task has the controller */
+  if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+    return FLASH_BUSY;
+
+  /* Wait for last operation to be completed */
+  status = FLASH_WaitForLastOperation(EraseTimeout);
+
+  if(status == FLASH_COMPLETE)
+  {
+    /* if the previous operation is completed, proceed to erase the page */
+    f->CR |= CR_PER_Set;
+    f->AR  = Page_Address;
+    f->CR |= CR_STRT_Set;
+
+    /* Wait for last operation to be completed */
+    status = FLASH_WaitForLastOperation(EraseTimeout);
+
+    /* Disable the PER Bit */
+    f->CR &= CR_PER_Reset;
+  }
+
+  FLASH_MutexGive();
+
+#ifdef FLASH_TRACE
+  FLASH_TraceAdd( FLASH_TRACE_ERASE, trace_t0, status );
+#endif
+
+  /* Return the Erase Status */
+  return status;
+}
+
+/**
+  * @brief  Clears the FLASH's pending flags.
+  * @note   This function can be used for all STM32F10x devices.
+  *         - For STM32F10X_XL devices, this function clears Bank1 or Bank2s pending flags
+  *         - For other devices, it clears Bank1s pending flags.
+  * @param  FLASH_FLAG: specifies the FLASH flags to clear.
+  *   This parameter can be any combination of the following values:
+  *     @arg FLASH_FLAG_PGERR: FLASH Program error flag
+  *     @arg FLASH_FLAG_WRPRTERR: FLASH Write protected error flag
+  *     @arg FLASH_FLAG_EOP: FLASH End of Operation flag
+  * @retval FLASH Status: FLASH_COMPLETE or FLASH_BUSY if another task has
+  *         the controller mutex.
+  */
+FLASH_Status FLASH_ClearFlag(uint32_t FLASH_FLAG)
+{
+    FLASH_TypeDef   *f = FLASH;
+
+    /* Not while another task's operation is using them */
+    if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+      return FLASH_BUSY;
+
+    /* Clear the flags */
+    f->SR = FLASH_FLAG;
+
+    FLASH_MutexGive();
+
+    return FLASH_COMPLETE;
+}
+
+/**
+  * @brief  Programs a word at a specified address.
+  * @note   This function can be used for all STM32F10x devices.
+  * @param  Address: specifies the address to be programmed.
+  * @param  Data: specifies the data to be programmed.
+  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
+  */
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+  FLASH_Status status = FLASH_COMPLETE;
+  FLASH_TypeDef   *f = FLASH;
+  short *Addr = (short *)Address;
+#ifdef FLASH_TRACE
+  long  trace_t0 = FLASH_TRACE_CLOCK();
+#endif
+
+  /* Another task has the controller */
+  if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+    return FLASH_BUSY;
+
+  /* Wait for last operation to be completed */
+  status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+  if(status == FLASH_COMPLETE)
+  {
+    /* if the previous operation is completed, proceed to program the new first
+    half word */
+    f->CR |= CR_PG_Set;
+
+    *Addr = (uint16_t)(Data & 0xFFFF);
+
+    /* Wait for last operation to be completed */
+    status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+    if(status == FLASH_COMPLETE)
+    {
+      /* if the previous operation is completed, proceed to program the new second
+      half word */
+      Addr++;
+
+      *Addr = (uint16_t)(Data >> 16);
+
+      /* Wait for last operation to be completed */
+      status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+      /* Disable the PG Bit */
+      f->CR &= CR_PG_Reset;
+    }
+    else
+    {
+        writeDebugStreamLine("status error %d", status );
+
+      /* Disable the PG Bit */
+      f->CR &= CR_PG_Reset;
+    }
+  }
+
+  FLASH_MutexGive();
+
+#ifdef FLASH_TRACE
+  FLASH_TraceAdd( FLASH_TRACE_WORD, trace_t0, status );
+#endif
+
+  /* Return the Program Status */
+  return status;
+}
+
+/**
+  * @brief  Programs a half word at a specified address.
+  * @note   This function can be used for all STM32F10x devices.
+  * @param  Address: specifies the address to be programmed.
+  * @param  Data: specifies the data to be programmed.
+  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
+  */
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data)
+{
+  FLASH_Status status = FLASH_COMPLETE;
+  FLASH_TypeDef   *f = FLASH;
+  short *Addr = (short *)Address;
+#ifdef FLASH_TRACE
+  long  trace_t0 = FLASH_TRACE_CLOCK();
+#endif
+
+  /* Another task has the controller */
+  if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+    return FLASH_BUSY;
+
+  /* Wait for last operation to be completed */
+  status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+  if(status == FLASH_COMPLETE)
+  {
+    /* if the previous operation is completed, proceed to program the new first
+    half word */
+    f->CR |= CR_PG_Set;
+
+    *Addr = Data;
+
+    /* Wait for last operation to be completed */
+    status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+    /* Disable the PG Bit */
+    f->CR &= CR_PG_Reset;
+  }
+
+  FLASH_MutexGive();
+
+#ifdef FLASH_TRACE
+  FLASH_TraceAdd( FLASH_TRACE_HALFWORD, trace_t0, status );
+#endif
+
+  /* Return the Program Status */
+  return status;
+}
+
+
+
+/**
+  * @brief  Programs a buffer of half words starting at a specified address.
+  * @note   Not in the stm32 library.  PG is set once for the whole buffer and
+  *         only the status register is polled between half words, this is
+  *         much faster than calling FLASH_ProgramHalfWord for each one.
+  * @param  Address: specifies the address to be programmed.
+  * @param  Data: pointer to the half words to be programmed.
+  * @param  NumHalfWords: number of half words to program.
+  * @param  FailAddress: if not NULL, set to the address of the first half
+  *         word that could not be programmed when an error occurs.
+  * @retval FLASH Status: The returned value can be: FLASH_BUSY, FLASH_ERROR_PG,
+  *         FLASH_ERROR_WRP, FLASH_COMPLETE or FLASH_TIMEOUT.
+  */
+FLASH_Status FLASH_ProgramBuffer(uint32_t Address, uint16_t *Data, int NumHalfWords, uint32_t *FailAddress)
+{
+  FLASH_Status status = FLASH_COMPLETE;
+  FLASH_TypeDef   *f = FLASH;
+  short *Addr = (short *)Address;
+  long      start;
+  long      tmp;
+  int       i;
+#ifdef FLASH_TRACE
+  long  trace_t0 = FLASH_TRACE_CLOCK();
+#endif
+
+  /* Another task has the controller */
+  if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+  {
+    if(FailAddress != NULL)
+      *FailAddress = Address;
+    return FLASH_BUSY;
+  }
+
+  /* Wait for last operation to be completed */
+  status = FLASH_WaitForLastOperation(ProgramTimeout);
+
+  if(status == FLASH_COMPLETE)
+  {
+    /* PG stays set for the whole buffer */
+    f->CR |= CR_PG_Set;
+
+    for(i=0;i<NumHalfWords;i++)
+    {
+      *Addr = *Data++;
+
+      /* Wait for BSY to clear, errors are in the same read of SR */
+      start = nSysTime;
+      while(((tmp = f->SR) & FLASH_FLAG_BSY) != 0)
+      {
+        if( (nSysTime - start) > ProgramTimeout )
+        {
+          /* BSY may have cleared while this task was not running */
+          tmp = f->SR;
+          break;
+        }
+      }
+
+      if((tmp & FLASH_FLAG_BSY) != 0)
+      {
+        status = FLASH_TIMEOUT;
+        break;
+      }
+      if((tmp & FLASH_FLAG_PGERR) != 0)
+      {
+        status = FLASH_ERROR_PG;
+        break;
+      }
+      if((tmp & FLASH_FLAG_WRPRTERR) != 0)
+      {
+        status = FLASH_ERROR_WRP;
+        break;
+      }
+
+      Addr++;
+    }
+
+    /* Disable the PG Bit */
+    f->CR &= CR_PG_Reset;
+  }
+
+  /* Report where programming stopped */
+  if((status != FLASH_COMPLETE) && (FailAddress != NULL))
+    *FailAddress = (uint32_t)Addr;
+
+  FLASH_MutexGive();
+
+#ifdef FLASH_TRACE
+  FLASH_TraceAdd( FLASH_TRACE_BUFFER, trace_t0, status );
+#endif
+
+  /* Return the Program Status */
+  return status;
+}
+
+/**
+  * @brief  Compares flash with the data that was programmed.
+  * @note   Not in the stm32 library.  When the flash address and the data
+  *         are both word aligned 32 bits are compared at a time, otherwise
+  *         16 or 8 bits.  Much faster than comparing bytes in user code.
+  * @param  Address: address of the data in flash.
+  * @param  Data: pointer to what should be in flash.
+  * @param  NumBytes: number of bytes to compare.
+  * @param  FailAddress: if not NULL, set to the address of the first byte
+  *         that is different.
+  * @retval FLASH Status: FLASH_COMPLETE if the flash matches, otherwise
+  *         FLASH_ERROR_PG.
+  */
+FLASH_Status FLASH_VerifyBuffer(uint32_t Address, unsigned char *Data, long NumBytes, uint32_t *FailAddress)
+{
+  unsigned char  *p = (unsigned char *)Address;
+  unsigned long  *pw, *dw;
+  unsigned short *ph, *dh;
+  long      align = (long)Data;
+  long      i = 0;
+
+  align = (align | Address) & 3;
+
+  if( align == 0 )
+  {
+    /* word at a time */
+    pw = (unsigned long *)Address;
+    dw = (unsigned long *)Data;
+    for( ; (i + 4) <= NumBytes; i += 4 )
+    {
+      if( *pw++ != *dw++ )
+        break;
+    }
+  }
+  else
+  if( (align & 1) == 0 )
+  {
+    /* half word at a time */
+    ph = (unsigned short *)Address;
+    dh = (unsigned short *)Data;
+    for( ; (i + 2) <= NumBytes; i += 2 )
+    {
+      if( *ph++ != *dh++ )
+        break;
+    }
+  }
+
+  /* the bytes left over, or the byte that is different */
+  for( ; i < NumBytes; i++ )
+  {
+    if( p[i] != Data[i] )
+    {
+      if( FailAddress != NULL )
+        *FailAddress = Address + i;
+      return FLASH_ERROR_PG;
+    }
+  }
+
+  return FLASH_COMPLETE;
+}
+
+/**
+  * @brief  Unlocks the FLASH Bank1 Program Erase Controller.
+  * @note   This function can be used for all STM32F10x devices.
+  *         - For STM32F10X_XL devices this function unlocks Bank1.
+  *         - For all other devices it unlocks Bank1 and it is
+  *           equivalent to FLASH_Unlock function.
+  * @param  None
+  * @retval FLASH Status: FLASH_COMPLETE or FLASH_BUSY if another task has
+  *         the controller mutex.
+  */
+
+FLASH_Status FLASH_UnlockBank1(void)
+{
+  FLASH_TypeDef   *f = FLASH;
+
+  /* An interleaved key sequence locks the FPEC until reset */
+  if( FLASH_MutexTake(MutexTimeout) != FLASH_COMPLETE )
+    return FLASH_BUSY;
+
+  /* Authorize the FPEC of Bank1 Access */
+  f->KEYR = FLASH_KEY1;
+  f->KEYR = FLASH_KEY2;
+
+  FLASH_MutexGive();
+
+  return FLASH_COMPLETE;
+}